@@ -0,0 +1,733 @@
+/******************************************************************************
+* <bench.c>
+* Bailey Jia-Tao Brown
+* 2021
+*
+*	Microbenchmarks for each part of the renderer
+*	Contents:
+*		- Preprocessor defs
+*		- Includes
+*		- Definitions
+*		- Bench data
+*		- Helper functions
+*		- Benchmarks
+*		- Golden scenes
+*		- Report functions
+*		- Golden image functions
+*		- Entry point
+*
+*	Usage:
+*		VGBench [-n items] [-size pixels] [-repeats count] [-only name]
+*			[-csv results.csv]
+*		VGBench -golden dir [-update] [-tolerance value] [-allow pixels]
+*			[-repeats count] [-only name] [-csv results.csv]
+*
+*	Every benchmark does its work on a number of items, -n replaces the
+*	default count of all of them and -size the edge of the textures they
+*	use. Each one runs repeats times and ends every run by reading back a
+*	pixel so GPU work is part of the time. The window is presented
+*	between runs only, never while timing. Results are printed and, with
+*	-csv, written one line per benchmark for regression tracking.
+*
+*	With -golden a fixed set of scenes is drawn instead, timed the same
+*	way and then saved as PNG next to dir/scene.png. A scene passes when
+*	no more than -allow pixels differ from it by more than -tolerance in
+*	any channel, the new image is kept for review when it does not.
+*	-update replaces the golden images, the exit code is 1 on failures.
+*
+******************************************************************************/
+
+/* PREPROCESSOR DEFS */
+#define _CRT_SECURE_NO_WARNINGS
+#define WIN32_LEAN_AND_MEAN
+
+/* INCLUDES */
+#include <stdio.h>  /* I/O */
+#include <stdlib.h> /* Memory allocation and sorting */
+#include <string.h> /* String comparison */
+#include <math.h>   /* Shape points */
+#include <emmintrin.h> /* SSE2 intrinsics */
+
+#include <Windows.h> /* Timers and temporary files */
+
+#include "graphics.h" /* Renderer */
+
+/* DEFINITIONS */
+#define WINDOW_W     800
+#define WINDOW_H     600
+#define RESOLUTION_W 400
+#define RESOLUTION_H 300
+#define REPEATS_DEFAULT 0x10
+#define SHAPE_POINTS    0x20
+#define CHECKER_SIZE    0x40
+#define TOLERANCE_DEFAULT 2
+
+typedef struct benchInfo
+{
+	const char* name;
+	int count; /* items per run unless -n is given */
+	void (*run)(int count);
+} benchInfo;
+
+/* BENCH DATA */
+static int _size = 0x100;
+static unsigned int _seed = 1;
+static volatile int _sink = 0;
+static long long _freq;
+
+static vgTexture _tex = VG_INVALID;
+static vgShape _shape = VG_INVALID;
+static vgShape _shapeTextured = VG_INVALID;
+static unsigned char* _texels = NULL;
+static unsigned char* _pixels = NULL;
+static char _tempFile[MAX_PATH];
+
+static vgTexture _checker = VG_INVALID;
+static vgTexture _canvas = VG_INVALID;
+static vgTexture _itex = VG_INVALID;
+
+/* HELPER FUNCTIONS */
+
+/* the same sequence every run, so workloads are identical between builds */
+static float benchRand(void)
+{
+	_seed = _seed * 1664525 + 1013904223;
+	return (_seed >> 8) / (float)(1 << 23) - 1.0f;
+}
+
+static void finish(void)
+{
+	unsigned char pixel[4];
+	vgReadPixels(VG_RENDER_TARGET, 0, 0, 1, 1, VG_FORMAT_RGBA8, pixel, 0);
+}
+
+static int setup(void)
+{
+	_texels = malloc(_size * _size * 4);
+	_pixels = malloc(RESOLUTION_W * RESOLUTION_H * 4);
+	if (_texels == NULL || _pixels == NULL) return 0;
+
+	for (int i = 0; i < _size * _size * 4; i++)
+		_texels[i] = (unsigned char)(i * 7);
+	_tex = vgCreateTexture(_size, _size, VG_NEAREST, VG_FALSE, _texels);
+
+	/* a circle, texture coordinates mapped from its bounding box */
+	float points[SHAPE_POINTS * 2], coords[SHAPE_POINTS * 2];
+	for (int i = 0; i < SHAPE_POINTS; i++)
+	{
+		float a = i * 6.2831853f / SHAPE_POINTS;
+		points[i * 2 + 0] = cosf(a) * 0.1f;
+		points[i * 2 + 1] = sinf(a) * 0.1f;
+		coords[i * 2 + 0] = cosf(a) * 0.5f + 0.5f;
+		coords[i * 2 + 1] = sinf(a) * 0.5f + 0.5f;
+	}
+	_shape = vgCompileShape(points, SHAPE_POINTS);
+	_shapeTextured = vgCompileShapeTextured(points, coords, SHAPE_POINTS);
+
+	char dir[MAX_PATH];
+	GetTempPathA(MAX_PATH, dir);
+	snprintf(_tempFile, MAX_PATH, "%svgbench.tex", dir);
+	return 1;
+}
+
+/* BENCHMARKS */
+
+static void benchRect(int count)
+{
+	vgColor4(200, 120, 40, 255);
+	for (int i = 0; i < count; i++)
+		vgRectf(benchRand(), benchRand(), 0.05f, 0.05f);
+}
+
+static void benchLine(int count)
+{
+	vgColor4(40, 200, 120, 255);
+	vgLineSize(1.0f);
+	for (int i = 0; i < count; i++)
+		vgLinef(benchRand(), benchRand(), benchRand(), benchRand());
+}
+
+static void benchPoint(int count)
+{
+	vgColor4(120, 40, 200, 255);
+	vgPointSize(1.0f);
+	for (int i = 0; i < count; i++)
+		vgPointf(benchRand(), benchRand());
+}
+
+static void benchRectTexture(int count)
+{
+	vgUseTexture(_tex);
+	for (int i = 0; i < count; i++)
+		vgRectTexture(-1 + (i & 1), -1 + ((i >> 1) & 1), 1, 1);
+}
+
+static void benchShape(int count)
+{
+	vgColor4(200, 200, 40, 255);
+	for (int i = 0; i < count; i++)
+		vgDrawShape(_shape, benchRand(), benchRand(), benchRand() * 180.0f,
+			0.5f);
+}
+
+static void benchShapeTextured(int count)
+{
+	vgUseTexture(_tex);
+	for (int i = 0; i < count; i++)
+		vgDrawShapeTextured(_shapeTextured, benchRand(), benchRand(),
+			benchRand() * 180.0f, 0.5f);
+}
+
+static void benchITexCompile(int count)
+{
+	vgITexDataClear();
+	for (int i = 0; i < VG_ITEX_COLORS_MAX; i++)
+		vgITexDataColor(i, i * 16, 255 - i * 16, i * 8, 255);
+
+	for (int i = 0; i < count; i++)
+	{
+		for (int x = 0; x < VG_ITEX_SIZE_MAX; x++)
+			for (int y = 0; y < VG_ITEX_SIZE_MAX; y++)
+				vgITexDataIndex((x + y + i) % VG_ITEX_COLORS_MAX, x, y);
+		vgDestroyTexture(vgITexDataCompile(VG_ITEX_SIZE_MAX,
+			VG_ITEX_SIZE_MAX, VG_FALSE, VG_NEAREST));
+	}
+}
+
+static void benchTextureCreate(int count)
+{
+	for (int i = 0; i < count; i++)
+		vgDestroyTexture(vgCreateTexture(_size, _size, VG_NEAREST, VG_FALSE,
+			_texels));
+}
+
+static void benchTextureCreateNoPool(int count)
+{
+	vgUseTexturePool(VG_FALSE);
+	benchTextureCreate(count);
+	vgUseTexturePool(VG_TRUE);
+}
+
+static void benchReadback(int count)
+{
+	for (int i = 0; i < count; i++)
+		vgReadPixels(VG_RENDER_TARGET, 0, 0, RESOLUTION_W, RESOLUTION_H,
+			VG_FORMAT_RGBA8, _pixels, 0);
+}
+
+static void benchSaveLoad(int count)
+{
+	for (int i = 0; i < count; i++)
+	{
+		vgSaveTexture(_tex, _tempFile, _size, _size);
+		vgDestroyTexture(vgLoadTexture(_tempFile, _size, _size, VG_NEAREST,
+			VG_FALSE));
+	}
+}
+
+static void benchCulling(int count)
+{
+	int visible = 0;
+	for (int i = 0; i < count; i++)
+		visible += vgCheckIfViewable(benchRand() * 2.0f, benchRand() * 2.0f,
+			0.1f);
+	_sink = visible;
+}
+
+static const benchInfo _benches[] = {
+	{ "rect", 20000, benchRect },
+	{ "line", 20000, benchLine },
+	{ "point", 20000, benchPoint },
+	{ "rect_texture", 20000, benchRectTexture },
+	{ "shape", 10000, benchShape },
+	{ "shape_textured", 10000, benchShapeTextured },
+	{ "itex_compile", 50, benchITexCompile },
+	{ "texture_create", 200, benchTextureCreate },
+	{ "texture_create_nopool", 200, benchTextureCreateNoPool },
+	{ "readback", 50, benchReadback },
+	{ "save_load", 20, benchSaveLoad },
+	{ "culling", 1000000, benchCulling },
+};
+#define BENCH_COUNT (sizeof(_benches) / sizeof(_benches[0]))
+
+/* GOLDEN SCENES */
+/* scenes draw back to front with falling layers, so depth never hides */
+/* what is drawn later, and leave state as they found it */
+
+static void goldenSetup(void)
+{
+	unsigned char texels[CHECKER_SIZE * CHECKER_SIZE * 4];
+	for (int y = 0; y < CHECKER_SIZE; y++)
+	{
+		for (int x = 0; x < CHECKER_SIZE; x++)
+		{
+			unsigned char* t = texels + (y * CHECKER_SIZE + x) * 4;
+			int on = ((x >> 3) ^ (y >> 3)) & 1;
+			t[0] = on ? 240 : (unsigned char)(x * 4);
+			t[1] = on ? 240 : (unsigned char)(y * 4);
+			t[2] = on ? 240 : 64;
+			t[3] = (unsigned char)(128 + x * 2);
+		}
+	}
+	_checker = vgCreateTexture(CHECKER_SIZE, CHECKER_SIZE, VG_NEAREST,
+		VG_TRUE, texels);
+	_canvas = vgCreateTexture(CHECKER_SIZE, CHECKER_SIZE, VG_NEAREST,
+		VG_FALSE, NULL);
+
+	vgITexDataClear();
+	for (int i = 0; i < VG_ITEX_COLORS_MAX; i++)
+		vgITexDataColor(i, i * 16, 255 - i * 16, (i * 40) & 0xFF, 255);
+	for (int x = 0; x < VG_ITEX_SIZE_MAX; x++)
+		for (int y = 0; y < VG_ITEX_SIZE_MAX; y++)
+			vgITexDataIndex((x / 4 + y / 8) % VG_ITEX_COLORS_MAX, x, y);
+	_itex = vgITexDataCompile(VG_ITEX_SIZE_MAX, VG_ITEX_SIZE_MAX, VG_FALSE,
+		VG_NEAREST);
+}
+
+static void scenePrimitives(int count)
+{
+	vgFill(20, 24, 40);
+	for (int i = 0; i < 8; i++)
+	{
+		vgRenderLayer((float)(16 - i));
+		vgColor3(i * 32, 255 - i * 32, 128);
+		vgRectf(-0.9f + i * 0.2f, -0.6f, 0.15f, 0.5f);
+	}
+
+	vgRenderLayer(4);
+	vgColor3(255, 255, 255);
+	vgLineSize(2.0f);
+	vgLinef(-0.9f, 0.2f, 0.9f, 0.6f);
+	vgLineSize(1.0f);
+	vgLinef(-0.9f, 0.6f, 0.9f, 0.2f);
+	vgPointSize(4.0f);
+	for (int i = 0; i < 8; i++)
+		vgPointf(-0.8f + i * 0.2f, 0.0f);
+
+	vgPointSize(1.0f);
+	vgRenderLayer(0);
+}
+
+static void sceneBlending(int count)
+{
+	vgFill(0, 0, 0);
+	for (int i = 0; i < 6; i++)
+	{
+		vgRenderLayer((float)(8 - i));
+		vgColor4(255 - i * 40, i * 40, 160, 96);
+		vgRectf(-0.8f + i * 0.15f, -0.5f + i * 0.1f, 0.7f, 0.5f);
+	}
+	vgRenderLayer(0);
+	vgColor4(255, 255, 255, 255);
+}
+
+static void sceneTextured(int count)
+{
+	vgFill(40, 40, 40);
+	vgUseTexture(_checker);
+	vgRenderLayer(3);
+	vgRectTexture(-1, -1, 1, 1);
+	vgRenderLayer(2);
+	vgTextureFilter(255, 128, 64, 200);
+	vgRectTexture(0, -1, 1, 1);
+	vgRenderLayer(1);
+	vgTextureFilterReset();
+	vgRectTextureOffset(-1, 0, 1, 1, 0.25f, 0.5f);
+	vgRenderLayer(0);
+}
+
+static void sceneShapes(int count)
+{
+	vgFill(10, 30, 20);
+	for (int i = 0; i < 6; i++)
+	{
+		vgRenderLayer((float)(12 - i));
+		vgColor3(255, 200 - i * 30, i * 40);
+		vgDrawShape(_shape, -0.75f + i * 0.3f, -0.3f, i * 15.0f,
+			1.0f + i * 0.3f);
+	}
+
+	vgUseTexture(_checker);
+	for (int i = 0; i < 4; i++)
+	{
+		vgRenderLayer((float)(4 - i));
+		vgDrawShapeTextured(_shapeTextured, -0.6f + i * 0.4f, 0.35f,
+			i * 30.0f, 1.5f);
+	}
+	vgRenderLayer(0);
+}
+
+static void sceneITex(int count)
+{
+	vgFill(0, 0, 0);
+	vgUseTexture(_itex);
+	vgRectTexture(-1, -1, 1, 1);
+	vgRectTexture(0, 0, 1, 1);
+}
+
+static void sceneEdit(int count)
+{
+	vgEditTexture(_canvas, CHECKER_SIZE, CHECKER_SIZE);
+	vgEditClear();
+	vgEditColor(255, 0, 0, 255);
+	vgEditRect(4, 4, 24, 16);
+	vgEditColor(0, 255, 0, 255);
+	vgEditLine(0, 63, 63, 0);
+	vgEditColor(0, 0, 255, 255);
+	for (int i = 0; i < 8; i++)
+		vgEditPoint(40 + i * 2, 40);
+
+	vgFill(30, 30, 30);
+	vgUseTexture(_canvas);
+	vgRectTexture(-1, -1, 1, 1);
+}
+
+static void sceneTransform(int count)
+{
+	vgFill(50, 20, 20);
+	vgRenderScale(2.0f);
+	vgRenderOffset(0.5f, 0.25f);
+	vgColor3(255, 255, 0);
+	vgRenderLayer(2);
+	vgRectf(-0.5f, -0.5f, 1.0f, 1.0f);
+
+	vgUseRenderScaling(VG_FALSE);
+	vgUseRenderOffset(VG_FALSE);
+	vgViewport(0, 0, RESOLUTION_W / 2, RESOLUTION_H / 2);
+	vgColor3(0, 200, 255);
+	vgRenderLayer(1);
+	vgRectf(-0.5f, -0.5f, 1.0f, 1.0f);
+
+	vgViewportReset();
+	vgUseRenderScaling(VG_TRUE);
+	vgUseRenderOffset(VG_TRUE);
+	vgRenderScale(1.0f);
+	vgRenderOffset(0, 0);
+	vgRenderLayer(0);
+}
+
+static const benchInfo _scenes[] = {
+	{ "primitives", 1, scenePrimitives },
+	{ "blending", 1, sceneBlending },
+	{ "textured", 1, sceneTextured },
+	{ "shapes", 1, sceneShapes },
+	{ "itex", 1, sceneITex },
+	{ "edit", 1, sceneEdit },
+	{ "transform", 1, sceneTransform },
+};
+#define SCENE_COUNT (sizeof(_scenes) / sizeof(_scenes[0]))
+
+/* REPORT FUNCTIONS */
+
+static int compareTicks(const void* a, const void* b)
+{
+	long long x = *(const long long*)a, y = *(const long long*)b;
+	return (x > y) - (x < y);
+}
+
+static double toMs(long long ticks)
+{
+	return ticks * 1000.0 / _freq;
+}
+
+/* sorted run times, NULL if the window was closed */
+static long long* timeRuns(const benchInfo* bench, int count, int repeats)
+{
+	long long* runs = malloc(repeats * sizeof(long long));
+	if (runs == NULL) return NULL;
+
+	/* one untimed run first so pools and drivers have warmed up */
+	vgClear();
+	bench->run(count);
+	finish();
+
+	LARGE_INTEGER before, after;
+	for (int i = 0; i < repeats; i++)
+	{
+		_seed = 1;
+		vgClear();
+		QueryPerformanceCounter(&before);
+		bench->run(count);
+		finish();
+		QueryPerformanceCounter(&after);
+		runs[i] = after.QuadPart - before.QuadPart;
+
+		vgSwap();
+		vgUpdate();
+		if (vgWindowIsClosed())
+		{
+			free(runs);
+			return NULL;
+		}
+	}
+
+	qsort(runs, repeats, sizeof(long long), compareTicks);
+	return runs;
+}
+
+/* runs one benchmark, returns 0 if the window was closed */
+static int measure(const benchInfo* bench, int count, int repeats,
+	FILE* csv)
+{
+	long long* runs = timeRuns(bench, count, repeats);
+	if (runs == NULL) return 0;
+
+	long long sum = 0;
+	for (int i = 0; i < repeats; i++) sum += runs[i];
+	double mean = toMs(sum) / repeats;
+	double median = toMs(runs[repeats / 2]);
+
+	printf("%-22s %9d %10.3f %10.3f %10.3f %12.1f\n", bench->name, count,
+		toMs(runs[0]), median, mean, median * 1000000.0 / count);
+	if (csv != NULL)
+		fprintf(csv, "%s,%d,%d,%.4f,%.4f,%.4f,%.4f,%.1f\n", bench->name,
+			count, repeats, toMs(runs[0]), median, mean,
+			toMs(runs[repeats - 1]), median * 1000000.0 / count);
+
+	free(runs);
+	return 1;
+}
+
+static void runBenches(int count, int repeats, const char* only, FILE* csv)
+{
+	printf("%d runs each, %dx%d textures, rendering at %dx%d\n\n", repeats,
+		_size, _size, RESOLUTION_W, RESOLUTION_H);
+	printf("%-22s %9s %10s %10s %10s %12s\n", "bench", "items", "min ms",
+		"median ms", "mean ms", "ns per item");
+
+	int ran = 0;
+	for (int i = 0; i < (int)BENCH_COUNT; i++)
+	{
+		const benchInfo* bench = &_benches[i];
+		if (only != NULL && strcmp(only, bench->name) != 0) continue;
+		ran++;
+		if (!measure(bench, count ? count : bench->count, repeats, csv))
+			break;
+	}
+	if (ran == 0) printf("No benchmark is called %s\n", only);
+}
+
+/* GOLDEN IMAGE FUNCTIONS */
+
+static void shotDone(const char* file, int success, void* user)
+{
+	*(int*)user = success;
+}
+
+/* largest channel difference, and pixels where it is above tolerance */
+static int imageDiff(const unsigned char* a, const unsigned char* b,
+	int pixels, int tolerance, int* over)
+{
+	const __m128i limit = _mm_set1_epi8((char)min(tolerance, 255));
+	const __m128i zero = _mm_setzero_si128();
+	__m128i worst = zero;
+	int count = 0, i = 0;
+
+	/* four pixels at a time, a pixel is over if any channel is */
+	for (; i + 4 <= pixels; i += 4)
+	{
+		__m128i x = _mm_loadu_si128((const __m128i*)(a + i * 4));
+		__m128i y = _mm_loadu_si128((const __m128i*)(b + i * 4));
+		__m128i diff = _mm_or_si128(_mm_subs_epu8(x, y), _mm_subs_epu8(y, x));
+		worst = _mm_max_epu8(worst, diff);
+
+		int mask = ~_mm_movemask_epi8(_mm_cmpeq_epi8(
+			_mm_subs_epu8(diff, limit), zero)) & 0xFFFF;
+		count += ((mask & 0x000F) != 0) + ((mask & 0x00F0) != 0) +
+			((mask & 0x0F00) != 0) + ((mask & 0xF000) != 0);
+	}
+
+	unsigned char lanes[16];
+	_mm_storeu_si128((__m128i*)lanes, worst);
+	int largest = 0;
+	for (int l = 0; l < 16; l++) largest = max(largest, lanes[l]);
+
+	for (; i < pixels; i++)
+	{
+		int pixelWorst = 0;
+		for (int c = 0; c < 4; c++)
+			pixelWorst = max(pixelWorst, abs(a[i * 4 + c] - b[i * 4 + c]));
+		largest = max(largest, pixelWorst);
+		count += pixelWorst > tolerance;
+	}
+
+	*over = count;
+	return largest;
+}
+
+/* draws, times and checks one scene, returns -1 if the window closed */
+static int golden(const benchInfo* scene, const char* dir, int update,
+	int tolerance, int allow, int repeats, FILE* csv)
+{
+	long long* runs = timeRuns(scene, 1, repeats);
+	if (runs == NULL) return -1;
+	double median = toMs(runs[repeats / 2]);
+	free(runs);
+
+	/* the last run is still in the render target */
+	char goldenFile[MAX_PATH], newFile[MAX_PATH];
+	snprintf(goldenFile, MAX_PATH, "%s\\%s.png", dir, scene->name);
+	snprintf(newFile, MAX_PATH, "%s\\%s.new.png", dir, scene->name);
+	int written = VG_FALSE;
+	if (vgScreenshot(newFile, shotDone, &written)) vgFinishScreenshots();
+
+	const char* result = "FAIL";
+	int largest = -1, over = -1;
+	if (!written) result = "UNWRITTEN";
+	else if (update)
+	{
+		int moved = MoveFileExA(newFile, goldenFile,
+			MOVEFILE_REPLACE_EXISTING);
+		result = moved ? "UPDATED" : "UNWRITTEN";
+	}
+	else
+	{
+		/* both go through the same decoder so rows line up */
+		int gw = 0, gh = 0, nw = 0, nh = 0;
+		unsigned char* expected = vgLoadImageData(goldenFile, &gw, &gh);
+		unsigned char* actual = vgLoadImageData(newFile, &nw, &nh);
+		if (expected == NULL) result = "MISSING";
+		else if (actual != NULL && gw == nw && gh == nh)
+		{
+			largest = imageDiff(expected, actual, gw * gh, tolerance, &over);
+			if (over <= allow)
+			{
+				result = "PASS";
+				DeleteFileA(newFile);
+			}
+		}
+		free(expected);
+		free(actual);
+	}
+
+	printf("%-22s %10.3f %9d %12d  %s\n", scene->name, median, largest,
+		over, result);
+	if (csv != NULL)
+		fprintf(csv, "%s,%.4f,%d,%d,%s\n", scene->name, median, largest,
+			over, result);
+
+	return strcmp(result, "PASS") == 0 || strcmp(result, "UPDATED") == 0;
+}
+
+/* ENTRY POINT */
+
+int main(int argc, char** argv)
+{
+	int count = 0, repeats = REPEATS_DEFAULT;
+	int update = VG_FALSE, tolerance = TOLERANCE_DEFAULT, allow = 0;
+	const char* only = NULL;
+	const char* csvFile = NULL;
+	const char* goldenDir = NULL;
+	int exitCode = 0;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+		if (strcmp(argv[i], "-update") == 0)
+		{
+			update = VG_TRUE;
+			continue;
+		}
+		if (value != NULL && strcmp(argv[i], "-n") == 0)
+			count = atoi(value);
+		else if (value != NULL && strcmp(argv[i], "-size") == 0)
+			_size = atoi(value);
+		else if (value != NULL && strcmp(argv[i], "-repeats") == 0)
+			repeats = atoi(value);
+		else if (value != NULL && strcmp(argv[i], "-only") == 0)
+			only = value;
+		else if (value != NULL && strcmp(argv[i], "-csv") == 0)
+			csvFile = value;
+		else if (value != NULL && strcmp(argv[i], "-golden") == 0)
+			goldenDir = value;
+		else if (value != NULL && strcmp(argv[i], "-tolerance") == 0)
+			tolerance = atoi(value);
+		else if (value != NULL && strcmp(argv[i], "-allow") == 0)
+			allow = atoi(value);
+		else
+		{
+			count = -1;
+			break;
+		}
+		i++;
+	}
+	if (count < 0 || _size <= 0 || repeats <= 0 || tolerance < 0 ||
+		allow < 0 || (update && goldenDir == NULL))
+	{
+		printf("Usage: VGBench [-n items] [-size pixels] [-repeats count] "
+			"[-only name] [-csv results.csv]\n"
+			"       VGBench -golden dir [-update] [-tolerance value] "
+			"[-allow pixels] [-repeats count] [-only name] "
+			"[-csv results.csv]\n");
+		return 1;
+	}
+
+	LARGE_INTEGER freq;
+	QueryPerformanceFrequency(&freq);
+	_freq = freq.QuadPart;
+
+	vgInit(WINDOW_W, WINDOW_H, RESOLUTION_W, RESOLUTION_H, VG_FALSE);
+	vgSetWindowTitle("VGBench");
+	vgUseRenderSkip(VG_FALSE);
+	vgSetSwapTime(VG_SWAP_TIME_MIN);
+	if (!setup())
+	{
+		printf("Out of memory\n");
+		vgTerminate();
+		return 1;
+	}
+
+	FILE* csv = NULL;
+	if (csvFile != NULL)
+	{
+		csv = fopen(csvFile, "w");
+		if (csv == NULL) printf("Could not write %s\n", csvFile);
+	}
+
+	if (goldenDir != NULL)
+	{
+		goldenSetup();
+		if (csv != NULL)
+			fprintf(csv, "scene,median_ms,max_diff,pixels_over,result\n");
+		printf("%d runs each, tolerance %d, %d pixels allowed\n\n", repeats,
+			tolerance, allow);
+		printf("%-22s %10s %9s %12s  %s\n", "scene", "median ms",
+			"max diff", "pixels over", "result");
+
+		int ran = 0, failed = 0;
+		for (int i = 0; i < (int)SCENE_COUNT; i++)
+		{
+			const benchInfo* scene = &_scenes[i];
+			if (only != NULL && strcmp(only, scene->name) != 0) continue;
+			ran++;
+			int passed = golden(scene, goldenDir, update, tolerance, allow,
+				repeats, csv);
+			failed += passed <= 0;
+			if (passed < 0) break;
+		}
+		if (ran == 0) printf("No scene is called %s\n", only);
+		else printf("\n%d of %d scenes failed\n", failed, ran);
+		exitCode = failed > 0 || ran == 0;
+
+		vgDestroyTexture(_checker);
+		vgDestroyTexture(_canvas);
+		vgDestroyTexture(_itex);
+	}
+	else
+	{
+		if (csv != NULL)
+			fprintf(csv, "bench,items,repeats,min_ms,median_ms,mean_ms,"
+				"max_ms,median_ns_per_item\n");
+		runBenches(count, repeats, only, csv);
+	}
+
+	if (csv != NULL) fclose(csv);
+	DeleteFileA(_tempFile);
+	vgDestroyTexture(_tex);
+	vgDestroyShape(_shape);
+	vgDestroyShape(_shapeTextured);
+	vgTerminate();
+	free(_texels);
+	free(_pixels);
+	return exitCode;
+}
@@ -0,0 +1,492 @@
+/******************************************************************************
+* <client.c>
+* Bailey Jia-Tao Brown
+* 2021
+*
+*	Thin VGraphics client, forwards calls to a running VGServer
+*	Contents:
+*		- Preprocessor defs
+*		- Includes
+*		- Definitions
+*		- Client data
+*		- Ring functions
+*		- Module init and terminate functions
+*		- Module update functions
+*		- Clear and swap functions
+*		- Basic draw functions
+*		- Float variants
+*		- Advanced draw functions
+*
+*	VGClient.dll exports the subset of graphics.h below, so a program
+*	that only uses it can link VGClient.lib in place of VGraphics.lib.
+*	Coordinates and resolution are the server's, the window is the
+*	client's tile of the server window. If the server goes away every
+*	call becomes a no-op and vgWindowIsClosed returns true.
+*
+******************************************************************************/
+
+/* PREPROCESSOR DEFS */
+#define _CRT_SECURE_NO_WARNINGS
+#define WIN32_LEAN_AND_MEAN
+
+/* INCLUDES */
+#include <stdio.h>  /* Names */
+#include <stdlib.h> /* Exit */
+#include <string.h> /* Memory copying */
+
+#include <Windows.h> /* Shared memory and processes */
+
+#include "graphics.h" /* Exported API */
+#include "protocol.h" /* Command ring */
+
+/* DEFINITIONS */
+#define TEXTURE_ARGS 7
+#define SHAPE_ARGS   3
+
+/* CLIENT DATA */
+static HANDLE    _lobbyMapping = NULL;
+static vgsLobby* _lobby = NULL;
+static HANDLE    _ringMapping = NULL;
+static vgsRing*  _ring = NULL;
+static HANDLE    _dataEvent = NULL;
+static HANDLE    _spaceEvent = NULL;
+static HANDLE    _server = NULL;
+static int  _slot = -1;
+static long _pid = 0;
+static int  _dead = TRUE;
+static long _sent = 0;
+static unsigned long long _updates = 0;
+
+static int _texUsed[VG_TEXTURES_MAX] = { 0 };
+static int _shapeUsed[VG_SHAPES_MAX] = { 0 };
+
+/* RING FUNCTIONS */
+
+static int serverGone(void)
+{
+	/* a slot taken back by the server means we were dropped */
+	return WaitForSingleObject(_server, 0) != WAIT_TIMEOUT ||
+		_lobby->closed || _lobby->owner[_slot] != _pid;
+}
+
+static void ringWrite(const void* data, unsigned int size)
+{
+	const unsigned char* bytes = data;
+	while (size > 0 && !_dead)
+	{
+		unsigned int space = vgsRingSpace(_ring);
+		if (space == 0)
+		{
+			/* full, let the server drain it if it is still there */
+			SetEvent(_dataEvent);
+			if (WaitForSingleObject(_spaceEvent, VGS_TIMEOUT) ==
+				WAIT_TIMEOUT && serverGone())
+				_dead = TRUE;
+			continue;
+		}
+
+		unsigned int chunk = min(space, size);
+		vgsRingCopy(_ring, _ring->head, (void*)bytes, chunk, TRUE);
+		InterlockedExchange64(&_ring->head, _ring->head + chunk);
+		bytes += chunk;
+		size -= chunk;
+	}
+}
+
+static void sendCommand(unsigned int op, const void* args,
+	unsigned int argSize, const void* data, unsigned int dataSize)
+{
+	if (_dead) return;
+
+	vgsCommand cmd = { op, argSize + dataSize };
+	ringWrite(&cmd, sizeof(cmd));
+	if (argSize) ringWrite(args, argSize);
+	if (dataSize) ringWrite(data, dataSize);
+	SetEvent(_dataEvent);
+}
+
+static void serverDisconnect(void)
+{
+	if (_ring) UnmapViewOfFile(_ring);
+	if (_lobby) UnmapViewOfFile(_lobby);
+	if (_ringMapping) CloseHandle(_ringMapping);
+	if (_lobbyMapping) CloseHandle(_lobbyMapping);
+	if (_dataEvent) CloseHandle(_dataEvent);
+	if (_spaceEvent) CloseHandle(_spaceEvent);
+	if (_server) CloseHandle(_server);
+	_ring = NULL;
+	_lobby = NULL;
+	_ringMapping = NULL;
+	_lobbyMapping = NULL;
+	_dataEvent = NULL;
+	_spaceEvent = NULL;
+	_server = NULL;
+	_dead = TRUE;
+}
+
+static int serverConnect(void)
+{
+	_lobbyMapping = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE,
+		VGS_LOBBY_NAME);
+	if (_lobbyMapping == NULL) return FALSE;
+	_lobby = MapViewOfFile(_lobbyMapping, FILE_MAP_ALL_ACCESS, 0, 0,
+		sizeof(vgsLobby));
+	if (_lobby == NULL || memcmp(_lobby->magic, "VGSV", 4) != 0 ||
+		_lobby->version != VGS_VERSION)
+		return FALSE;
+
+	_server = OpenProcess(SYNCHRONIZE, FALSE, _lobby->serverPid);
+	if (_server == NULL) return FALSE;
+
+	/* claim the first free slot */
+	_pid = (long)GetCurrentProcessId();
+	for (int i = 0; i < VGS_CLIENTS_MAX && _slot < 0; i++)
+		if (InterlockedCompareExchange(&_lobby->owner[i], _pid, 0) == 0)
+			_slot = i;
+	if (_slot < 0) return FALSE;
+
+	char name[MAX_PATH];
+	sprintf(name, VGS_RING_NAME, _slot);
+	_ringMapping = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, name);
+	if (_ringMapping == NULL) return FALSE;
+	_ring = MapViewOfFile(_ringMapping, FILE_MAP_ALL_ACCESS, 0, 0,
+		sizeof(vgsRing));
+
+	sprintf(name, VGS_DATA_NAME, _slot);
+	_dataEvent = OpenEventA(EVENT_MODIFY_STATE, FALSE, name);
+	sprintf(name, VGS_SPACE_NAME, _slot);
+	_spaceEvent = OpenEventA(SYNCHRONIZE, FALSE, name);
+
+	return _ring != NULL && _dataEvent != NULL && _spaceEvent != NULL;
+}
+
+/* MODULE INIT AND TERMINATE FUNCTIONS */
+
+VAPI void vgInit(int window_w, int window_h, int resolution_w,
+	int resolution_h, int linear)
+{
+	/* size and filtering belong to the server */
+	if (serverConnect())
+	{
+		_dead = FALSE;
+		return;
+	}
+
+	/* give back a claimed slot */
+	if (_slot >= 0) InterlockedExchange(&_lobby->owner[_slot], 0);
+	serverDisconnect();
+	MessageBoxA(NULL, "Could not connect to VGServer!",
+		"CRITICAL ENGINE FAILURE", MB_OK);
+	exit(1);
+}
+
+VAPI void vgTerminate(void)
+{
+	sendCommand(VGS_DISCONNECT, NULL, 0, NULL, 0);
+	serverDisconnect();
+}
+
+/* MODULE UPDATE FUNCTIONS */
+
+VAPI void vgUpdate(void)
+{
+	if (!_dead && serverGone()) _dead = TRUE;
+	_updates++;
+}
+
+VAPI unsigned long long vgUpdateCount(void)
+{
+	return _updates;
+}
+
+VAPI void vgGetResolution(int* w, int* h)
+{
+	*w = _lobby ? _lobby->resW : 0;
+	*h = _lobby ? _lobby->resH : 0;
+}
+
+VAPI void vgSetWindowTitle(const char* title)
+{
+	/* the window is the server's */
+}
+
+VAPI int vgWindowIsClosed(void)
+{
+	return _dead;
+}
+
+/* CLEAR AND SWAP FUNCTIONS */
+
+VAPI void vgClear(void)
+{
+	sendCommand(VGS_CLEAR, NULL, 0, NULL, 0);
+}
+
+VAPI void vgFill(int r, int g, int b)
+{
+	int args[3] = { r, g, b };
+	sendCommand(VGS_FILL, args, sizeof(args), NULL, 0);
+}
+
+VAPI void vgSwap(void)
+{
+	sendCommand(VGS_SWAP, NULL, 0, NULL, 0);
+	_sent++;
+
+	/* stay at most a couple of frames ahead of the server */
+	while (!_dead && _sent - _ring->frames > VGS_FRAMES_AHEAD)
+	{
+		if (serverGone()) _dead = TRUE;
+		else Sleep(1);
+	}
+}
+
+/* BASIC DRAW FUNCTIONS */
+
+VAPI void vgColor3(int r, int g, int b)
+{
+	vgColor4(r, g, b, 255);
+}
+
+VAPI void vgColor4(int r, int g, int b, int a)
+{
+	int args[4] = { r, g, b, a };
+	sendCommand(VGS_COLOR, args, sizeof(args), NULL, 0);
+}
+
+VAPI void vgRect(int x, int y, int w, int h)
+{
+	int args[4] = { x, y, w, h };
+	sendCommand(VGS_RECT, args, sizeof(args), NULL, 0);
+}
+
+VAPI void vgLineSize(float size)
+{
+	sendCommand(VGS_LINE_SIZE, &size, sizeof(size), NULL, 0);
+}
+
+VAPI void vgLine(int x1, int y1, int x2, int y2)
+{
+	int args[4] = { x1, y1, x2, y2 };
+	sendCommand(VGS_LINE, args, sizeof(args), NULL, 0);
+}
+
+VAPI void vgPointSize(float size)
+{
+	sendCommand(VGS_POINT_SIZE, &size, sizeof(size), NULL, 0);
+}
+
+VAPI void vgPoint(int x, int y)
+{
+	int args[2] = { x, y };
+	sendCommand(VGS_POINT, args, sizeof(args), NULL, 0);
+}
+
+VAPI void vgViewport(int x, int y, int w, int h)
+{
+	int args[4] = { x, y, w, h };
+	sendCommand(VGS_VIEWPORT, args, sizeof(args), NULL, 0);
+}
+
+VAPI void vgViewportReset(void)
+{
+	sendCommand(VGS_VIEWPORT_RESET, NULL, 0, NULL, 0);
+}
+
+/* FLOAT VARIANTS */
+
+VAPI void vgRectf(float x, float y, float w, float h)
+{
+	float args[4] = { x, y, w, h };
+	sendCommand(VGS_RECTF, args, sizeof(args), NULL, 0);
+}
+
+VAPI void vgLinef(float x1, float y1, float x2, float y2)
+{
+	float args[4] = { x1, y1, x2, y2 };
+	sendCommand(VGS_LINEF, args, sizeof(args), NULL, 0);
+}
+
+VAPI void vgPointf(float x, float y)
+{
+	float args[2] = { x, y };
+	sendCommand(VGS_POINTF, args, sizeof(args), NULL, 0);
+}
+
+/* ADVANCED DRAW FUNCTIONS */
+
+VAPI int vgFormatSize(int format, int w, int h)
+{
+	return vgsFormatSize(format, w, h);
+}
+
+VAPI vgTexture vgCreateTextureFormat(int w, int h, int linear, int repeat,
+	int format, void* data)
+{
+	/* the server refuses anything it can't validate, so don't send it */
+	unsigned long long size = vgsTextureSize(format, w, h);
+	if (size == 0 || size > VGS_ARGS_MAX - TEXTURE_ARGS * sizeof(int))
+		return VG_INVALID;
+
+	/* handles are picked here, the server maps them onto its own */
+	vgTexture handle = VG_INVALID;
+	for (int i = 0; i < VG_TEXTURES_MAX && handle == VG_INVALID; i++)
+		if (!_texUsed[i]) handle = i;
+	if (handle == VG_INVALID) return VG_INVALID;
+	_texUsed[handle] = TRUE;
+
+	int args[TEXTURE_ARGS] = { handle, w, h, linear, repeat, format,
+		data != NULL };
+	sendCommand(VGS_CREATE_TEXTURE, args, sizeof(args), data,
+		data ? (unsigned int)size : 0);
+	return handle;
+}
+
+VAPI vgTexture vgCreateTexture(int w, int h, int linear, int repeat,
+	void* data)
+{
+	return vgCreateTextureFormat(w, h, linear, repeat, VG_FORMAT_RGBA8,
+		data);
+}
+
+VAPI vgTexture vgCreateTextureCompressed(int w, int h, int linear,
+	int repeat, int format, void* blocks)
+{
+	return vgCreateTextureFormat(w, h, linear, repeat, format, blocks);
+}
+
+VAPI void vgDestroyTexture(vgTexture tex)
+{
+	if (tex >= VG_TEXTURES_MAX || !_texUsed[tex]) return;
+	_texUsed[tex] = FALSE;
+
+	int args[1] = { tex };
+	sendCommand(VGS_DESTROY_TEXTURE, args, sizeof(args), NULL, 0);
+}
+
+VAPI void vgUseTexture(vgTexture target)
+{
+	int args[1] = { target };
+	if (target < VG_TEXTURES_MAX)
+		sendCommand(VGS_USE_TEXTURE, args, sizeof(args), NULL, 0);
+}
+
+VAPI void vgTextureFilter(int r, int g, int b, int a)
+{
+	int args[4] = { r, g, b, a };
+	sendCommand(VGS_TEXTURE_FILTER, args, sizeof(args), NULL, 0);
+}
+
+VAPI void vgTextureFilterReset(void)
+{
+	sendCommand(VGS_TEXTURE_FILTER_RESET, NULL, 0, NULL, 0);
+}
+
+VAPI void vgRectTexture(int x, int y, int w, int h)
+{
+	int args[4] = { x, y, w, h };
+	sendCommand(VGS_RECT_TEXTURE, args, sizeof(args), NULL, 0);
+}
+
+VAPI void vgRectTextureOffset(int x, int y, int w, int h, float s, float t)
+{
+	vgsArg args[6];
+	args[0].i = x;
+	args[1].i = y;
+	args[2].i = w;
+	args[3].i = h;
+	args[4].f = s;
+	args[5].f = t;
+	sendCommand(VGS_RECT_TEXTURE_OFFSET, args, sizeof(args), NULL, 0);
+}
+
+static vgShape compileShape(float* f2d_data, float* t2d_data, int size)
+{
+	vgShape handle = VG_INVALID;
+	for (int i = 0; i < VG_SHAPES_MAX && handle == VG_INVALID; i++)
+		if (!_shapeUsed[i]) handle = i;
+	if (handle == VG_INVALID || _dead) return handle;
+	_shapeUsed[handle] = TRUE;
+
+	/* positions then texcoords, sent as one command */
+	int args[SHAPE_ARGS] = { handle, size, t2d_data != NULL };
+	unsigned int bytes = size * 2 * sizeof(float);
+	vgsCommand cmd = { VGS_COMPILE_SHAPE,
+		sizeof(args) + bytes * (t2d_data ? 2 : 1) };
+	ringWrite(&cmd, sizeof(cmd));
+	ringWrite(args, sizeof(args));
+	ringWrite(f2d_data, bytes);
+	if (t2d_data) ringWrite(t2d_data, bytes);
+	SetEvent(_dataEvent);
+
+	return handle;
+}
+
+VAPI vgShape vgCompileShape(float* f2d_data, int size)
+{
+	return compileShape(f2d_data, NULL, size);
+}
+
+VAPI vgShape vgCompileShapeTextured(float* f2d_data, float* t2d_data,
+	int size)
+{
+	return compileShape(f2d_data, t2d_data, size);
+}
+
+VAPI void vgDestroyShape(vgShape shape)
+{
+	if (shape >= VG_SHAPES_MAX || !_shapeUsed[shape]) return;
+	_shapeUsed[shape] = FALSE;
+
+	int args[1] = { shape };
+	sendCommand(VGS_DESTROY_SHAPE, args, sizeof(args), NULL, 0);
+}
+
+VAPI void vgDrawShape(vgShape shape, float x, float y, float r, float s)
+{
+	vgsArg args[5];
+	args[0].i = shape;
+	args[1].f = x;
+	args[2].f = y;
+	args[3].f = r;
+	args[4].f = s;
+	sendCommand(VGS_DRAW_SHAPE, args, sizeof(args), NULL, 0);
+}
+
+VAPI void vgDrawShapeTextured(vgShape shape, float x, float y, float r,
+	float s)
+{
+	vgsArg args[5];
+	args[0].i = shape;
+	args[1].f = x;
+	args[2].f = y;
+	args[3].f = r;
+	args[4].f = s;
+	sendCommand(VGS_DRAW_SHAPE_TEXTURED, args, sizeof(args), NULL, 0);
+}
+
+VAPI void vgRenderScale(float scale)
+{
+	sendCommand(VGS_RENDER_SCALE, &scale, sizeof(scale), NULL, 0);
+}
+
+VAPI void vgUseRenderScaling(int value)
+{
+	sendCommand(VGS_USE_RENDER_SCALING, &value, sizeof(value), NULL, 0);
+}
+
+VAPI void vgRenderOffset(float x, float y)
+{
+	float args[2] = { x, y };
+	sendCommand(VGS_RENDER_OFFSET, args, sizeof(args), NULL, 0);
+}
+
+VAPI void vgUseRenderOffset(int value)
+{
+	sendCommand(VGS_USE_RENDER_OFFSET, &value, sizeof(value), NULL, 0);
+}
+
+VAPI void vgRenderLayer(float layer)
+{
+	sendCommand(VGS_RENDER_LAYER, &layer, sizeof(layer), NULL, 0);
+}
@@ -0,0 +1,456 @@
+/******************************************************************************
+* <cooker.c>
+* Bailey Jia-Tao Brown
+* 2021
+*
+*	Offline asset cooker, builds archives the runtime loads as they are
+*	Contents:
+*		- Preprocessor defs
+*		- Includes
+*		- Definitions
+*		- Manifest data
+*		- Helper functions
+*		- Manifest parsing
+*		- Atlas packing
+*		- Cook functions
+*		- Entry point
+*
+*	Usage:
+*		VGCooker <manifest> <archive>
+*
+*	Manifest lines, paths are relative to the manifest:
+*		texture <name> <file> [format] [mips]
+*		atlas   <name> [format] [mips] [max size]
+*		sprite  <name> <file>          (packed into the last atlas)
+*		shape   <name> x y x y ...
+*		tshape  <name> x y u v x y u v ...
+*
+******************************************************************************/
+
+/* PREPROCESSOR DEFS */
+#define _CRT_SECURE_NO_WARNINGS
+
+/* INCLUDES */
+#include <stdio.h>  /* I/O */
+#include <stdlib.h> /* Memory allocation */
+#include <string.h> /* String handling */
+
+#include "graphics.h" /* Conversion, mipmaps, compression and archives */
+
+/* DEFINITIONS */
+#define COOK_ITEMS_MAX   0x1000
+#define COOK_NAME_MAX    0x80
+#define COOK_PATH_MAX    0x200
+#define COOK_LINE_MAX    0x4000
+#define COOK_VERTS_MAX   0x400
+#define ATLAS_SIZE_MIN   0x40
+#define ATLAS_SIZE_MAX   0x1000
+#define ATLAS_PADDING    1
+
+#define ITEM_TEXTURE 0
+#define ITEM_ATLAS   1
+#define ITEM_SPRITE  2
+#define ITEM_SHAPE   3
+
+#define min(a, b) (((a) < (b)) ? (a) : (b))
+#define max(a, b) (((a) > (b)) ? (a) : (b))
+
+/* MANIFEST DATA */
+static int   _itemCount = 0;
+static int   _itemType[COOK_ITEMS_MAX];
+static char  _itemName[COOK_ITEMS_MAX][COOK_NAME_MAX];
+static int   _itemFormat[COOK_ITEMS_MAX];
+static int   _itemMips[COOK_ITEMS_MAX];
+static int   _itemAtlas[COOK_ITEMS_MAX];  /* owning atlas of a sprite */
+static int   _itemSize[COOK_ITEMS_MAX];   /* atlas limit, shape vertices */
+static int   _itemImage[COOK_ITEMS_MAX];  /* index into the decode list */
+static float* _itemVerts[COOK_ITEMS_MAX];
+static int   _itemTextured[COOK_ITEMS_MAX];
+
+/* images are decoded together so they spread across cores */
+static int   _imageCount = 0;
+static char  _imagePath[COOK_ITEMS_MAX][COOK_PATH_MAX];
+static const char* _imageFiles[COOK_ITEMS_MAX];
+static void* _imageData[COOK_ITEMS_MAX];
+static int   _imageW[COOK_ITEMS_MAX];
+static int   _imageH[COOK_ITEMS_MAX];
+
+/* sprite placement inside its atlas */
+static int   _spriteX[COOK_ITEMS_MAX];
+static int   _spriteY[COOK_ITEMS_MAX];
+
+/* HELPER FUNCTIONS */
+
+static const char* _formatNames[] = { "rgba8", "a8", "rg8", "rgb565",
+	"rgba4444", "rgb5a1", "rgb8", "bc1", "bc3" };
+
+static int parseFormat(const char* name)
+{
+	int count = (int)(sizeof(_formatNames) / sizeof(_formatNames[0]));
+	for (int i = 0; i < count; i++)
+		if (strcmp(name, _formatNames[i]) == 0) return i;
+	return -1;
+}
+
+static int mipLevels(int w, int h)
+{
+	int levels = 1;
+	int size = max(w, h);
+	while (size > 1)
+	{
+		size >>= 1;
+		levels++;
+	}
+	return levels;
+}
+
+static int addImage(const char* dir, const char* file)
+{
+	if (_imageCount >= COOK_ITEMS_MAX) return -1;
+
+	int index = _imageCount++;
+	snprintf(_imagePath[index], COOK_PATH_MAX, "%s%s", dir, file);
+	_imageFiles[index] = _imagePath[index];
+	return index;
+}
+
+/* MANIFEST PARSING */
+
+static int parseOptions(int item, char** tok, int count)
+{
+	/* [format] [mips] [size], any order after the required fields */
+	_itemFormat[item] = VG_FORMAT_RGBA8;
+	_itemMips[item] = 0;
+	_itemSize[item] = ATLAS_SIZE_MAX;
+
+	for (int i = 0; i < count; i++)
+	{
+		int format = parseFormat(tok[i]);
+		if (format >= 0) _itemFormat[item] = format;
+		else if (strcmp(tok[i], "mips") == 0) _itemMips[item] = 1;
+		else if (atoi(tok[i]) > 0) _itemSize[item] = atoi(tok[i]);
+		else return 0;
+	}
+
+	return 1;
+}
+
+static int parseManifest(const char* file)
+{
+	FILE* mFile = fopen(file, "r");
+	if (mFile == NULL)
+	{
+		fprintf(stderr, "cannot open manifest %s\n", file);
+		return 0;
+	}
+
+	/* paths in the manifest are relative to it */
+	char dir[COOK_PATH_MAX];
+	strncpy(dir, file, COOK_PATH_MAX - 1);
+	dir[COOK_PATH_MAX - 1] = 0;
+	char* slash = strrchr(dir, '/');
+	char* backslash = strrchr(dir, '\\');
+	if (backslash && (slash == NULL || backslash > slash)) slash = backslash;
+	if (slash) slash[1] = 0;
+	else dir[0] = 0;
+
+	static char line[COOK_LINE_MAX];
+	static char* tok[COOK_VERTS_MAX * 4 + 2];
+	int lineNumber = 0;
+	int atlas = -1;
+	int ok = 1;
+
+	while (ok && fgets(line, sizeof(line), mFile))
+	{
+		lineNumber++;
+
+		int count = 0;
+		int tokMax = (int)(sizeof(tok) / sizeof(tok[0]));
+		for (char* t = strtok(line, " \t\r\n"); t && count < tokMax;
+			t = strtok(NULL, " \t\r\n"))
+			tok[count++] = t;
+		if (count == 0 || tok[0][0] == '#') continue;
+
+		if (count < 2 || _itemCount >= COOK_ITEMS_MAX)
+		{
+			ok = 0;
+			break;
+		}
+
+		int item = _itemCount++;
+		strncpy(_itemName[item], tok[1], COOK_NAME_MAX - 1);
+
+		if (strcmp(tok[0], "texture") == 0 && count >= 3)
+		{
+			_itemType[item] = ITEM_TEXTURE;
+			_itemImage[item] = addImage(dir, tok[2]);
+			ok = _itemImage[item] >= 0 && parseOptions(item, tok + 3,
+				count - 3);
+		}
+		else if (strcmp(tok[0], "atlas") == 0)
+		{
+			_itemType[item] = ITEM_ATLAS;
+			ok = parseOptions(item, tok + 2, count - 2);
+			atlas = item;
+		}
+		else if (strcmp(tok[0], "sprite") == 0 && count >= 3 && atlas >= 0)
+		{
+			_itemType[item] = ITEM_SPRITE;
+			_itemAtlas[item] = atlas;
+			_itemImage[item] = addImage(dir, tok[2]);
+			ok = _itemImage[item] >= 0;
+		}
+		else if (strcmp(tok[0], "shape") == 0 ||
+			strcmp(tok[0], "tshape") == 0)
+		{
+			/* two floats per vertex, four with texture coordinates */
+			int textured = tok[0][0] == 't';
+			int stride = textured ? 4 : 2;
+			int verts = (count - 2) / stride;
+			ok = verts >= 3 && (count - 2) % stride == 0;
+			if (!ok) break;
+
+			float* data = malloc(verts * 4 * sizeof(float));
+			if (data == NULL)
+			{
+				ok = 0;
+				break;
+			}
+
+			/* archive wants all positions, then all coordinates */
+			for (int i = 0; i < verts; i++)
+			{
+				data[i * 2 + 0] = (float)atof(tok[2 + i * stride + 0]);
+				data[i * 2 + 1] = (float)atof(tok[2 + i * stride + 1]);
+				if (!textured) continue;
+				data[verts * 2 + i * 2 + 0] = (float)atof(tok[4 + i * 4]);
+				data[verts * 2 + i * 2 + 1] = (float)atof(tok[5 + i * 4]);
+			}
+
+			_itemType[item] = ITEM_SHAPE;
+			_itemVerts[item] = data;
+			_itemSize[item] = verts;
+			_itemTextured[item] = textured;
+		}
+		else ok = 0;
+	}
+
+	if (!ok) fprintf(stderr, "%s(%d): bad manifest line\n", file,
+		lineNumber);
+
+	fclose(mFile);
+	return ok;
+}
+
+/* ATLAS PACKING */
+
+static int packAtlas(int* sprites, int count, int size)
+{
+	/* shelves bottom up, sprites already sorted tallest first */
+	int x = 0, y = 0, shelf = 0;
+
+	for (int i = 0; i < count; i++)
+	{
+		int s = sprites[i];
+		int w = _imageW[_itemImage[s]] + ATLAS_PADDING * 2;
+		int h = _imageH[_itemImage[s]] + ATLAS_PADDING * 2;
+
+		if (x + w > size)
+		{
+			x = 0;
+			y += shelf;
+			shelf = 0;
+		}
+		if (w > size || y + h > size) return 0;
+
+		_spriteX[s] = x + ATLAS_PADDING;
+		_spriteY[s] = y + ATLAS_PADDING;
+		x += w;
+		shelf = max(shelf, h);
+	}
+
+	return 1;
+}
+
+static int compareHeight(const void* a, const void* b)
+{
+	int ha = _imageH[_itemImage[*(const int*)a]];
+	int hb = _imageH[_itemImage[*(const int*)b]];
+	return hb - ha;
+}
+
+static void blitSprite(unsigned char* dst, int size, int s)
+{
+	const unsigned char* src = _imageData[_itemImage[s]];
+	int w = _imageW[_itemImage[s]];
+	int h = _imageH[_itemImage[s]];
+
+	/* edges are repeated into the padding so filtering doesn't bleed */
+	for (int y = -ATLAS_PADDING; y < h + ATLAS_PADDING; y++)
+	{
+		int sy = min(max(y, 0), h - 1);
+		for (int x = -ATLAS_PADDING; x < w + ATLAS_PADDING; x++)
+		{
+			int sx = min(max(x, 0), w - 1);
+			memcpy(dst + ((size_t)(_spriteY[s] + y) * size + _spriteX[s] +
+				x) * 4, src + ((size_t)sy * w + sx) * 4, 4);
+		}
+	}
+}
+
+/* COOK FUNCTIONS */
+
+static int cookTexture(const char* name, int w, int h, const void* rgba,
+	int format, int mips)
+{
+	int levels = mips ? mipLevels(w, h) : 1;
+
+	size_t total = 0;
+	for (int i = 0; i < levels; i++)
+		total += vgFormatSize(format, max(1, w >> i), max(1, h >> i));
+
+	/* level after level, each converted to its final format */
+	unsigned char* out = malloc(total);
+	unsigned char* cur = malloc((size_t)w * h * 4);
+	unsigned char* next = malloc((size_t)max(1, w >> 1) * max(1, h >> 1) * 4);
+	if (out == NULL || cur == NULL || next == NULL)
+	{
+		free(out);
+		free(cur);
+		free(next);
+		return 0;
+	}
+	memcpy(cur, rgba, (size_t)w * h * 4);
+
+	size_t offset = 0;
+	for (int i = 0; i < levels; i++)
+	{
+		int lw = max(1, w >> i), lh = max(1, h >> i);
+		vgConvertTextureData(lw, lh, format, cur, out + offset);
+		offset += vgFormatSize(format, lw, lh);
+
+		if (i + 1 < levels)
+		{
+			vgBuildMipmapData(lw, lh, cur, next);
+			unsigned char* swap = cur;
+			cur = next;
+			next = swap;
+		}
+	}
+
+	vgArchiveAddTexture(name, w, h, format, levels, out);
+	printf("texture %-32s %5dx%-5d %-8s %2d levels %8zu bytes\n", name, w,
+		h, _formatNames[format], levels, total);
+
+	free(out);
+	free(cur);
+	free(next);
+	return 1;
+}
+
+static int cookAtlas(int atlas)
+{
+	static int sprites[COOK_ITEMS_MAX];
+	int count = 0;
+
+	for (int i = 0; i < _itemCount; i++)
+		if (_itemType[i] == ITEM_SPRITE && _itemAtlas[i] == atlas)
+			sprites[count++] = i;
+	if (count == 0) return 1;
+	qsort(sprites, count, sizeof(int), compareHeight);
+
+	/* smallest power of two that fits */
+	int size = ATLAS_SIZE_MIN;
+	while (!packAtlas(sprites, count, size))
+	{
+		size <<= 1;
+		if (size > _itemSize[atlas])
+		{
+			fprintf(stderr, "atlas %s: sprites don't fit in %d\n",
+				_itemName[atlas], _itemSize[atlas]);
+			return 0;
+		}
+	}
+
+	unsigned char* pixels = calloc((size_t)size * size, 4);
+	if (pixels == NULL) return 0;
+
+	for (int i = 0; i < count; i++)
+	{
+		int s = sprites[i];
+		blitSprite(pixels, size, s);
+		vgArchiveAddRegion(_itemName[s], _itemName[atlas], _spriteX[s],
+			_spriteY[s], _imageW[_itemImage[s]], _imageH[_itemImage[s]]);
+	}
+
+	int ok = cookTexture(_itemName[atlas], size, size, pixels,
+		_itemFormat[atlas], _itemMips[atlas]);
+	printf("atlas   %-32s %d sprites\n", _itemName[atlas], count);
+
+	free(pixels);
+	return ok;
+}
+
+/* ENTRY POINT */
+
+int main(int argc, char** argv)
+{
+	if (argc != 3)
+	{
+		fprintf(stderr, "usage: VGCooker <manifest> <archive>\n");
+		return 1;
+	}
+
+	if (!parseManifest(argv[1])) return 1;
+
+	/* every source image in one parallel batch */
+	int loaded = vgLoadImageDataBatch(_imageFiles, _imageCount, _imageData,
+		_imageW, _imageH);
+	if (loaded != _imageCount)
+	{
+		for (int i = 0; i < _imageCount; i++)
+			if (_imageData[i] == NULL)
+				fprintf(stderr, "cannot decode %s\n", _imagePath[i]);
+		return 1;
+	}
+
+	if (!vgArchiveBegin(argv[2]))
+	{
+		fprintf(stderr, "cannot write %s\n", argv[2]);
+		return 1;
+	}
+
+	int ok = 1;
+	for (int i = 0; ok && i < _itemCount; i++)
+	{
+		switch (_itemType[i])
+		{
+		case ITEM_TEXTURE:
+			ok = cookTexture(_itemName[i], _imageW[_itemImage[i]],
+				_imageH[_itemImage[i]], _imageData[_itemImage[i]],
+				_itemFormat[i], _itemMips[i]);
+			break;
+
+		case ITEM_ATLAS:
+			ok = cookAtlas(i);
+			break;
+
+		case ITEM_SHAPE:
+			vgArchiveAddShape(_itemName[i], _itemVerts[i], _itemTextured[i] ?
+				_itemVerts[i] + _itemSize[i] * 2 : NULL, _itemSize[i]);
+			printf("shape   %-32s %d vertices\n", _itemName[i],
+				_itemSize[i]);
+			break;
+		}
+	}
+
+	ok = vgArchiveEnd() && ok;
+	if (!ok) fprintf(stderr, "cooking %s failed\n", argv[2]);
+
+	for (int i = 0; i < _imageCount; i++)
+		free(_imageData[i]);
+	for (int i = 0; i < _itemCount; i++)
+		free(_itemVerts[i]);
+
+	return ok ? 0 : 1;
+}
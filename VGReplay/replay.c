@@ -0,0 +1,771 @@
+/******************************************************************************
+* <replay.c>
+* Bailey Jia-Tao Brown
+* 2021
+*
+*	Plays back a trace written by vgStartTrace and reports timings
+*	Contents:
+*		- Preprocessor defs
+*		- Includes
+*		- Definitions
+*		- Replay data
+*		- Trace functions
+*		- Call execution
+*		- Report functions
+*		- Entry point
+*
+*	Usage:
+*		VGReplay trace [loops] [frames.csv]
+*
+*	The trace is read into memory and every call is made again in order,
+*	as fast as the renderer allows. Handles are remapped to whatever the
+*	library returns this time, calls on objects the trace never created
+*	are skipped. Times are taken on the CPU around each call, the GPU
+*	shows up in vgSwap once the driver's queue is full.
+*
+******************************************************************************/
+
+/* PREPROCESSOR DEFS */
+#define _CRT_SECURE_NO_WARNINGS
+#define WIN32_LEAN_AND_MEAN
+
+/* INCLUDES */
+#include <stdio.h>  /* I/O */
+#include <stdlib.h> /* Memory allocation and sorting */
+#include <string.h> /* Memory copying */
+
+#include <Windows.h> /* Timers */
+
+#include "graphics.h" /* Renderer and trace format */
+
+/* DEFINITIONS */
+#define FRAMES_INITIAL 0x400
+
+typedef struct opInfo
+{
+	const char* name;
+	int args;
+} opInfo;
+
+static const opInfo _ops[VG_TRACE_OPS] = {
+	[VG_TRACE_UPDATE] = { "vgUpdate", 0 },
+	[VG_TRACE_SET_WINDOW_SIZE] = { "vgSetWindowSize", 2 },
+	[VG_TRACE_SET_SWAP_TIME] = { "vgSetSwapTime", 1 },
+	[VG_TRACE_USE_RENDER_SKIP] = { "vgUseRenderSkip", 1 },
+	[VG_TRACE_CLEAR] = { "vgClear", 0 },
+	[VG_TRACE_FILL] = { "vgFill", 3 },
+	[VG_TRACE_FILL_REGION] = { "vgFillRegion", 7 },
+	[VG_TRACE_SWAP] = { "vgSwap", 1 },
+	[VG_TRACE_COLOR3] = { "vgColor3", 3 },
+	[VG_TRACE_COLOR4] = { "vgColor4", 4 },
+	[VG_TRACE_RECT] = { "vgRect", 4 },
+	[VG_TRACE_LINE_SIZE] = { "vgLineSize", 1 },
+	[VG_TRACE_LINE] = { "vgLine", 4 },
+	[VG_TRACE_POINT_SIZE] = { "vgPointSize", 1 },
+	[VG_TRACE_POINT] = { "vgPoint", 2 },
+	[VG_TRACE_VIEWPORT] = { "vgViewport", 4 },
+	[VG_TRACE_VIEWPORT_RESET] = { "vgViewportReset", 0 },
+	[VG_TRACE_RECTF] = { "vgRectf", 4 },
+	[VG_TRACE_LINEF] = { "vgLinef", 4 },
+	[VG_TRACE_POINTF] = { "vgPointf", 2 },
+	[VG_TRACE_CREATE_TEXTURE] = { "vgCreateTextureFormat", 6 },
+	[VG_TRACE_DESTROY_TEXTURE] = { "vgDestroyTexture", 1 },
+	[VG_TRACE_USE_TEXTURE_POOL] = { "vgUseTexturePool", 1 },
+	[VG_TRACE_TEXTURE_POOL_CLEAR] = { "vgTexturePoolClear", 0 },
+	[VG_TRACE_USE_CPU_MIPMAPS] = { "vgUseCPUMipmaps", 1 },
+	[VG_TRACE_TEXTURE_LOD_BIAS] = { "vgTextureLODBias", 2 },
+	[VG_TRACE_REGENERATE_MIPMAPS] = { "vgRegenerateMipmaps", 1 },
+	[VG_TRACE_USE_TEXTURE] = { "vgUseTexture", 1 },
+	[VG_TRACE_TEXTURE_FILTER] = { "vgTextureFilter", 4 },
+	[VG_TRACE_TEXTURE_FILTER_RESET] = { "vgTextureFilterReset", 0 },
+	[VG_TRACE_RECT_TEXTURE] = { "vgRectTexture", 4 },
+	[VG_TRACE_RECT_TEXTURE_OFFSET] = { "vgRectTextureOffset", 6 },
+	[VG_TRACE_CREATE_TEXTURE_ARRAY] = { "vgCreateTextureArray", 6 },
+	[VG_TRACE_EDIT_TEXTURE_LAYER] = { "vgEditTextureLayer", 2 },
+	[VG_TRACE_USE_TEXTURE_LAYER] = { "vgUseTextureLayer", 1 },
+	[VG_TRACE_RECT_TEXTURE_LAYER] = { "vgRectTextureLayer", 5 },
+	[VG_TRACE_COMPILE_SHAPE] = { "vgCompileShape", 2 },
+	[VG_TRACE_COMPILE_SHAPE_TEXTURED] = { "vgCompileShapeTextured", 2 },
+	[VG_TRACE_DESTROY_SHAPE] = { "vgDestroyShape", 1 },
+	[VG_TRACE_DRAW_SHAPE] = { "vgDrawShape", 5 },
+	[VG_TRACE_DRAW_SHAPE_TEXTURED] = { "vgDrawShapeTextured", 5 },
+	[VG_TRACE_RENDER_SCALE] = { "vgRenderScale", 1 },
+	[VG_TRACE_USE_RENDER_SCALING] = { "vgUseRenderScaling", 1 },
+	[VG_TRACE_RENDER_OFFSET] = { "vgRenderOffset", 2 },
+	[VG_TRACE_USE_RENDER_OFFSET] = { "vgUseRenderOffset", 1 },
+	[VG_TRACE_RENDER_LAYER] = { "vgRenderLayer", 1 },
+	[VG_TRACE_EDIT_TEXTURE] = { "vgEditTexture", 3 },
+	[VG_TRACE_EDIT_COLOR] = { "vgEditColor", 4 },
+	[VG_TRACE_EDIT_POINT] = { "vgEditPoint", 2 },
+	[VG_TRACE_EDIT_LINE] = { "vgEditLine", 4 },
+	[VG_TRACE_EDIT_RECT] = { "vgEditRect", 4 },
+	[VG_TRACE_EDIT_SHAPE] = { "vgEditShape", 5 },
+	[VG_TRACE_EDIT_USE_TEXTURE] = { "vgEditUseTexture", 1 },
+	[VG_TRACE_EDIT_SHAPE_TEXTURED] = { "vgEditShapeTextured", 5 },
+	[VG_TRACE_EDIT_SET_DATA] = { "vgEditSetData", 2 },
+	[VG_TRACE_EDIT_CLEAR] = { "vgEditClear", 0 },
+	[VG_TRACE_READ_PIXELS] = { "vgReadPixels", 7 },
+	[VG_TRACE_COPY_TEXTURE] = { "vgCopyTexture", 8 },
+	[VG_TRACE_BLIT_TEXTURE] = { "vgBlitTexture", 11 },
+	[VG_TRACE_DUPLICATE_TEXTURE] = { "vgDuplicateTexture", 2 },
+	[VG_TRACE_CREATE_TEXTURE_COMPRESSED] = { "vgCreateTextureCompressed", 6 },
+};
+
+/* REPLAY DATA */
+static unsigned char* _trace = NULL;
+static size_t _traceSize = 0;
+static vgTraceHeader _header;
+
+/* traced handles map onto live handles, VG_INVALID if unused */
+static vgTexture _texMap[VG_TEXTURES_MAX];
+static vgShape   _shapeMap[VG_SHAPES_MAX];
+
+/* bytes in one layer of a traced array texture, 0 for anything else */
+static unsigned int _layerSize[VG_TEXTURES_MAX];
+
+static unsigned char* _scratch = NULL;
+static size_t _scratchCap = 0;
+
+/* per call totals in counter ticks */
+static unsigned long long _calls[VG_TRACE_OPS] = { 0 };
+static long long _ticks[VG_TRACE_OPS] = { 0 };
+static long long _worst[VG_TRACE_OPS] = { 0 };
+static unsigned long long _skipped = 0;
+static long long _freq;
+
+/* one entry per swap, as recorded and as replayed */
+static int* _recorded = NULL;
+static long long* _frames = NULL;
+static int _frameCount = 0;
+static int _frameCap = 0;
+
+/* TRACE FUNCTIONS */
+
+static int traceLoad(const char* file)
+{
+	FILE* in = fopen(file, "rb");
+	if (in == NULL) return 0;
+
+	fseek(in, 0, SEEK_END);
+	long size = ftell(in);
+	fseek(in, 0, SEEK_SET);
+
+	if (size < (long)sizeof(vgTraceHeader) ||
+		fread(&_header, sizeof(_header), 1, in) != 1 ||
+		memcmp(_header.magic, "VGTR", 4) != 0 ||
+		_header.version != VG_TRACE_VERSION)
+	{
+		fclose(in);
+		return 0;
+	}
+
+	_traceSize = size - sizeof(vgTraceHeader);
+	_trace = malloc(_traceSize + 1);
+	int ok = _trace != NULL &&
+		fread(_trace, 1, _traceSize, in) == _traceSize;
+	fclose(in);
+	return ok;
+}
+
+static vgTexture mapTexture(int tex)
+{
+	if (tex == VG_RENDER_TARGET) return VG_RENDER_TARGET;
+	if (tex < 0 || tex >= VG_TEXTURES_MAX) return VG_INVALID;
+	return _texMap[tex];
+}
+
+static vgShape mapShape(int shape)
+{
+	if (shape < 0 || shape >= VG_SHAPES_MAX) return VG_INVALID;
+	return _shapeMap[shape];
+}
+
+static void keepTexture(int traced, vgTexture live)
+{
+	if (traced < 0 || traced >= VG_TEXTURES_MAX) return;
+	_texMap[traced] = live;
+	_layerSize[traced] = 0;
+}
+
+static unsigned int tracedLayerSize(int traced)
+{
+	if (traced < 0 || traced >= VG_TEXTURES_MAX) return 0;
+	return _layerSize[traced];
+}
+
+static void keepShape(int traced, vgShape live)
+{
+	if (traced >= 0 && traced < VG_SHAPES_MAX) _shapeMap[traced] = live;
+}
+
+static void* scratch(size_t size)
+{
+	if (size > _scratchCap)
+	{
+		unsigned char* grown = realloc(_scratch, size);
+		if (grown == NULL) return NULL;
+		_scratch = grown;
+		_scratchCap = size;
+	}
+	return _scratch;
+}
+
+static void releaseAll(void)
+{
+	for (int i = 0; i < VG_TEXTURES_MAX; i++)
+	{
+		if (_texMap[i] != VG_INVALID) vgDestroyTexture(_texMap[i]);
+		_texMap[i] = VG_INVALID;
+		_layerSize[i] = 0;
+	}
+	for (int i = 0; i < VG_SHAPES_MAX; i++)
+	{
+		if (_shapeMap[i] != VG_INVALID) vgDestroyShape(_shapeMap[i]);
+		_shapeMap[i] = VG_INVALID;
+	}
+}
+
+static void frameAdd(int recorded, long long replayed)
+{
+	if (_frameCount == _frameCap)
+	{
+		int cap = _frameCap ? _frameCap * 2 : FRAMES_INITIAL;
+		int* rec = realloc(_recorded, cap * sizeof(int));
+		if (rec == NULL) return;
+		_recorded = rec;
+		long long* rep = realloc(_frames, cap * sizeof(long long));
+		if (rep == NULL) return;
+		_frames = rep;
+		_frameCap = cap;
+	}
+
+	_recorded[_frameCount] = recorded;
+	_frames[_frameCount] = replayed;
+	_frameCount++;
+}
+
+/* CALL EXECUTION */
+
+/* returns 0 if the call was skipped */
+static int execute(int op, const vgTraceArg* a, const unsigned char* data,
+	unsigned int size)
+{
+	vgTexture tex;
+	vgShape shape;
+
+	switch (op)
+	{
+	case VG_TRACE_UPDATE:
+		vgUpdate();
+		break;
+
+	case VG_TRACE_SET_WINDOW_SIZE:
+		vgSetWindowSize(a[0].i, a[1].i);
+		break;
+
+	/* replays run flat out, pacing calls are timed but not made */
+	case VG_TRACE_SET_SWAP_TIME:
+	case VG_TRACE_USE_RENDER_SKIP:
+		break;
+
+	case VG_TRACE_CLEAR:
+		vgClear();
+		break;
+
+	case VG_TRACE_FILL:
+		vgFill(a[0].i, a[1].i, a[2].i);
+		break;
+
+	case VG_TRACE_FILL_REGION:
+		vgFillRegion(a[0].i, a[1].i, a[2].i, a[3].i, a[4].i, a[5].i, a[6].i);
+		break;
+
+	case VG_TRACE_SWAP:
+		vgSwap();
+		break;
+
+	case VG_TRACE_COLOR3:
+		vgColor3(a[0].i, a[1].i, a[2].i);
+		break;
+
+	case VG_TRACE_COLOR4:
+		vgColor4(a[0].i, a[1].i, a[2].i, a[3].i);
+		break;
+
+	case VG_TRACE_RECT:
+		vgRect(a[0].i, a[1].i, a[2].i, a[3].i);
+		break;
+
+	case VG_TRACE_LINE_SIZE:
+		vgLineSize(a[0].f);
+		break;
+
+	case VG_TRACE_LINE:
+		vgLine(a[0].i, a[1].i, a[2].i, a[3].i);
+		break;
+
+	case VG_TRACE_POINT_SIZE:
+		vgPointSize(a[0].f);
+		break;
+
+	case VG_TRACE_POINT:
+		vgPoint(a[0].i, a[1].i);
+		break;
+
+	case VG_TRACE_VIEWPORT:
+		vgViewport(a[0].i, a[1].i, a[2].i, a[3].i);
+		break;
+
+	case VG_TRACE_VIEWPORT_RESET:
+		vgViewportReset();
+		break;
+
+	case VG_TRACE_RECTF:
+		vgRectf(a[0].f, a[1].f, a[2].f, a[3].f);
+		break;
+
+	case VG_TRACE_LINEF:
+		vgLinef(a[0].f, a[1].f, a[2].f, a[3].f);
+		break;
+
+	case VG_TRACE_POINTF:
+		vgPointf(a[0].f, a[1].f);
+		break;
+
+	case VG_TRACE_CREATE_TEXTURE:
+		if (size < (unsigned int)a[0].i * a[1].i * 4) data = NULL;
+		keepTexture(a[5].i, vgCreateTextureFormat(a[0].i, a[1].i, a[2].i,
+			a[3].i, a[4].i, (void*)data));
+		break;
+
+	case VG_TRACE_CREATE_TEXTURE_COMPRESSED:
+		if (size < (unsigned int)vgFormatSize(a[4].i, a[0].i, a[1].i))
+			return 0;
+		keepTexture(a[5].i, vgCreateTextureCompressed(a[0].i, a[1].i, a[2].i,
+			a[3].i, a[4].i, (void*)data));
+		break;
+
+	case VG_TRACE_CREATE_TEXTURE_ARRAY:
+	{
+		/* layers are stored back to back */
+		unsigned int layerSize = a[0].i * a[1].i * 4;
+		void** layers = NULL;
+		if (a[2].i > 0 && size >= layerSize * a[2].i)
+			layers = scratch(a[2].i * sizeof(void*));
+		for (int i = 0; layers != NULL && i < a[2].i; i++)
+			layers[i] = (void*)(data + i * layerSize);
+		keepTexture(a[5].i, vgCreateTextureArray(a[0].i, a[1].i, a[2].i,
+			a[3].i, a[4].i, layers));
+		if (a[5].i >= 0 && a[5].i < VG_TEXTURES_MAX)
+			_layerSize[a[5].i] = layerSize;
+		break;
+	}
+
+	case VG_TRACE_DUPLICATE_TEXTURE:
+		if ((tex = mapTexture(a[0].i)) == VG_INVALID) return 0;
+		keepTexture(a[1].i, vgDuplicateTexture(tex));
+		if (a[1].i >= 0 && a[1].i < VG_TEXTURES_MAX)
+			_layerSize[a[1].i] = tracedLayerSize(a[0].i);
+		break;
+
+	case VG_TRACE_DESTROY_TEXTURE:
+		if ((tex = mapTexture(a[0].i)) == VG_INVALID) return 0;
+		vgDestroyTexture(tex);
+		keepTexture(a[0].i, VG_INVALID);
+		break;
+
+	case VG_TRACE_USE_TEXTURE_POOL:
+		vgUseTexturePool(a[0].i);
+		break;
+
+	case VG_TRACE_TEXTURE_POOL_CLEAR:
+		vgTexturePoolClear();
+		break;
+
+	case VG_TRACE_USE_CPU_MIPMAPS:
+		vgUseCPUMipmaps(a[0].i);
+		break;
+
+	case VG_TRACE_TEXTURE_LOD_BIAS:
+		if ((tex = mapTexture(a[0].i)) == VG_INVALID) return 0;
+		vgTextureLODBias(tex, a[1].f);
+		break;
+
+	case VG_TRACE_REGENERATE_MIPMAPS:
+		if ((tex = mapTexture(a[0].i)) == VG_INVALID) return 0;
+		vgRegenerateMipmaps(tex);
+		break;
+
+	case VG_TRACE_USE_TEXTURE:
+		if ((tex = mapTexture(a[0].i)) == VG_INVALID) return 0;
+		vgUseTexture(tex);
+		break;
+
+	case VG_TRACE_TEXTURE_FILTER:
+		vgTextureFilter(a[0].i, a[1].i, a[2].i, a[3].i);
+		break;
+
+	case VG_TRACE_TEXTURE_FILTER_RESET:
+		vgTextureFilterReset();
+		break;
+
+	case VG_TRACE_RECT_TEXTURE:
+		vgRectTexture(a[0].i, a[1].i, a[2].i, a[3].i);
+		break;
+
+	case VG_TRACE_RECT_TEXTURE_OFFSET:
+		vgRectTextureOffset(a[0].i, a[1].i, a[2].i, a[3].i, a[4].f, a[5].f);
+		break;
+
+	case VG_TRACE_EDIT_TEXTURE_LAYER:
+		/* the layer is read whole, a short payload would run past it */
+		if ((tex = mapTexture(a[0].i)) == VG_INVALID) return 0;
+		if (tracedLayerSize(a[0].i) == 0 || size < tracedLayerSize(a[0].i))
+			return 0;
+		vgEditTextureLayer(tex, a[1].i, (void*)data);
+		break;
+
+	case VG_TRACE_USE_TEXTURE_LAYER:
+		vgUseTextureLayer(a[0].i);
+		break;
+
+	case VG_TRACE_RECT_TEXTURE_LAYER:
+		vgRectTextureLayer(a[0].i, a[1].i, a[2].i, a[3].i, a[4].i);
+		break;
+
+	case VG_TRACE_COMPILE_SHAPE:
+		if (size < a[0].i * 2 * sizeof(float)) return 0;
+		keepShape(a[1].i, vgCompileShape((float*)data, a[0].i));
+		break;
+
+	case VG_TRACE_COMPILE_SHAPE_TEXTURED:
+		if (size < a[0].i * 4 * sizeof(float)) return 0;
+		keepShape(a[1].i, vgCompileShapeTextured((float*)data,
+			(float*)data + a[0].i * 2, a[0].i));
+		break;
+
+	case VG_TRACE_DESTROY_SHAPE:
+		if ((shape = mapShape(a[0].i)) == VG_INVALID) return 0;
+		vgDestroyShape(shape);
+		keepShape(a[0].i, VG_INVALID);
+		break;
+
+	case VG_TRACE_DRAW_SHAPE:
+		if ((shape = mapShape(a[0].i)) == VG_INVALID) return 0;
+		vgDrawShape(shape, a[1].f, a[2].f, a[3].f, a[4].f);
+		break;
+
+	case VG_TRACE_DRAW_SHAPE_TEXTURED:
+		if ((shape = mapShape(a[0].i)) == VG_INVALID) return 0;
+		vgDrawShapeTextured(shape, a[1].f, a[2].f, a[3].f, a[4].f);
+		break;
+
+	case VG_TRACE_RENDER_SCALE:
+		vgRenderScale(a[0].f);
+		break;
+
+	case VG_TRACE_USE_RENDER_SCALING:
+		vgUseRenderScaling(a[0].i);
+		break;
+
+	case VG_TRACE_RENDER_OFFSET:
+		vgRenderOffset(a[0].f, a[1].f);
+		break;
+
+	case VG_TRACE_USE_RENDER_OFFSET:
+		vgUseRenderOffset(a[0].i);
+		break;
+
+	case VG_TRACE_RENDER_LAYER:
+		vgRenderLayer(a[0].f);
+		break;
+
+	case VG_TRACE_EDIT_TEXTURE:
+		if ((tex = mapTexture(a[0].i)) == VG_INVALID) return 0;
+		vgEditTexture(tex, a[1].i, a[2].i);
+		break;
+
+	case VG_TRACE_EDIT_COLOR:
+		vgEditColor(a[0].i, a[1].i, a[2].i, a[3].i);
+		break;
+
+	case VG_TRACE_EDIT_POINT:
+		vgEditPoint(a[0].i, a[1].i);
+		break;
+
+	case VG_TRACE_EDIT_LINE:
+		vgEditLine(a[0].i, a[1].i, a[2].i, a[3].i);
+		break;
+
+	case VG_TRACE_EDIT_RECT:
+		vgEditRect(a[0].i, a[1].i, a[2].i, a[3].i);
+		break;
+
+	case VG_TRACE_EDIT_SHAPE:
+		if ((shape = mapShape(a[0].i)) == VG_INVALID) return 0;
+		vgEditShape(shape, a[1].f, a[2].f, a[3].f, a[4].f);
+		break;
+
+	case VG_TRACE_EDIT_USE_TEXTURE:
+		if ((tex = mapTexture(a[0].i)) == VG_INVALID) return 0;
+		vgEditUseTexture(tex);
+		break;
+
+	case VG_TRACE_EDIT_SHAPE_TEXTURED:
+		if ((shape = mapShape(a[0].i)) == VG_INVALID) return 0;
+		vgEditShapeTextured(shape, a[1].f, a[2].f, a[3].f, a[4].f);
+		break;
+
+	case VG_TRACE_EDIT_SET_DATA:
+		if (size < (unsigned int)a[0].i * a[1].i * 4) return 0;
+		vgEditSetData(a[0].i, a[1].i, (void*)data);
+		break;
+
+	case VG_TRACE_EDIT_CLEAR:
+		vgEditClear();
+		break;
+
+	case VG_TRACE_READ_PIXELS:
+	{
+		/* the pixels only need somewhere to land */
+		if ((tex = mapTexture(a[0].i)) == VG_INVALID) return 0;
+		size_t bytes = vgFormatSize(a[5].i, a[3].i, a[4].i);
+		if (a[6].i > 0) bytes = max(bytes, (size_t)a[6].i * a[4].i);
+		void* dst = scratch(bytes);
+		if (dst == NULL) return 0;
+		vgReadPixels(tex, a[1].i, a[2].i, a[3].i, a[4].i, a[5].i, dst,
+			a[6].i);
+		break;
+	}
+
+	case VG_TRACE_COPY_TEXTURE:
+	{
+		vgTexture dst = mapTexture(a[5].i);
+		if ((tex = mapTexture(a[0].i)) == VG_INVALID || dst == VG_INVALID)
+			return 0;
+		vgCopyTexture(tex, a[1].i, a[2].i, a[3].i, a[4].i, dst, a[6].i,
+			a[7].i);
+		break;
+	}
+
+	case VG_TRACE_BLIT_TEXTURE:
+	{
+		vgTexture dst = mapTexture(a[5].i);
+		if ((tex = mapTexture(a[0].i)) == VG_INVALID || dst == VG_INVALID)
+			return 0;
+		vgBlitTexture(tex, a[1].i, a[2].i, a[3].i, a[4].i, dst, a[6].i,
+			a[7].i, a[8].i, a[9].i, a[10].i);
+		break;
+	}
+
+	default:
+		return 0;
+	}
+
+	return 1;
+}
+
+/* plays the trace once, returns 0 if it is malformed or the window closed */
+static int replay(void)
+{
+	LARGE_INTEGER frameStart, before, after;
+	QueryPerformanceCounter(&frameStart);
+
+	size_t at = 0;
+	while (at + sizeof(vgTraceRecord) <= _traceSize)
+	{
+		vgTraceRecord record;
+		memcpy(&record, _trace + at, sizeof(record));
+		at += sizeof(record);
+
+		size_t argSize = record.argCount * sizeof(vgTraceArg);
+		if (record.argCount > VG_TRACE_ARGS_MAX ||
+			at + argSize + record.dataSize > _traceSize)
+			return 0;
+
+		vgTraceArg args[VG_TRACE_ARGS_MAX];
+		memcpy(args, _trace + at, argSize);
+		const unsigned char* data = _trace + at + argSize;
+		at += argSize + record.dataSize;
+
+		/* unknown or short calls are skipped, not fatal */
+		int op = record.op;
+		if (op <= 0 || op >= VG_TRACE_OPS || _ops[op].name == NULL ||
+			record.argCount < _ops[op].args)
+		{
+			_skipped++;
+			continue;
+		}
+
+		QueryPerformanceCounter(&before);
+		int made = execute(op, args, record.dataSize ? data : NULL,
+			record.dataSize);
+		QueryPerformanceCounter(&after);
+
+		if (!made)
+		{
+			_skipped++;
+			continue;
+		}
+
+		long long ticks = after.QuadPart - before.QuadPart;
+		_calls[op]++;
+		_ticks[op] += ticks;
+		_worst[op] = max(_worst[op], ticks);
+
+		if (op == VG_TRACE_SWAP)
+		{
+			frameAdd(args[0].i, after.QuadPart - frameStart.QuadPart);
+			frameStart = after;
+			if (vgWindowIsClosed()) return 0;
+		}
+	}
+
+	return 1;
+}
+
+/* REPORT FUNCTIONS */
+
+static int compareTicks(const void* a, const void* b)
+{
+	long long x = *(const long long*)a, y = *(const long long*)b;
+	return (x > y) - (x < y);
+}
+
+static int compareOps(const void* a, const void* b)
+{
+	long long x = _ticks[*(const int*)a], y = _ticks[*(const int*)b];
+	return (y > x) - (y < x);
+}
+
+static double toMs(long long ticks)
+{
+	return ticks * 1000.0 / _freq;
+}
+
+static void report(const char* csv)
+{
+	/* calls, most expensive in total first */
+	int order[VG_TRACE_OPS];
+	int used = 0;
+	long long total = 0;
+	for (int i = 1; i < VG_TRACE_OPS; i++)
+	{
+		if (_calls[i] == 0) continue;
+		order[used++] = i;
+		total += _ticks[i];
+	}
+	qsort(order, used, sizeof(int), compareOps);
+
+	printf("\n%-26s %10s %12s %10s %10s %6s\n", "call", "count",
+		"total ms", "mean us", "max us", "share");
+	for (int i = 0; i < used; i++)
+	{
+		int op = order[i];
+		printf("%-26s %10llu %12.3f %10.3f %10.3f %5.1f%%\n", _ops[op].name,
+			_calls[op], toMs(_ticks[op]),
+			toMs(_ticks[op]) * 1000.0 / _calls[op], toMs(_worst[op]) * 1000.0,
+			total ? _ticks[op] * 100.0 / total : 0.0);
+	}
+	if (_skipped) printf("%llu calls skipped\n", _skipped);
+
+	if (_frameCount == 0) return;
+
+	/* a trace's first swap has no previous one to measure from */
+	long long recordedSum = 0;
+	int recordedCount = 0;
+	for (int i = 0; i < _frameCount; i++)
+	{
+		recordedSum += _recorded[i];
+		recordedCount += _recorded[i] > 0;
+	}
+
+	long long* sorted = malloc(_frameCount * sizeof(long long));
+	if (sorted == NULL) return;
+	memcpy(sorted, _frames, _frameCount * sizeof(long long));
+	qsort(sorted, _frameCount, sizeof(long long), compareTicks);
+
+	long long sum = 0;
+	for (int i = 0; i < _frameCount; i++) sum += sorted[i];
+	double mean = toMs(sum) / _frameCount;
+
+	printf("\n%d frames, %.3f ms mean (%.1f fps)", _frameCount, mean,
+		mean > 0 ? 1000.0 / mean : 0.0);
+	if (recordedCount > 0)
+		printf(", recorded at %.3f ms mean",
+			recordedSum / 1000.0 / recordedCount);
+	printf("\n  p50 %.3f  p95 %.3f  p99 %.3f  max %.3f ms\n",
+		toMs(sorted[_frameCount * 50 / 100]),
+		toMs(sorted[_frameCount * 95 / 100]),
+		toMs(sorted[_frameCount * 99 / 100]),
+		toMs(sorted[_frameCount - 1]));
+	free(sorted);
+
+	if (csv == NULL) return;
+	FILE* out = fopen(csv, "w");
+	if (out == NULL)
+	{
+		printf("Could not write %s\n", csv);
+		return;
+	}
+	fprintf(out, "frame,recorded_ms,replayed_ms\n");
+	for (int i = 0; i < _frameCount; i++)
+		fprintf(out, "%d,%.3f,%.3f\n", i, _recorded[i] / 1000.0,
+			toMs(_frames[i]));
+	fclose(out);
+}
+
+/* ENTRY POINT */
+
+int main(int argc, char** argv)
+{
+	int loops = argc > 2 ? atoi(argv[2]) : 1;
+	if (argc < 2 || loops <= 0)
+	{
+		printf("Usage: VGReplay trace [loops] [frames.csv]\n");
+		return 1;
+	}
+	if (!traceLoad(argv[1]))
+	{
+		printf("%s is not a readable trace\n", argv[1]);
+		free(_trace);
+		return 1;
+	}
+
+	LARGE_INTEGER freq;
+	QueryPerformanceFrequency(&freq);
+	_freq = freq.QuadPart;
+
+	for (int i = 0; i < VG_TEXTURES_MAX; i++) _texMap[i] = VG_INVALID;
+	for (int i = 0; i < VG_SHAPES_MAX; i++) _shapeMap[i] = VG_INVALID;
+
+	vgInitRenderFormat(_header.renderFormat);
+	vgInit(_header.windowW, _header.windowH, _header.resolutionW,
+		_header.resolutionH, _header.linear);
+	vgSetWindowTitle("VGReplay");
+	vgUseRenderSkip(FALSE);
+	vgSetSwapTime(VG_SWAP_TIME_MIN);
+
+	printf("Replaying %s, %dx%d rendering at %dx%d\n", argv[1],
+		_header.windowW, _header.windowH, _header.resolutionW,
+		_header.resolutionH);
+
+	/* every loop starts from the same empty set of objects */
+	int complete = 1;
+	for (int i = 0; i < loops && complete; i++)
+	{
+		complete = replay();
+		releaseAll();
+	}
+	if (!complete && !vgWindowIsClosed())
+		printf("Trace is truncated or malformed, stopped early\n");
+
+	report(argc > 3 ? argv[3] : NULL);
+
+	vgTerminate();
+	free(_trace);
+	free(_scratch);
+	free(_recorded);
+	free(_frames);
+	return 0;
+}
@@ -0,0 +1,165 @@
+/******************************************************************************
+* <protocol.h>
+* Bailey Jia-Tao Brown
+* 2021
+*
+*	Shared memory protocol between VGServer and VGClient.dll
+*	Contents:
+*		- Header guard
+*		- Definitions
+*		- Shared layout
+*		- Commands
+*		- Ring functions
+*
+*	The server creates one lobby mapping and a ring per client slot. A
+*	client claims a slot by swapping its process id into the lobby, then
+*	streams commands into its ring, each a vgsCommand followed by size
+*	bytes of arguments. Every ring has one writer and one reader, so the
+*	head and tail counters are the only synchronisation needed, the
+*	events only wake the other side. A client dropped for a bad stream
+*	finds its id negated, the slot is only freed once it has exited.
+*
+******************************************************************************/
+
+#ifndef __VGSERVER_PROTOCOL_INCLUDE__
+#define __VGSERVER_PROTOCOL_INCLUDE__
+
+/* DEFINITIONS */
+#define VGS_VERSION      1
+#define VGS_CLIENTS_MAX  0x08
+#define VGS_RING_SIZE    0x400000
+#define VGS_ARGS_MAX     0x10000000
+#define VGS_TIMEOUT      0x64
+#define VGS_FRAMES_AHEAD 0x02
+#define VGS_TEXTURE_MAX  0x4000
+
+#define VGS_LOBBY_NAME   "VGServer.lobby"
+#define VGS_RING_NAME    "VGServer.ring.%d"
+#define VGS_DATA_NAME    "VGServer.data.%d"
+#define VGS_SPACE_NAME   "VGServer.space.%d"
+
+/* SHARED LAYOUT */
+typedef struct vgsLobby
+{
+	char magic[4];
+	unsigned int version;
+	unsigned int serverPid;
+	int resW, resH;
+	int windowW, windowH;
+	volatile long closed;
+	volatile long owner[VGS_CLIENTS_MAX]; /* negated once dropped */
+} vgsLobby;
+
+typedef struct vgsRing
+{
+	volatile long long head;   /* bytes written by the client */
+	volatile long long tail;   /* bytes consumed by the server */
+	volatile long frames;      /* swaps the server has executed */
+	volatile long reserved;
+	unsigned char data[VGS_RING_SIZE];
+} vgsRing;
+
+/* COMMANDS */
+typedef struct vgsCommand
+{
+	unsigned int op;
+	unsigned int size;
+} vgsCommand;
+
+enum
+{
+	VGS_DISCONNECT,
+	VGS_CLEAR,
+	VGS_FILL,
+	VGS_SWAP,
+	VGS_COLOR,
+	VGS_RECT,
+	VGS_RECTF,
+	VGS_LINE_SIZE,
+	VGS_LINE,
+	VGS_LINEF,
+	VGS_POINT_SIZE,
+	VGS_POINT,
+	VGS_POINTF,
+	VGS_VIEWPORT,
+	VGS_VIEWPORT_RESET,
+	VGS_CREATE_TEXTURE,
+	VGS_DESTROY_TEXTURE,
+	VGS_USE_TEXTURE,
+	VGS_TEXTURE_FILTER,
+	VGS_TEXTURE_FILTER_RESET,
+	VGS_RECT_TEXTURE,
+	VGS_RECT_TEXTURE_OFFSET,
+	VGS_COMPILE_SHAPE,
+	VGS_DESTROY_SHAPE,
+	VGS_DRAW_SHAPE,
+	VGS_DRAW_SHAPE_TEXTURED,
+	VGS_RENDER_SCALE,
+	VGS_USE_RENDER_SCALING,
+	VGS_RENDER_OFFSET,
+	VGS_USE_RENDER_OFFSET,
+	VGS_RENDER_LAYER,
+	VGS_OP_COUNT
+};
+
+/* arguments are packed 32 bit values, texture and shape data follow */
+typedef union vgsArg
+{
+	int i;
+	float f;
+} vgsArg;
+
+/* RING FUNCTIONS */
+
+/* copies in or out of the ring, wrapping at the end */
+static inline void vgsRingCopy(vgsRing* ring, long long pos, void* data,
+	unsigned int size, int write)
+{
+	unsigned int at = (unsigned int)(pos % VGS_RING_SIZE);
+	unsigned int first = VGS_RING_SIZE - at < size ? VGS_RING_SIZE - at :
+		size;
+	unsigned char* bytes = data;
+
+	if (write)
+	{
+		memcpy(ring->data + at, bytes, first);
+		memcpy(ring->data, bytes + first, size - first);
+	}
+	else
+	{
+		memcpy(bytes, ring->data + at, first);
+		memcpy(bytes + first, ring->data, size - first);
+	}
+}
+
+static inline unsigned int vgsRingSpace(vgsRing* ring)
+{
+	return (unsigned int)(VGS_RING_SIZE - (ring->head - ring->tail));
+}
+
+static inline unsigned int vgsRingAvailable(vgsRing* ring)
+{
+	return (unsigned int)(ring->head - ring->tail);
+}
+
+/* bytes per texture at level 0, matches vgFormatSize */
+static inline int vgsFormatSize(int format, int w, int h)
+{
+	static const int bytes[9] = { 4, 1, 2, 2, 2, 2, 3, 8, 16 };
+	if (format < 0 || format >= 9) return 0;
+	if (w <= 0 || h <= 0 || w > VGS_TEXTURE_MAX || h > VGS_TEXTURE_MAX)
+		return 0;
+	if (format >= 7) return bytes[format] * ((w + 3) / 4) * ((h + 3) / 4);
+	return bytes[format] * w * h;
+}
+
+/* bytes a texture upload carries, uncompressed formats are always sent */
+/* as RGBA8 and converted by the server, compressed ones as blocks */
+static inline unsigned long long vgsTextureSize(int format, int w, int h)
+{
+	if (vgsFormatSize(format, w, h) == 0) return 0;
+	if (format >= 7) return (unsigned long long)vgsFormatSize(format, w, h);
+	return (unsigned long long)w * h * 4;
+}
+
+#endif
@@ -0,0 +1,655 @@
+/******************************************************************************
+* <server.c>
+* Bailey Jia-Tao Brown
+* 2021
+*
+*	Render server, executes commands from VGClient.dll processes
+*	Contents:
+*		- Preprocessor defs
+*		- Includes
+*		- Definitions
+*		- Server data
+*		- Client functions
+*		- Command execution
+*		- Entry point
+*
+*	Usage:
+*		VGServer [clients] [width height]
+*
+*	Every client slot gets a tile of the window, laid out in a grid. A
+*	client draws in the server's coordinates and its viewport is scaled
+*	into its tile. Clients that exit or crash are dropped along with
+*	their textures and shapes, the server and the other clients go on.
+*	Each client may hold an even share of the texture and shape tables,
+*	anything it creates past that is refused and draws with it skip.
+*
+******************************************************************************/
+
+/* PREPROCESSOR DEFS */
+#define _CRT_SECURE_NO_WARNINGS
+#define WIN32_LEAN_AND_MEAN
+
+/* INCLUDES */
+#include <stdio.h>  /* I/O */
+#include <stdlib.h> /* Memory allocation */
+#include <string.h> /* Memory copying */
+#include <math.h>   /* Grid layout */
+
+#include <Windows.h> /* Shared memory and processes */
+
+#include "graphics.h" /* Renderer */
+#include "protocol.h" /* Command ring */
+
+/* DEFINITIONS */
+#define DEFAULT_CLIENTS 4
+#define DEFAULT_WIDTH   1280
+#define DEFAULT_HEIGHT  720
+
+/* work a client may do per server frame before the next one gets a turn */
+#define BUDGET_COMMANDS 0x4000
+#define BUDGET_BYTES    0x1000000
+
+/* SERVER DATA */
+static HANDLE    _lobbyMapping = NULL;
+static vgsLobby* _lobby = NULL;
+static int _clients = 0;
+static int _cols, _rows;
+static int _resW, _resH;
+
+static HANDLE  _ringMapping[VGS_CLIENTS_MAX] = { 0 };
+static vgsRing* _ring[VGS_CLIENTS_MAX] = { 0 };
+static HANDLE  _dataEvent[VGS_CLIENTS_MAX] = { 0 };
+static HANDLE  _spaceEvent[VGS_CLIENTS_MAX] = { 0 };
+static HANDLE  _process[VGS_CLIENTS_MAX] = { 0 };
+static long    _pid[VGS_CLIENTS_MAX] = { 0 };
+
+/* client handles map onto server handles, VG_INVALID if unused */
+static vgTexture _texMap[VGS_CLIENTS_MAX][VG_TEXTURES_MAX];
+static vgShape   _shapeMap[VGS_CLIENTS_MAX][VG_SHAPES_MAX];
+
+/* every client shares the library's tables, so each gets a fair share */
+static int _texHeld[VGS_CLIENTS_MAX];
+static int _shapeHeld[VGS_CLIENTS_MAX];
+
+/* render state is global in the library, so each client's copy is */
+/* put back before its commands run */
+typedef struct clientState
+{
+	int color[4];
+	int filter[4];
+	float lineSize;
+	float pointSize;
+	int viewport[4];
+	float scale;
+	int useScale;
+	float offset[2];
+	int useOffset;
+	float layer;
+	int texture;
+} clientState;
+
+static clientState _state[VGS_CLIENTS_MAX];
+
+/* commands may arrive over several server frames, what has been read */
+/* of the current one is kept until the rest is there */
+static vgsCommand _cmd[VGS_CLIENTS_MAX];
+static unsigned int _cmdRead[VGS_CLIENTS_MAX];
+static unsigned char* _args[VGS_CLIENTS_MAX] = { 0 };
+static unsigned int _argsCap[VGS_CLIENTS_MAX] = { 0 };
+
+/* the ring lives in memory the client can write, so the server keeps */
+/* its own read position and checks the client's head against it */
+static long long _tail[VGS_CLIENTS_MAX] = { 0 };
+
+/* CLIENT FUNCTIONS */
+
+static void tileRect(int c, int* x, int* y, int* w, int* h)
+{
+	/* slot 0 is the top left tile */
+	*w = _resW / _cols;
+	*h = _resH / _rows;
+	*x = (c % _cols) * *w;
+	*y = _resH - (c / _cols + 1) * *h;
+}
+
+static void tileViewport(int c)
+{
+	int tx, ty, tw, th;
+	tileRect(c, &tx, &ty, &tw, &th);
+
+	const int* vp = _state[c].viewport;
+	vgViewport(tx + vp[0] * tw / _resW, ty + vp[1] * th / _resH,
+		vp[2] * tw / _resW, vp[3] * th / _resH);
+}
+
+static void clientReset(int c)
+{
+	clientState* s = &_state[c];
+	memset(s, 0, sizeof(clientState));
+	for (int i = 0; i < 4; i++) s->filter[i] = 255;
+	s->lineSize = 1;
+	s->pointSize = 1;
+	s->viewport[2] = _resW;
+	s->viewport[3] = _resH;
+	s->scale = 1;
+	s->useScale = TRUE;
+	s->useOffset = TRUE;
+	s->texture = VG_INVALID;
+
+	for (int i = 0; i < VG_TEXTURES_MAX; i++) _texMap[c][i] = VG_INVALID;
+	for (int i = 0; i < VG_SHAPES_MAX; i++) _shapeMap[c][i] = VG_INVALID;
+	_texHeld[c] = 0;
+	_shapeHeld[c] = 0;
+	_cmdRead[c] = 0;
+}
+
+static void clientForgetTexture(int c, int handle)
+{
+	if (_texMap[c][handle] == VG_INVALID) return;
+	vgDestroyTexture(_texMap[c][handle]);
+	_texMap[c][handle] = VG_INVALID;
+	_texHeld[c]--;
+}
+
+static void clientForgetShape(int c, int handle)
+{
+	if (_shapeMap[c][handle] == VG_INVALID) return;
+	vgDestroyShape(_shapeMap[c][handle]);
+	_shapeMap[c][handle] = VG_INVALID;
+	_shapeHeld[c]--;
+}
+
+static void clientApply(int c)
+{
+	clientState* s = &_state[c];
+	vgColor4(s->color[0], s->color[1], s->color[2], s->color[3]);
+	vgTextureFilter(s->filter[0], s->filter[1], s->filter[2], s->filter[3]);
+	vgLineSize(s->lineSize);
+	vgPointSize(s->pointSize);
+	vgRenderScale(s->scale);
+	vgUseRenderScaling(s->useScale);
+	vgRenderOffset(s->offset[0], s->offset[1]);
+	vgUseRenderOffset(s->useOffset);
+	vgRenderLayer(s->layer);
+	if (s->texture != VG_INVALID && _texMap[c][s->texture] != VG_INVALID)
+		vgUseTexture(_texMap[c][s->texture]);
+	tileViewport(c);
+}
+
+static void clientRelease(int c)
+{
+	if (_process[c]) CloseHandle(_process[c]);
+	_process[c] = NULL;
+
+	/* the ring must be empty before the slot can be claimed again */
+	_ring[c]->head = 0;
+	_ring[c]->tail = 0;
+	_ring[c]->frames = 0;
+	_tail[c] = 0;
+	InterlockedExchange(&_lobby->owner[c], 0);
+}
+
+static void clientDrop(int c, int stale)
+{
+	for (int i = 0; i < VG_TEXTURES_MAX; i++) clientForgetTexture(c, i);
+	for (int i = 0; i < VG_SHAPES_MAX; i++) clientForgetShape(c, i);
+	clientReset(c);
+	free(_args[c]);
+	_args[c] = NULL;
+	_argsCap[c] = 0;
+
+	/* blank its tile so the next client starts clean */
+	int x, y, w, h;
+	tileRect(c, &x, &y, &w, &h);
+	vgFillRegion(x, y, w, h, 0, 0, 0);
+
+	/* a client dropped for bad commands may still be writing into the */
+	/* ring, the slot stays taken until it exits, a negated owner tells */
+	/* it that it was dropped */
+	long pid = _pid[c];
+	_pid[c] = 0;
+	if (stale && _process[c] &&
+		WaitForSingleObject(_process[c], 0) == WAIT_TIMEOUT)
+	{
+		InterlockedExchange(&_lobby->owner[c], -pid);
+		return;
+	}
+	clientRelease(c);
+}
+
+static void clientAccept(void)
+{
+	for (int c = 0; c < _clients; c++)
+	{
+		if (_pid[c] != 0) continue;
+
+		/* a dropped client gives its slot back once it has exited */
+		if (_process[c])
+		{
+			if (WaitForSingleObject(_process[c], 0) != WAIT_TIMEOUT)
+				clientRelease(c);
+			continue;
+		}
+
+		long owner = _lobby->owner[c];
+		if (owner <= 0) continue;
+
+		/* the process handle tells us when the client goes away */
+		clientReset(c);
+		_pid[c] = owner;
+		_process[c] = OpenProcess(SYNCHRONIZE, FALSE, owner);
+		if (_process[c] == NULL) clientDrop(c, FALSE);
+	}
+}
+
+static int clientAlive(int c)
+{
+	return WaitForSingleObject(_process[c], 0) == WAIT_TIMEOUT;
+}
+
+/* copies whatever part of size has arrived, never waits, -1 if the */
+/* client's head can't be right */
+static int clientRead(int c, void* dst, unsigned int size)
+{
+	vgsRing* ring = _ring[c];
+	long long ahead = ring->head - _tail[c];
+	if (ahead < 0 || ahead > VGS_RING_SIZE) return -1;
+
+	/* ahead never exceeds the ring, so neither does a chunk */
+	unsigned int chunk = min((unsigned int)ahead, size);
+	if (chunk == 0) return 0;
+
+	vgsRingCopy(ring, _tail[c], dst, chunk, FALSE);
+	_tail[c] += chunk;
+	InterlockedExchange64(&ring->tail, _tail[c]);
+	SetEvent(_spaceEvent[c]);
+	return (int)chunk;
+}
+
+/* COMMAND EXECUTION */
+
+/* returns 1 once a frame is complete, 2 when there is more to do than */
+/* one server frame allows, 0 when the ring ran dry, -1 when the */
+/* client has to be dropped and -2 when it disconnected */
+static int clientExecute(int c)
+{
+	clientState* s = &_state[c];
+	vgsRing* ring = _ring[c];
+	vgsCommand cmd;
+	unsigned int commands = 0, bytes = 0;
+
+	while (commands < BUDGET_COMMANDS && bytes < BUDGET_BYTES)
+	{
+		/* header first, then its arguments, either may be cut short by */
+		/* a full ring or a stalled client and is picked up next frame */
+		unsigned int read = _cmdRead[c];
+		int got;
+		if (_cmdRead[c] < sizeof(vgsCommand))
+		{
+			got = clientRead(c, (unsigned char*)&_cmd[c] + _cmdRead[c],
+				sizeof(vgsCommand) - _cmdRead[c]);
+			if (got < 0) return -1;
+			_cmdRead[c] += got;
+			if (_cmdRead[c] < sizeof(vgsCommand))
+				return _cmdRead[c] > read ? 2 : 0;
+
+			cmd = _cmd[c];
+			if (cmd.op >= VGS_OP_COUNT || cmd.size > VGS_ARGS_MAX) return -1;
+			if (cmd.size > _argsCap[c])
+			{
+				unsigned char* args = realloc(_args[c], cmd.size);
+				if (args == NULL) return -1;
+				_args[c] = args;
+				_argsCap[c] = cmd.size;
+			}
+		}
+		else cmd = _cmd[c];
+
+		unsigned int done = _cmdRead[c] - sizeof(vgsCommand);
+		got = clientRead(c, _args[c] + done, cmd.size - done);
+		if (got < 0) return -1;
+		_cmdRead[c] += got;
+		if (_cmdRead[c] < sizeof(vgsCommand) + cmd.size)
+			return _cmdRead[c] > read ? 2 : 0;
+		_cmdRead[c] = 0;
+		commands++;
+		bytes += sizeof(vgsCommand) + cmd.size;
+
+		/* fixed arguments come first, anything short is malformed */
+		static const unsigned char argCount[VGS_OP_COUNT] = { 0, 0, 3, 0,
+			4, 4, 4, 1, 4, 4, 1, 2, 2, 4, 0, 7, 1, 1, 4, 0, 4, 6, 3, 1, 5,
+			5, 1, 1, 2, 1, 1 };
+		if (cmd.size < argCount[cmd.op] * sizeof(vgsArg)) return -1;
+
+		const vgsArg* a = (const vgsArg*)_args[c];
+		int x, y, w, h;
+		vgTexture tex = s->texture == VG_INVALID ? VG_INVALID :
+			_texMap[c][s->texture];
+
+		switch (cmd.op)
+		{
+		case VGS_DISCONNECT:
+			return -2;
+
+		case VGS_CLEAR:
+		case VGS_FILL:
+			tileRect(c, &x, &y, &w, &h);
+			if (cmd.op == VGS_CLEAR) vgFillRegion(x, y, w, h, 0, 0, 0);
+			else vgFillRegion(x, y, w, h, a[0].i, a[1].i, a[2].i);
+			break;
+
+		case VGS_SWAP:
+			InterlockedIncrement(&ring->frames);
+			return 1;
+
+		case VGS_COLOR:
+			for (int i = 0; i < 4; i++) s->color[i] = a[i].i;
+			vgColor4(a[0].i, a[1].i, a[2].i, a[3].i);
+			break;
+
+		case VGS_RECT:
+			vgRect(a[0].i, a[1].i, a[2].i, a[3].i);
+			break;
+
+		case VGS_RECTF:
+			vgRectf(a[0].f, a[1].f, a[2].f, a[3].f);
+			break;
+
+		case VGS_LINE_SIZE:
+			s->lineSize = a[0].f;
+			vgLineSize(a[0].f);
+			break;
+
+		case VGS_LINE:
+			vgLine(a[0].i, a[1].i, a[2].i, a[3].i);
+			break;
+
+		case VGS_LINEF:
+			vgLinef(a[0].f, a[1].f, a[2].f, a[3].f);
+			break;
+
+		case VGS_POINT_SIZE:
+			s->pointSize = a[0].f;
+			vgPointSize(a[0].f);
+			break;
+
+		case VGS_POINT:
+			vgPoint(a[0].i, a[1].i);
+			break;
+
+		case VGS_POINTF:
+			vgPointf(a[0].f, a[1].f);
+			break;
+
+		case VGS_VIEWPORT:
+			for (int i = 0; i < 4; i++) s->viewport[i] = a[i].i;
+			tileViewport(c);
+			break;
+
+		case VGS_VIEWPORT_RESET:
+			s->viewport[0] = 0;
+			s->viewport[1] = 0;
+			s->viewport[2] = _resW;
+			s->viewport[3] = _resH;
+			tileViewport(c);
+			break;
+
+		case VGS_CREATE_TEXTURE:
+		{
+			/* handle, w, h, linear, repeat, format, has data, texels */
+			/* the library reads RGBA8 for every uncompressed format */
+			int handle = a[0].i, format = a[5].i;
+			unsigned long long size = vgsTextureSize(format, a[1].i, a[2].i);
+			if (handle < 0 || handle >= VG_TEXTURES_MAX || size == 0 ||
+				(a[6].i && cmd.size < 7 * sizeof(vgsArg) + size))
+				return -1;
+
+			/* over its share, the handle stays unmapped and draws skip */
+			clientForgetTexture(c, handle);
+			if (_texHeld[c] >= VG_TEXTURES_MAX / _clients) break;
+
+			void* data = a[6].i ? _args[c] + 7 * sizeof(vgsArg) : NULL;
+			if (format == VG_FORMAT_BC1 || format == VG_FORMAT_BC3)
+				_texMap[c][handle] = vgCreateTextureCompressed(a[1].i, a[2].i,
+					a[3].i, a[4].i, format, data);
+			else
+				_texMap[c][handle] = vgCreateTextureFormat(a[1].i, a[2].i,
+					a[3].i, a[4].i, format, data);
+			if (_texMap[c][handle] != VG_INVALID) _texHeld[c]++;
+			break;
+		}
+
+		case VGS_DESTROY_TEXTURE:
+			if (a[0].i < 0 || a[0].i >= VG_TEXTURES_MAX) return -1;
+			clientForgetTexture(c, a[0].i);
+			break;
+
+		case VGS_USE_TEXTURE:
+			if (a[0].i < 0 || a[0].i >= VG_TEXTURES_MAX) return -1;
+			s->texture = a[0].i;
+			if (_texMap[c][a[0].i] != VG_INVALID)
+				vgUseTexture(_texMap[c][a[0].i]);
+			break;
+
+		case VGS_TEXTURE_FILTER:
+			for (int i = 0; i < 4; i++) s->filter[i] = a[i].i;
+			vgTextureFilter(a[0].i, a[1].i, a[2].i, a[3].i);
+			break;
+
+		case VGS_TEXTURE_FILTER_RESET:
+			for (int i = 0; i < 4; i++) s->filter[i] = 255;
+			vgTextureFilterReset();
+			break;
+
+		/* textured draws without a live texture are skipped */
+		case VGS_RECT_TEXTURE:
+			if (tex != VG_INVALID)
+				vgRectTexture(a[0].i, a[1].i, a[2].i, a[3].i);
+			break;
+
+		case VGS_RECT_TEXTURE_OFFSET:
+			if (tex != VG_INVALID)
+				vgRectTextureOffset(a[0].i, a[1].i, a[2].i, a[3].i, a[4].f,
+					a[5].f);
+			break;
+
+		case VGS_COMPILE_SHAPE:
+		{
+			/* handle, vertices, textured, positions, texcoords */
+			int handle = a[0].i, count = a[1].i;
+			unsigned int floats = count * (a[2].i ? 4 : 2);
+			if (handle < 0 || handle >= VG_SHAPES_MAX || count < 0 ||
+				count > VGS_ARGS_MAX / 16 ||
+				cmd.size < (3 + floats) * sizeof(vgsArg))
+				return -1;
+
+			clientForgetShape(c, handle);
+			if (_shapeHeld[c] >= VG_SHAPES_MAX / _clients) break;
+
+			float* f2d = (float*)(a + 3);
+			if (a[2].i)
+				_shapeMap[c][handle] = vgCompileShapeTextured(f2d,
+					f2d + count * 2, count);
+			else
+				_shapeMap[c][handle] = vgCompileShape(f2d, count);
+			if (_shapeMap[c][handle] != VG_INVALID) _shapeHeld[c]++;
+			break;
+		}
+
+		case VGS_DESTROY_SHAPE:
+			if (a[0].i < 0 || a[0].i >= VG_SHAPES_MAX) return -1;
+			clientForgetShape(c, a[0].i);
+			break;
+
+		case VGS_DRAW_SHAPE:
+		case VGS_DRAW_SHAPE_TEXTURED:
+			if (a[0].i < 0 || a[0].i >= VG_SHAPES_MAX) return -1;
+			if (_shapeMap[c][a[0].i] == VG_INVALID) break;
+			if (cmd.op == VGS_DRAW_SHAPE)
+				vgDrawShape(_shapeMap[c][a[0].i], a[1].f, a[2].f, a[3].f,
+					a[4].f);
+			else if (tex != VG_INVALID)
+				vgDrawShapeTextured(_shapeMap[c][a[0].i], a[1].f, a[2].f,
+					a[3].f, a[4].f);
+			break;
+
+		case VGS_RENDER_SCALE:
+			s->scale = a[0].f;
+			vgRenderScale(a[0].f);
+			break;
+
+		case VGS_USE_RENDER_SCALING:
+			s->useScale = a[0].i;
+			vgUseRenderScaling(a[0].i);
+			break;
+
+		case VGS_RENDER_OFFSET:
+			s->offset[0] = a[0].f;
+			s->offset[1] = a[1].f;
+			vgRenderOffset(a[0].f, a[1].f);
+			break;
+
+		case VGS_USE_RENDER_OFFSET:
+			s->useOffset = a[0].i;
+			vgUseRenderOffset(a[0].i);
+			break;
+
+		case VGS_RENDER_LAYER:
+			s->layer = a[0].f;
+			vgRenderLayer(a[0].f);
+			break;
+		}
+	}
+
+	return 2;
+}
+
+static int serverOpen(void)
+{
+	_lobbyMapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL,
+		PAGE_READWRITE, 0, sizeof(vgsLobby), VGS_LOBBY_NAME);
+	if (_lobbyMapping == NULL || GetLastError() == ERROR_ALREADY_EXISTS)
+	{
+		printf("Another server is already running\n");
+		return FALSE;
+	}
+	_lobby = MapViewOfFile(_lobbyMapping, FILE_MAP_ALL_ACCESS, 0, 0,
+		sizeof(vgsLobby));
+	if (_lobby == NULL) return FALSE;
+
+	for (int c = 0; c < _clients; c++)
+	{
+		char name[MAX_PATH];
+		sprintf(name, VGS_RING_NAME, c);
+		_ringMapping[c] = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL,
+			PAGE_READWRITE, 0, sizeof(vgsRing), name);
+		if (_ringMapping[c] == NULL) return FALSE;
+		_ring[c] = MapViewOfFile(_ringMapping[c], FILE_MAP_ALL_ACCESS, 0, 0,
+			sizeof(vgsRing));
+		if (_ring[c] == NULL) return FALSE;
+
+		sprintf(name, VGS_DATA_NAME, c);
+		_dataEvent[c] = CreateEventA(NULL, FALSE, FALSE, name);
+		sprintf(name, VGS_SPACE_NAME, c);
+		_spaceEvent[c] = CreateEventA(NULL, FALSE, FALSE, name);
+		if (_dataEvent[c] == NULL || _spaceEvent[c] == NULL) return FALSE;
+
+		clientReset(c);
+	}
+
+	_lobby->version = VGS_VERSION;
+	_lobby->serverPid = GetCurrentProcessId();
+	_lobby->resW = _resW;
+	_lobby->resH = _resH;
+	_lobby->windowW = _resW;
+	_lobby->windowH = _resH;
+
+	/* clients that see the magic see everything above */
+	MemoryBarrier();
+	memcpy(_lobby->magic, "VGSV", 4);
+	return TRUE;
+}
+
+static void serverClose(void)
+{
+	if (_lobby) InterlockedExchange(&_lobby->closed, TRUE);
+
+	for (int c = 0; c < _clients; c++)
+	{
+		if (_process[c]) CloseHandle(_process[c]);
+		if (_ring[c]) UnmapViewOfFile(_ring[c]);
+		if (_ringMapping[c]) CloseHandle(_ringMapping[c]);
+		if (_dataEvent[c]) CloseHandle(_dataEvent[c]);
+		if (_spaceEvent[c]) CloseHandle(_spaceEvent[c]);
+		free(_args[c]);
+	}
+
+	if (_lobby) UnmapViewOfFile(_lobby);
+	if (_lobbyMapping) CloseHandle(_lobbyMapping);
+}
+
+/* ENTRY POINT */
+
+int main(int argc, char** argv)
+{
+	_clients = argc > 1 ? atoi(argv[1]) : DEFAULT_CLIENTS;
+	_clients = min(max(_clients, 1), VGS_CLIENTS_MAX);
+	_resW = argc > 3 ? atoi(argv[2]) : DEFAULT_WIDTH;
+	_resH = argc > 3 ? atoi(argv[3]) : DEFAULT_HEIGHT;
+	if (_resW <= 0 || _resH <= 0)
+	{
+		printf("Usage: VGServer [clients] [width height]\n");
+		return 1;
+	}
+
+	_cols = (int)ceil(sqrt((double)_clients));
+	_rows = (_clients + _cols - 1) / _cols;
+
+	vgInit(_resW, _resH, _resW, _resH, FALSE);
+	vgSetWindowTitle("VGServer");
+
+	/* client commands always run, pacing is done by the clients */
+	vgUseRenderSkip(FALSE);
+	vgSetSwapTime(VG_SWAP_TIME_MIN);
+	vgClear();
+
+	if (!serverOpen())
+	{
+		serverClose();
+		vgTerminate();
+		return 1;
+	}
+	printf("VGServer running, %d clients at %dx%d\n", _clients, _resW,
+		_resH);
+
+	while (!vgWindowIsClosed())
+	{
+		vgUpdate();
+		clientAccept();
+
+		/* at most one frame and one budget per client per server frame */
+		int frames = 0, busy = FALSE;
+		for (int c = 0; c < _clients; c++)
+		{
+			if (_pid[c] == 0) continue;
+
+			clientApply(c);
+			int result = clientExecute(c);
+			if (result < 0 || (result == 0 && !clientAlive(c)))
+			{
+				printf("Client %d (process %ld) dropped\n", c, _pid[c]);
+				clientDrop(c, result == -1);
+			}
+			else if (result == 1) frames++;
+			else if (result == 2) busy = TRUE;
+		}
+
+		if (frames > 0) vgSwap();
+		else if (!busy) WaitForMultipleObjects(_clients, _dataEvent, FALSE,
+			VGS_TIMEOUT);
+	}
+
+	serverClose();
+	vgTerminate();
+	return 0;
+}
@@ -19,8 +19,22 @@
 *		- Advanced draw functions
 *		- ITex functions
 *		- Texture editing functions
+*		- Texture compression functions
+*		- Large image functions
 *		- Input related functions
 *		- Texture loading and saving functions
+*		- Image import functions
+*		- Hot reload functions
+*		- Archive functions
+*		- Upload thread functions
+*		- Capture functions
+*		- Screenshot functions
+*		- Trace functions
+*		- Profile functions
+*		- Frame statistics functions
+*		- Overdraw functions
+*		- HUD functions
+*		- Validation functions
 *		- Debug functions
 *
 ******************************************************************************/
@@ -33,17 +47,60 @@
 /* INCLUDES */
 #include <stdio.h> /* I/O */
 #include <stdlib.h> /* Memory allocation */
+#include <string.h> /* Memory copying */
+#include <stdarg.h> /* Variable arguments */
 
 #include <Windows.h> /* OpenGL dependency */
 
 #include <glew.h>  /* OpenGL extension library */
 #include <gl/GL.h> /* Graphics library */
 #include <math.h>  /* Math functions */
+#include <emmintrin.h> /* SSE2 intrinsics */
 
 #include "graphics.h" /* Header */
 
 /* DEFINITIONS */
 #define RENDERSKIP(and) if (_renderSkip && and) return
+#define FORMAT_COUNT 9
+#define TEXTURE_SIZE_MAX 0x4000 /* keeps w * h * 4 in a 32-bit size_t */
+#define ENCODE_THREADS_MAX 0x10
+#define LARGE_CACHE_TILES (VG_LARGE_CACHE_SIZE / VG_LARGE_TILE_SIZE)
+#define LARGE_SLOTS (LARGE_CACHE_TILES * LARGE_CACHE_TILES)
+#define LARGE_LEVELS_MAX 0x20
+#define CAPTURE_FREE    0
+#define CAPTURE_READING 1
+#define CAPTURE_MAPPED  2
+#define CAPTURE_WRITTEN 3
+#define SHOT_FREE     0
+#define SHOT_READING  1
+#define SHOT_ENCODING 2
+#define SHOT_DONE     3
+#define TRACING() ((_traceFile != NULL || _hitchOn) && !_traceMute)
+#define TRACE(op, ...) do { VALIDATE_CALL(); \
+	if (TRACING()) traceCall(op, NULL, 0, __VA_ARGS__); } while (0)
+#define TRACE_DATA(op, data, size, ...) do { VALIDATE_CALL(); \
+	if (TRACING()) traceCall(op, data, size, __VA_ARGS__); } while (0)
+#define HITCH_FRAME_RING 0x10
+#define HUD_SAMPLES 0x80
+#define HUD_SCALE   2
+
+/* validation is compiled in with VG_VALIDATE, otherwise the checks */
+/* and their arguments vanish entirely */
+#ifdef VG_VALIDATE
+#define VALIDATE_CALL() validateCall(__func__)
+#define VALIDATE(cond, kind, ...) do { if (!(cond)) \
+	{ validateReport(kind, __func__, __VA_ARGS__); return; } } while (0)
+#define VALIDATE_OR(ret, cond, kind, ...) do { if (!(cond)) \
+	{ validateReport(kind, __func__, __VA_ARGS__); return ret; } } while (0)
+#else
+#define VALIDATE_CALL() ((void)0)
+#define VALIDATE(cond, kind, ...)
+#define VALIDATE_OR(ret, cond, kind, ...)
+#endif
+#define PROFILE_BEGIN(name) do { if (_profRunning) \
+	profileEvent(name, 'B', FALSE); } while (0)
+#define PROFILE_END() do { if (_profRunning) \
+	profileEvent(NULL, 'E', FALSE); } while (0)
 
 /* ========INTERNAL RESOURCES======== */
 
@@ -55,6 +112,8 @@ static HGLRC _glContext;
 static GLuint _framebuffer;
 static GLuint _texture;
 static GLuint _depth;
+static int _renderFormat = VG_FORMAT_RGB8;
+static int _renderLinear;
 
 static int _swapTime;
 static int _renderSkip;
@@ -77,6 +136,54 @@ static int _useROffset;
 static GLuint _texBuffer[VG_TEXTURES_MAX] = { 0 };
 static int _texCount = 0;
 static GLuint _shapeBuffer[VG_SHAPES_MAX] = { 0 };
+static float* _shapeData[VG_SHAPES_MAX] = { 0 }; /* for trace snapshots */
+static int _shapeSize[VG_SHAPES_MAX] = { 0 };
+static int _shapeTextured[VG_SHAPES_MAX] = { 0 };
+static int _texWidth[VG_TEXTURES_MAX]  = { 0 };
+static int _texHeight[VG_TEXTURES_MAX] = { 0 };
+static int _texLevels[VG_TEXTURES_MAX] = { 0 };
+static int _texFormat[VG_TEXTURES_MAX] = { 0 };
+static int _texLayers[VG_TEXTURES_MAX] = { 0 }; /* 0 for plain 2D */
+static int _cpuMipmaps = FALSE;
+
+/* texture recycling data */
+/* destroyed textures wait in the defer queue until the frame that */
+/* last used them has been retired by the GPU, then move to the pool */
+/* frames below _retiredFrame are known to be finished on the GPU */
+static int _usePool = TRUE;
+static GLuint _deferName[VG_DEFER_MAX] = { 0 };
+static int _deferW[VG_DEFER_MAX] = { 0 };
+static int _deferH[VG_DEFER_MAX] = { 0 };
+static int _deferLevels[VG_DEFER_MAX] = { 0 };
+static int _deferFormat[VG_DEFER_MAX] = { 0 };
+static int _deferLayers[VG_DEFER_MAX] = { 0 };
+static unsigned long long _deferFrame[VG_DEFER_MAX] = { 0 };
+static int _deferCount = 0;
+static GLuint _poolName[VG_TEXPOOL_MAX] = { 0 };
+static int _poolW[VG_TEXPOOL_MAX] = { 0 };
+static int _poolH[VG_TEXPOOL_MAX] = { 0 };
+static int _poolLevels[VG_TEXPOOL_MAX] = { 0 };
+static int _poolFormat[VG_TEXPOOL_MAX] = { 0 };
+static int _poolCount = 0;
+
+/* texture format data, indexed by VG_FORMAT_* */
+/* compressed formats store bytes per 4x4 block in _fmtBytes */
+static const GLenum _fmtInternal[FORMAT_COUNT] = { GL_RGBA8, GL_ALPHA8,
+	GL_RG8, GL_RGB565, GL_RGBA4, GL_RGB5_A1, GL_RGB8,
+	GL_COMPRESSED_RGBA_S3TC_DXT1_EXT, GL_COMPRESSED_RGBA_S3TC_DXT5_EXT };
+static const GLenum _fmtUpload[FORMAT_COUNT] = { GL_RGBA, GL_ALPHA,
+	GL_RG, GL_RGB, GL_RGBA, GL_RGBA, GL_RGB, GL_RGBA, GL_RGBA };
+static const GLenum _fmtType[FORMAT_COUNT] = { GL_UNSIGNED_BYTE,
+	GL_UNSIGNED_BYTE, GL_UNSIGNED_BYTE, GL_UNSIGNED_SHORT_5_6_5,
+	GL_UNSIGNED_SHORT_4_4_4_4, GL_UNSIGNED_SHORT_5_5_5_1,
+	GL_UNSIGNED_BYTE, GL_UNSIGNED_BYTE, GL_UNSIGNED_BYTE };
+static const int _fmtBytes[FORMAT_COUNT] = { 4, 1, 2, 2, 2, 2, 3, 8, 16 };
+
+/* frame fence data */
+static unsigned long long _frames = 0;
+static unsigned long long _retiredFrame = 0;
+static GLsync _fenceSync[VG_FENCE_RING] = { 0 };
+static unsigned long long _fenceFrame[VG_FENCE_RING] = { 0 };
 
 /* update data */
 static unsigned long long _updates = 0;
@@ -87,6 +194,7 @@ static int _tcolR, _tcolG, _tcolB, _tcolA = 255;
 static float _lineW = 1;
 static float _pointW = 1;
 static vgTexture _useTex;
+static int _useLayer;
 
 /* itex data */
 static unsigned char _icolorR[VG_ITEX_COLORS_MAX] = { 0 };
@@ -99,10 +207,309 @@ static unsigned short _indexes[VG_ITEX_SIZE_MAX][VG_ITEX_SIZE_MAX] = { 0 };
 static vgTexture _eTex;
 static GLuint    _eFrameBuffer = 0;
 static GLuint    _rFrameBuffer = 0;
+static GLuint    _bFrameBuffer = 0;
+static GLuint    _readAttached = 0;
+static int       _readLayer = 0;
+static int       _readComplete = FALSE;
+static GLuint    _blitAttached = 0;
+static int       _blitLayer = 0;
+static int       _blitComplete = FALSE;
 static int _ecolR, _ecolG, _ecolB, _ecolA = 0;
 static int _eWidth, _eHeight = 0;
 static vgTexture _euTex;
 
+/* large image data */
+/* source texels stay in the mapped file, tiles are paged into one cache */
+/* texture per image, slots are keyed by (level, x, y) and evicted LRU */
+static HANDLE _lgFile[VG_LARGE_IMAGES_MAX] = { 0 };
+static HANDLE _lgMapping[VG_LARGE_IMAGES_MAX] = { 0 };
+static const unsigned char* _lgData[VG_LARGE_IMAGES_MAX] = { 0 };
+static int _lgW[VG_LARGE_IMAGES_MAX] = { 0 };
+static int _lgH[VG_LARGE_IMAGES_MAX] = { 0 };
+static int _lgTopLevel[VG_LARGE_IMAGES_MAX] = { 0 };
+static GLuint _lgCache[VG_LARGE_IMAGES_MAX] = { 0 };
+static GLuint _lgCoarse[VG_LARGE_IMAGES_MAX] = { 0 };
+static unsigned long long _lgSlotKey[VG_LARGE_IMAGES_MAX][LARGE_SLOTS];
+static unsigned long long _lgSlotUsed[VG_LARGE_IMAGES_MAX][LARGE_SLOTS];
+static unsigned long long _lgUploadFrame = 0;
+static int _lgUploads = 0;
+static unsigned char _lgScratch[VG_LARGE_TILE_SIZE * VG_LARGE_TILE_SIZE * 4];
+
+/* coarser levels are box filtered once into a sidecar and mapped the */
+/* same way, _lgLevel is where each level starts in it */
+typedef struct vgPyramidHeader
+{
+	char magic[4];
+	int w, h, top;
+	unsigned long long sourceSize;
+	unsigned long long sourceTime;
+} vgPyramidHeader;
+
+static HANDLE _lgPyrFile[VG_LARGE_IMAGES_MAX] = { 0 };
+static HANDLE _lgPyrMapping[VG_LARGE_IMAGES_MAX] = { 0 };
+static const unsigned char* _lgPyr[VG_LARGE_IMAGES_MAX] = { 0 };
+static unsigned long long _lgLevel[VG_LARGE_IMAGES_MAX][LARGE_LEVELS_MAX];
+
+/* a missing sidecar is built by a worker into _lgPyrBuilt, tiles are */
+/* point sampled until it is done and vgDrawLargeImage swaps it in */
+static HANDLE _lgPyrThread[VG_LARGE_IMAGES_MAX] = { 0 };
+static volatile LONG _lgPyrCancel[VG_LARGE_IMAGES_MAX] = { 0 };
+static volatile LONG _lgPyrDone[VG_LARGE_IMAGES_MAX] = { 0 };
+static unsigned char* _lgPyrBuilt[VG_LARGE_IMAGES_MAX] = { 0 };
+static vgPyramidHeader _lgPyrWant[VG_LARGE_IMAGES_MAX];
+static char _lgPyrPath[VG_LARGE_IMAGES_MAX][MAX_PATH];
+
+/* hot reload data */
+/* the watcher thread owns reading files, uploads happen in vgUpdate */
+/* everything indexed by texture is guarded by _hrLock */
+static CRITICAL_SECTION _hrLock;
+static int _hrLockInit = FALSE;
+static HANDLE _hrThread = NULL;
+static HANDLE _hrWake = NULL;
+static volatile LONG _hrRunning = FALSE;
+static volatile LONG _hrDirty = FALSE;
+static volatile LONG _hrAnyPending = FALSE;
+static int _hrReloads = 0;
+static char* _hrPath[VG_TEXTURES_MAX] = { 0 };
+static FILETIME _hrTime[VG_TEXTURES_MAX] = { 0 };
+static unsigned int _hrGen[VG_TEXTURES_MAX] = { 0 };
+static unsigned char* _hrPending[VG_TEXTURES_MAX] = { 0 };
+
+/* upload thread data */
+/* a second context shares objects with _glContext and uploads on its own */
+/* thread, handles are reserved up front and published by vgUpdate once */
+/* the upload's fence has signalled. Queue and job state use _upLock */
+static CRITICAL_SECTION _upLock;
+static int _upLockInit = FALSE;
+static HANDLE _upThread = NULL;
+static HANDLE _upWake = NULL;
+static HGLRC _upContext = NULL;
+static DWORD _glThread = 0;
+static volatile LONG _upRunning = FALSE;
+static volatile LONG _upAnyDone = FALSE;
+static volatile LONG _upOutstanding = 0;
+static int _upQueue[VG_TEXTURES_MAX];
+static int _upQueueHead = 0;
+static int _upQueueCount = 0;
+static int _texPending[VG_TEXTURES_MAX] = { 0 };
+static unsigned char* _upData[VG_TEXTURES_MAX] = { 0 };
+static int _upReady[VG_TEXTURES_MAX];
+static int _upLinear[VG_TEXTURES_MAX];
+static int _upRepeat[VG_TEXTURES_MAX];
+static int _upCancel[VG_TEXTURES_MAX] = { 0 };
+static int _upDone[VG_TEXTURES_MAX] = { 0 };
+static GLuint _upName[VG_TEXTURES_MAX] = { 0 };
+static GLsync _upFence[VG_TEXTURES_MAX] = { 0 };
+
+/* capture data */
+/* frames are read into a ring of pixel buffers, mapped once their fence */
+/* has passed and handed to the writer thread, which converts straight */
+/* out of the mapping. Only the GL thread maps, unmaps or reads back */
+static CRITICAL_SECTION _capLock;
+static int _capLockInit = FALSE;
+static HANDLE _capThread = NULL;
+static HANDLE _capWake = NULL;
+static volatile LONG _capRunning = FALSE;
+static volatile LONG _capWritten = 0;
+static volatile LONG _capDropped = 0;
+static FILE* _capFile = NULL;
+static int _capFormat = 0;
+static int _capEvery = 1;
+static int _capW = 0;
+static int _capH = 0;
+static unsigned long long _capSwaps = 0;
+static unsigned long long _capIssued = 0;
+static unsigned long long _capMapped = 0;
+static GLuint _capBuffer[VG_CAPTURE_RING] = { 0 };
+static GLsync _capFence[VG_CAPTURE_RING] = { 0 };
+static unsigned long long _capSeq[VG_CAPTURE_RING] = { 0 };
+static unsigned long long _capFrame[VG_CAPTURE_RING] = { 0 };
+static const unsigned char* _capPixels[VG_CAPTURE_RING] = { 0 };
+static volatile LONG _capState[VG_CAPTURE_RING] = { 0 };
+static int _capQueue[VG_CAPTURE_RING];
+static int _capQueueHead = 0;
+static int _capQueueCount = 0;
+static unsigned char* _capOut = NULL;
+static unsigned char* _capPrev = NULL;
+static unsigned char* _capChanged = NULL;
+static HANDLE _capMapping = NULL;
+static HANDLE _capSignal = NULL;
+static vgSharedFrames* _capShared = NULL;
+
+/* screenshot data */
+/* each screenshot owns an encoder thread, which waits on _shotGo until */
+/* the GL thread has copied the pixels out. Results are reported from */
+/* vgUpdate and vgSwap on the GL thread */
+static volatile LONG _shotState[VG_SCREENSHOTS_MAX] = { 0 };
+static GLuint _shotBuffer[VG_SCREENSHOTS_MAX] = { 0 };
+static GLsync _shotFence[VG_SCREENSHOTS_MAX] = { 0 };
+static unsigned long long _shotFrame[VG_SCREENSHOTS_MAX] = { 0 };
+static HANDLE _shotThread[VG_SCREENSHOTS_MAX] = { 0 };
+static HANDLE _shotGo[VG_SCREENSHOTS_MAX] = { 0 };
+static char* _shotFile[VG_SCREENSHOTS_MAX] = { 0 };
+static unsigned char* _shotPixels[VG_SCREENSHOTS_MAX] = { 0 };
+static int _shotW[VG_SCREENSHOTS_MAX] = { 0 };
+static int _shotH[VG_SCREENSHOTS_MAX] = { 0 };
+static int _shotResult[VG_SCREENSHOTS_MAX] = { 0 };
+static vgScreenshotCallback _shotCallback[VG_SCREENSHOTS_MAX] = { 0 };
+static void* _shotUser[VG_SCREENSHOTS_MAX] = { 0 };
+
+/* archive data */
+/* archives are mapped once, lookups hash into the table of contents */
+typedef struct vgArchiveEntry
+{
+	unsigned int hash;
+	unsigned int nameOffset;
+	unsigned int type;
+	unsigned int w, h;
+	unsigned int format;
+	unsigned int levels;
+	unsigned int nameHigh; /* nameOffset bits above 32 */
+	unsigned long long dataOffset;
+	unsigned long long dataSize;
+} vgArchiveEntry;
+
+typedef struct vgArchiveHeader
+{
+	char magic[4];
+	unsigned int version;
+	unsigned int entryCount;
+	unsigned int slotCount;
+	unsigned long long tocOffset;
+} vgArchiveHeader;
+
+static HANDLE _arcFile[VG_ARCHIVES_MAX] = { 0 };
+static HANDLE _arcMapping[VG_ARCHIVES_MAX] = { 0 };
+static const unsigned char* _arcData[VG_ARCHIVES_MAX] = { 0 };
+static unsigned long long _arcSize[VG_ARCHIVES_MAX] = { 0 };
+
+/* archive writer data */
+static FILE* _arcOut = NULL;
+static vgArchiveEntry* _arcEntries = NULL;
+static char** _arcNames = NULL;
+static int _arcEntryCount = 0;
+static int _arcEntryCap = 0;
+
+/* trace data */
+/* records are written under _traceLock as other threads can create */
+/* textures. Public calls made by other public calls set _traceMute so */
+/* only the outer call is recorded */
+static CRITICAL_SECTION _traceLock;
+static int _traceLockInit = FALSE;
+static FILE* _traceFile = NULL;
+static int _traceCalls = 0;
+static LARGE_INTEGER _traceSwap = { 0 };
+static __declspec(thread) int _traceMute = 0;
+
+/* profiling data */
+/* each thread appends to its own ring and is the only one writing it, */
+/* vgSaveProfile copies rings out and drops what was overwritten meanwhile */
+typedef struct profileEntry
+{
+	const char* name;
+	long long time;
+	int phase;
+	int user;
+} profileEntry;
+
+typedef struct profileRing
+{
+	volatile LONG thread;
+	volatile LONG64 head;
+	profileEntry entries[VG_PROFILE_EVENTS];
+} profileRing;
+
+static profileRing* volatile _profRing[VG_PROFILE_THREADS_MAX] = { 0 };
+static volatile LONG _profRings = 0;
+static volatile LONG _profRunning = FALSE;
+static long long _profStart = 0;
+static __declspec(thread) profileRing* _profMine = NULL;
+static __declspec(thread) int _profNoRing = FALSE;
+
+/* frame statistics data */
+/* frame times in microseconds, the first 128 buckets are exact and every */
+/* octave above that is split into 64 */
+static unsigned int _ftBucket[VG_FRAME_BUCKETS] = { 0 };
+static unsigned long long _ftCount = 0;
+static unsigned int _ftMax = 0;
+static long long _ftLast = 0;
+
+/* hitch recorder data */
+/* public calls on the GL thread are kept in a ring with their start */
+/* time, op 0 marks the end of a frame. A hitch keeps the frames around */
+/* it once VG_HITCH_FRAMES_AFTER more have been drawn */
+typedef struct hitchCall
+{
+	long long time;
+	int op;
+	unsigned int frameTime;
+} hitchCall;
+
+typedef struct hitchRecord
+{
+	unsigned long long frame;
+	unsigned int frameTime;
+	int count;
+	hitchCall* calls;
+} hitchRecord;
+
+static volatile LONG _hitchOn = FALSE;
+static unsigned int _hitchThreshold = 0;
+static int _hitchCount = 0;
+static int _hitchSaved = 0;
+static hitchRecord _hitch[VG_HITCHES_MAX] = { 0 };
+static hitchCall _hcRing[VG_HITCH_CALLS];
+static long long _hcHead = 0;
+static long long _hcFrameStart[HITCH_FRAME_RING] = { 0 };
+static long long _hcPendingFrom = 0;
+static unsigned long long _hcPendingFrame = 0;
+static unsigned int _hcPendingTime = 0;
+static int _hcPendingLeft = 0;
+
+/* overdraw data */
+/* the stencil of _framebuffer counts depth passing fragments, it is */
+/* read back and cleared on every presented frame */
+static int _odMode = VG_OVERDRAW_OFF;
+static GLuint _odTexture;
+static unsigned char* _odCounts = NULL;
+static unsigned char* _odHeat = NULL;
+static unsigned long long _odWrites = 0;
+static int _odMax = 0;
+static int _odPixels[VG_OVERDRAW_LEVELS] = { 0 };
+
+/* last name bound per target on the GL thread, [0] 2D and [1] 3D */
+static GLuint _texBound[2] = { 0 };
+
+/* performance HUD data */
+/* counters run for the frame being drawn and are latched by vgSwap, */
+/* the font is 3x5 pixels from ' ' to '_', top row in the high bits */
+static int _hudCorner = VG_HUD_OFF;
+static int _hudDraws = 0;
+static int _hudBinds = 0;
+static int _hudCulled = 0;
+static int _hudLastDraws = 0;
+static int _hudLastBinds = 0;
+static int _hudLastCulled = 0;
+static unsigned int _hudTimes[HUD_SAMPLES] = { 0 };
+static unsigned long long _hudHead = 0;
+static const unsigned short _hudFont[0x40] = {
+	0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x52A5, 0x0000, 0x0000,
+	0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x01C0, 0x0002, 0x12A4,
+	0x7B6F, 0x2C97, 0x73E7, 0x72CF, 0x5BC9, 0x79CF, 0x79EF, 0x7292,
+	0x7BEF, 0x7BCF, 0x0410, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+	0x0000, 0x2BED, 0x6BAE, 0x3923, 0x6B6E, 0x79A7, 0x79A4, 0x396B,
+	0x5BED, 0x7497, 0x126A, 0x5BAD, 0x4927, 0x5FED, 0x6B6D, 0x2B6A,
+	0x6BA4, 0x2B73, 0x6BAD, 0x388E, 0x7492, 0x5B6F, 0x5B6A, 0x5BFD,
+	0x5AAD, 0x5A92, 0x72A7, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000
+};
+
+/* validation data */
+#ifdef VG_VALIDATE
+static vgValidateCallback _valCallback = NULL;
+static void* _valUser = NULL;
+static const char* _valLast = "vgInit";
+#endif
+
 /* windowstate */
 static int _winState = 0;
 
@@ -110,8 +517,129 @@ static int _winState = 0;
 
 /* INTERNAL HELPER FUNCTIONS */
 
+#ifdef VG_VALIDATE
+static void validateReport(int kind, const char* function,
+	const char* format, ...)
+{
+	char message[0x200];
+	va_list args;
+	va_start(args, format);
+	vsnprintf(message, sizeof(message), format, args);
+	va_end(args);
+
+	if (_valCallback != NULL)
+	{
+		_valCallback(kind, function, message, _valUser);
+		return;
+	}
+
+	char line[0x280];
+	snprintf(line, sizeof(line), "VGraphics: %s: %s\n", function, message);
+	OutputDebugStringA(line);
+}
+
+static void validateCall(const char* function)
+{
+	/* errors are only visible on the GL thread, nested calls belong */
+	/* to the public call that made them */
+	if (!_winState || _traceMute || GetCurrentThreadId() != _glThread)
+		return;
+
+	/* a flag may be raised by any call since the last check */
+	GLenum error;
+	for (int i = 0; i < 8 && (error = glGetError()) != GL_NO_ERROR; i++)
+		validateReport(VG_VALIDATE_GL, _valLast,
+			"GL error 0x%04X, found before %s", error, function);
+	_valLast = function;
+}
+
+static int liveTexture(vgTexture tex)
+{
+	return tex < VG_TEXTURES_MAX && (_texBuffer[tex] != 0 || _texPending[tex]);
+}
+
+static int liveShape(vgShape shape)
+{
+	return shape < VG_SHAPES_MAX && _shapeBuffer[shape] != 0;
+}
+
+static int itexInBounds(unsigned short index, int* vx, int* vy, int size)
+{
+	if (index >= VG_ITEX_COLORS_MAX) return FALSE;
+	for (int i = 0; i < size; i++)
+	{
+		if (vx[i] < 0 || vx[i] >= VG_ITEX_SIZE_MAX || vy[i] < 0 ||
+			vy[i] >= VG_ITEX_SIZE_MAX)
+			return FALSE;
+	}
+	return TRUE;
+}
+#endif
+
+static profileRing* profileClaim(void)
+{
+	DWORD self = GetCurrentThreadId();
+
+	/* a new ring while there are any left */
+	LONG index = InterlockedIncrement(&_profRings) - 1;
+	if (index < VG_PROFILE_THREADS_MAX)
+	{
+		profileRing* ring = calloc(1, sizeof(profileRing));
+		if (ring != NULL) ring->thread = self;
+		InterlockedExchangePointer((PVOID volatile*)&_profRing[index], ring);
+		return ring;
+	}
+
+	/* then the ring of a thread that has exited */
+	for (int i = 0; i < VG_PROFILE_THREADS_MAX; i++)
+	{
+		profileRing* ring = _profRing[i];
+		if (ring == NULL) continue;
+
+		LONG owner = ring->thread;
+		HANDLE thread = OpenThread(SYNCHRONIZE, FALSE, owner);
+		int alive = thread && WaitForSingleObject(thread, 0) == WAIT_TIMEOUT;
+		if (thread) CloseHandle(thread);
+		if (alive) continue;
+
+		if (InterlockedCompareExchange(&ring->thread, self, owner) == owner)
+		{
+			InterlockedExchange64(&ring->head, 0);
+			return ring;
+		}
+	}
+
+	return NULL;
+}
+
+static void profileEvent(const char* name, int phase, int user)
+{
+	/* threads look for a ring once, without one their events are lost */
+	if (_profMine == NULL)
+	{
+		if (_profNoRing) return;
+		_profMine = profileClaim();
+		_profNoRing = _profMine == NULL;
+		if (_profNoRing) return;
+	}
+
+	LARGE_INTEGER now;
+	QueryPerformanceCounter(&now);
+
+	/* fill the entry, then publish it by moving head past it */
+	LONG64 head = _profMine->head;
+	profileEntry* entry = &_profMine->entries[head & (VG_PROFILE_EVENTS - 1)];
+	entry->name = name;
+	entry->time = now.QuadPart;
+	entry->phase = phase;
+	entry->user = user;
+	InterlockedExchange64(&_profMine->head, head + 1);
+}
+
 static inline void psetup(void)
 {
+	_hudDraws++;
+
 	/* bind to framebuffer */
 	glBindFramebuffer(GL_FRAMEBUFFER, _framebuffer);
 
@@ -144,11 +672,14 @@ static inline void psetup(void)
 
 	if (_useROffset)
 		glTranslatef(-_rOffsetX, -_rOffsetY, 0);
+
+	if (_odMode) glEnable(GL_STENCIL_TEST);
 }
 
 static inline void rsetup(void)
 {
 	glBindFramebuffer(GL_FRAMEBUFFER, NULL);
+	if (_odMode) glDisable(GL_STENCIL_TEST);
 
 	glMatrixMode(GL_PROJECTION);
 	glLoadIdentity();
@@ -166,6 +697,7 @@ static inline void rsetup(void)
 static inline void esetup(void)
 {
 	glBindFramebuffer(GL_FRAMEBUFFER, _eFrameBuffer);
+	if (_odMode) glDisable(GL_STENCIL_TEST);
 
 	glMatrixMode(GL_PROJECTION);
 	glLoadIdentity();
@@ -184,1103 +716,6920 @@ static inline vgTexture findFreeTexture(void)
 	for (int i = 0; i < VG_TEXTURES_MAX; i++)
 	{
 		int indexActual = (_texCount / 2) + i;
-		if (_texBuffer[i % VG_TEXTURES_MAX] == NULL)
+		if (_texBuffer[i % VG_TEXTURES_MAX] == NULL && !_texPending[i])
 			return i;
 	}
-}
 
-static inline vgShape findFreeShape(void)
-{
-	for (int i = 0; i < VG_SHAPES_MAX; i++)
-	{
-		if (_shapeBuffer[i] == NULL)
-			return i;
-	}
+	return VG_INVALID;
 }
 
-/* WINDOW CALLBACK */
-static LRESULT CALLBACK vgWProc(HWND hWnd, UINT message,
-	WPARAM wParam, LPARAM lParam)
+static vgTexture reserveTexture(int w, int h, int levels, int format)
 {
-	PIXELFORMATDESCRIPTOR pfd = { 0 };
+	/* other threads reserve handles while the upload thread runs */
+	if (_upLockInit) EnterCriticalSection(&_upLock);
 
-	switch (message)
+	vgTexture handle = findFreeTexture();
+	if (handle == VG_INVALID)
 	{
-	case WM_CREATE:
-		/* configure pixelformat */
-		pfd.nSize = sizeof(PIXELFORMATDESCRIPTOR);
-		pfd.nVersion = 1;
-		pfd.dwFlags = PFD_DRAW_TO_WINDOW | PFD_SUPPORT_OPENGL |
-			PFD_DOUBLEBUFFER;
-		pfd.iPixelType = PFD_TYPE_RGBA;
-		pfd.cColorBits = 32;
-		pfd.cDepthBits = 16;
-		pfd.cStencilBits = 16;
+		if (_upLockInit) LeaveCriticalSection(&_upLock);
+		return VG_INVALID;
+	}
 
-		/* get device context */
-		_deviceContext = GetDC(hWnd);
+	_texPending[handle] = TRUE;
+	_texWidth[handle] = w;
+	_texHeight[handle] = h;
+	_texLevels[handle] = levels;
+	_texFormat[handle] = format;
+	_texLayers[handle] = 0;
+	_texCount++;
 
-		/* init pixelformat and bind */
-		int formatHandle = ChoosePixelFormat(_deviceContext,
-			&pfd);
-		SetPixelFormat(_deviceContext, formatHandle, &pfd);
+	if (_upLockInit) LeaveCriticalSection(&_upLock);
+	return handle;
+}
 
-		/* create rendering context */
-		_glContext = wglCreateContext(_deviceContext);
-		wglMakeCurrent(_deviceContext, _glContext);
+static void publishTexture(vgTexture handle, GLuint name)
+{
+	if (_upLockInit) EnterCriticalSection(&_upLock);
+	_texBuffer[handle] = name;
+	_texPending[handle] = FALSE;
+	if (_upLockInit) LeaveCriticalSection(&_upLock);
+}
 
-		/* set size properly */
-		
+static void texParams(int linear, int repeat)
+{
+	switch (repeat)
+	{
+	case 0:
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
 		break;
 
-	/* on destroy */
-	case WM_DESTROY:
-
-		/* set windowstate to false */
-		_winState = FALSE;
-
-		/* free all openGL objects */
-		glDeleteFramebuffers(1, &_framebuffer);
-		glDeleteFramebuffers(1, &_eFrameBuffer);
-		glDeleteFramebuffers(1, &_rFrameBuffer);
-		glDeleteRenderbuffers(1, &_depth);
-		glDeleteTextures(1, &_texture);
+	case 1:
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		break;
 
-		for (int i = 0; i < VG_TEXTURES_MAX; i++)
-		{
-			glDeleteTextures(1, &_texBuffer[i]);
-			_texBuffer[i] = NULL;
-		}
+	default:
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+		break;
+	}
 
-		for (int i = 0; i < VG_SHAPES_MAX; i++)
-		{
-			glDeleteLists(_shapeBuffer[i], 1);
-			_shapeBuffer[i] = NULL;
-		}
+	switch (linear)
+	{
+	case 0:
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		break;
 
-		/* release DC */
-		ReleaseDC(_window, _deviceContext);
+	case 1:
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		break;
 
-		/* destroy gl context */
-		wglDeleteContext(_glContext);
+	case VG_LINEAR_MIPMAP:
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+			GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		break;
 
-		return DefWindowProc(hWnd, message, wParam, lParam);
+	case VG_NEAREST_MIPMAP:
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+			GL_NEAREST_MIPMAP_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 		break;
 
-	/* on default */
 	default:
-		return DefWindowProc(hWnd, message, wParam, lParam);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 		break;
 	}
 
-	return DefWindowProc(hWnd, message, wParam, lParam);
+	/* pooled names keep whatever bias their last owner gave them */
+	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_LOD_BIAS, 0);
 }
 
-/* INIT AND TERMINATE FUNCTIONS */
-
-VAPI void vgInit(int window_w, int window_h, int resolution_w,
-	int resolution_h, int linear)
+static inline int texBind(GLenum target, GLuint name)
 {
-	/* setup update count and layer */
-	_updates = 0;
-	_layer = 1.0f;
-	_swapTime = VG_SWAP_TIME_MIN;
-	_renderSkip    = FALSE;
-	_useRenderSkip = TRUE;
-	_texCount = 0;
+	/* returns TRUE when the bind actually reached the driver */
+	GLuint* bound = &_texBound[target == GL_TEXTURE_3D];
+	if (*bound == name) return FALSE;
 
-	/* enable DPI awareness */
-	SetProcessDPIAware();
+	glBindTexture(target, name);
+	*bound = name;
+	return TRUE;
+}
 
-	/* create window */
+static inline void texDelete(GLsizei n, const GLuint* names)
+{
+	/* a deleted name unbinds itself, keep the cache in step */
+	for (GLsizei i = 0; i < n; i++)
+	{
+		if (_texBound[0] == names[i]) _texBound[0] = 0;
+		if (_texBound[1] == names[i]) _texBound[1] = 0;
+	}
+	glDeleteTextures(n, names);
+}
 
-	/* setup and register window class */
-	WNDCLASSA wClass = { 0 };
-	wClass.lpfnWndProc = vgWProc;
-	wClass.lpszClassName = "vgWindow";
-	int regResult = RegisterClassA(&wClass);
+static inline void readForget(GLuint name)
+{
+	/* a deleted name can come back, don't let the caches point at it */
+	if (name == 0) return;
 
-	/* check if reg failed */
-	/* 1410 means class already exists, so it's ok */
-	int errCode = GetLastError();
-	if (!regResult && errCode != 1410)
+	if (name == _readAttached)
 	{
-		char cBuff[0xFF];
-		sprintf(cBuff, "Register Window Class!\nError Code: %d\n",
-			errCode);
-		MessageBoxA(NULL, cBuff, "CRITICAL ENGINE FAILURE", MB_OK);
-		exit(1);
+		glBindFramebuffer(GL_FRAMEBUFFER, _rFrameBuffer);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+			GL_TEXTURE_2D, 0, 0);
+		_readAttached = 0;
+	}
+	if (name == _blitAttached)
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, _bFrameBuffer);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+			GL_TEXTURE_2D, 0, 0);
+		_blitAttached = 0;
 	}
+}
 
-	/* ensure window size is big enough */
-	RECT clientRect = { 0, 0, window_w, window_h };
-	AdjustWindowRectExForDpi(&clientRect,
-		WS_VISIBLE | WS_SYSMENU | WS_MAXIMIZEBOX |
-		WS_THICKFRAME, TRUE,
-		WS_VISIBLE | WS_SYSMENU | WS_MAXIMIZEBOX |
-		WS_THICKFRAME,
-		GetDpiForSystem());
-	int winWidth = clientRect.right - clientRect.left;
-	int winHeight = clientRect.bottom - clientRect.top;
+static inline void poolAdd(GLuint name, int w, int h, int levels,
+	int format)
+{
+	/* pool is full, drop the oldest entry */
+	if (_poolCount >= VG_TEXPOOL_MAX)
+	{
+		readForget(_poolName[0]);
+		texDelete(1, &_poolName[0]);
+		for (int i = 1; i < _poolCount; i++)
+		{
+			_poolName[i - 1] = _poolName[i];
+			_poolW[i - 1] = _poolW[i];
+			_poolH[i - 1] = _poolH[i];
+			_poolLevels[i - 1] = _poolLevels[i];
+			_poolFormat[i - 1] = _poolFormat[i];
+		}
+		_poolCount--;
+	}
 
-	/* create window */
-	_window = CreateWindowA(wClass.lpszClassName, " ",
-		WS_VISIBLE | WS_SYSMENU | WS_MAXIMIZEBOX, CW_USEDEFAULT,
-		CW_USEDEFAULT, winWidth, winHeight, 0, 0, NULL, 0);
+	_poolName[_poolCount] = name;
+	_poolW[_poolCount] = w;
+	_poolH[_poolCount] = h;
+	_poolLevels[_poolCount] = levels;
+	_poolFormat[_poolCount] = format;
+	_poolCount++;
+}
 
-	/* window err handling */
-	if (_window == NULL)
+static inline GLuint poolTake(int w, int h, int levels, int format)
+{
+	/* search newest first, recently used storage is most likely resident */
+	for (int i = _poolCount - 1; i >= 0; i--)
 	{
-		char cBuff[0xFF];
-		sprintf(cBuff, "Window Creation Failed!\nError Code: %d\n",
-			GetLastError());
-		MessageBoxA(NULL, cBuff, "CRITICAL ENGINE FAILURE", MB_OK);
-		exit(1);
+		if (_poolW[i] != w || _poolH[i] != h) continue;
+		if (_poolLevels[i] != levels || _poolFormat[i] != format) continue;
+
+		GLuint name = _poolName[i];
+		_poolCount--;
+		_poolName[i] = _poolName[_poolCount];
+		_poolW[i] = _poolW[_poolCount];
+		_poolH[i] = _poolH[_poolCount];
+		_poolLevels[i] = _poolLevels[_poolCount];
+		_poolFormat[i] = _poolFormat[_poolCount];
+		return name;
 	}
 
-	int glewStatus = glewInit();
-	if (glewStatus != GLEW_OK)
+	return 0;
+}
+
+static inline void fenceFrame(void)
+{
+	/* without sync objects, assume the driver queues a few frames */
+	if (!GLEW_ARB_sync)
 	{
-		MessageBoxA(NULL, "Could not locate OpenGL extensions!", "FATAL ERROR",
-			MB_OK);
-		exit(1);
+		if (_frames + 1 > VG_DEFER_FRAMES)
+			_retiredFrame = _frames + 1 - VG_DEFER_FRAMES;
+		return;
 	}
 
-	/* check for missing support */
-	if (glBindFramebuffer == NULL)
+	/* retire every fence the GPU has passed, oldest first */
+	for (unsigned long long f = _retiredFrame; f < _frames; f++)
 	{
-		const char* msg = "Your OpenGL does not support Framebuffers\n"
-			"This is a crucial feature used in VGraphics.dll and cannot"
-			"be skipped.";
-		MessageBoxA(NULL, msg, "FATAL ERROR", MB_OK);
-		exit(1);
+		int slot = f % VG_FENCE_RING;
+		if (_fenceSync[slot] == NULL || _fenceFrame[slot] != f) continue;
+
+		/* if the ring is about to wrap, wait for the old fence */
+		GLuint64 timeout = (slot == _frames % VG_FENCE_RING) ?
+			0xFFFFFFFFull : 0;
+		GLenum status = glClientWaitSync(_fenceSync[slot],
+			GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+		if (status != GL_ALREADY_SIGNALED &&
+			status != GL_CONDITION_SATISFIED) break;
+
+		glDeleteSync(_fenceSync[slot]);
+		_fenceSync[slot] = NULL;
+		_retiredFrame = f + 1;
 	}
 
-	/* clear and swap to remove artifacts */
-	glBindFramebuffer(GL_FRAMEBUFFER, NULL);
-	glClear(GL_COLOR_BUFFER_BIT);
-	SwapBuffers(_deviceContext);
-
-	/* create framebuffer and texture */
-	glGenFramebuffers(1, &_framebuffer);
-	glGenTextures(1, &_texture);
-	glBindFramebuffer(GL_FRAMEBUFFER, _framebuffer);
-	glBindTexture(GL_TEXTURE_2D, _texture);
-	glTexImage2D(GL_TEXTURE_2D, NULL, GL_RGB, resolution_w, resolution_h,
-		NULL, GL_RGB, GL_UNSIGNED_BYTE, NULL);
+	/* fence the frame just submitted, a wait that timed out above left */
+	/* the old fence here, the new one signals after it anyway */
+	int slot = _frames % VG_FENCE_RING;
+	if (_fenceSync[slot] != NULL) glDeleteSync(_fenceSync[slot]);
+	_fenceSync[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	_fenceFrame[slot] = _frames;
+}
 
-	/* set texture filter params */
-	switch (linear)
+static inline void retireTextures(void)
+{
+	int keep = 0;
+	for (int i = 0; i < _deferCount; i++)
 	{
-	case 0:
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-		break;
-	case 1:
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		/* still possibly in flight, keep in queue */
+		if (_deferFrame[i] >= _retiredFrame)
+		{
+			_deferName[keep] = _deferName[i];
+			_deferW[keep] = _deferW[i];
+			_deferH[keep] = _deferH[i];
+			_deferLevels[keep] = _deferLevels[i];
+			_deferFormat[keep] = _deferFormat[i];
+			_deferLayers[keep] = _deferLayers[i];
+			_deferFrame[keep] = _deferFrame[i];
+			keep++;
+			continue;
+		}
+
+		/* array textures are not pooled */
+		if (_usePool && _deferLayers[i] == 0)
+			poolAdd(_deferName[i], _deferW[i], _deferH[i],
+				_deferLevels[i], _deferFormat[i]);
+		else
+		{
+			readForget(_deferName[i]);
+			texDelete(1, &_deferName[i]);
+		}
+	}
+	_deferCount = keep;
+}
+
+static inline int mipLevels(int w, int h)
+{
+	int levels = 1;
+	int size = max(w, h);
+	while (size > 1)
+	{
+		size >>= 1;
+		levels++;
+	}
+	return levels;
+}
+
+static inline GLenum fmtInternal(int format)
+{
+	/* sized 565 storage needs ES2 compatibility, RGB5 is the old name */
+	if (format == VG_FORMAT_RGB565 && !GLEW_ARB_ES2_compatibility)
+		return GL_RGB5;
+	return _fmtInternal[format];
+}
+
+static inline int fmtCompressed(int format)
+{
+	return format == VG_FORMAT_BC1 || format == VG_FORMAT_BC3;
+}
+
+static inline __m128i pack32to16(__m128i a, __m128i b)
+{
+	/* SSE2 only has a signed pack, so bias into signed range and back */
+	const __m128i bias32 = _mm_set1_epi32(0x8000);
+	const __m128i bias16 = _mm_set1_epi16((short)0x8000);
+	__m128i packed = _mm_packs_epi32(_mm_sub_epi32(a, bias32),
+		_mm_sub_epi32(b, bias32));
+	return _mm_xor_si128(packed, bias16);
+}
+
+typedef struct bcJob
+{
+	int w, h, format;
+	int rowStart, rowEnd; /* block rows */
+	const unsigned char* src;
+	unsigned char* dst;
+} bcJob;
+
+static inline unsigned short to565(int r, int g, int b)
+{
+	return (unsigned short)(((r * 31 + 127) / 255) << 11 |
+		((g * 63 + 127) / 255) << 5 | ((b * 31 + 127) / 255));
+}
+
+static inline void from565(unsigned short c, int* rgb)
+{
+	int r = (c >> 11) & 0x1F, g = (c >> 5) & 0x3F, b = c & 0x1F;
+	rgb[0] = (r << 3) | (r >> 2);
+	rgb[1] = (g << 2) | (g >> 4);
+	rgb[2] = (b << 3) | (b >> 2);
+}
+
+static void encodeColorBlock(const unsigned char* px, int allowAlpha,
+	unsigned char* out)
+{
+	/* bounding box of the block, inset to reduce endpoint error */
+	int lo[3] = { 255, 255, 255 }, hi[3] = { 0, 0, 0 };
+	int transparent = FALSE;
+	for (int i = 0; i < 16; i++)
+	{
+		if (allowAlpha && px[i * 4 + 3] < 128)
+		{
+			transparent = TRUE;
+			continue;
+		}
+		for (int c = 0; c < 3; c++)
+		{
+			lo[c] = min(lo[c], px[i * 4 + c]);
+			hi[c] = max(hi[c], px[i * 4 + c]);
+		}
+	}
+	if (lo[0] > hi[0]) /* fully transparent */
+	{
+		lo[0] = lo[1] = lo[2] = 0;
+		hi[0] = hi[1] = hi[2] = 0;
+	}
+	for (int c = 0; c < 3; c++)
+	{
+		int inset = (hi[c] - lo[c]) >> 4;
+		lo[c] += inset;
+		hi[c] -= inset;
+	}
+
+	unsigned short c0 = to565(hi[0], hi[1], hi[2]);
+	unsigned short c1 = to565(lo[0], lo[1], lo[2]);
+
+	/* 4 color mode needs c0 > c1, 3 color + transparent needs c0 <= c1 */
+	if (transparent ? (c0 > c1) : (c0 < c1))
+	{
+		unsigned short t = c0; c0 = c1; c1 = t;
+	}
+
+	int e0[3], e1[3];
+	from565(c0, e0);
+	from565(c1, e1);
+	int axis[3] = { e1[0] - e0[0], e1[1] - e0[1], e1[2] - e0[2] };
+	int len = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+
+	/* position along c0 -> c1 mapped to palette index */
+	static const unsigned char map4[4] = { 0, 2, 3, 1 };
+	static const unsigned char map3[3] = { 0, 2, 1 };
+	int steps = (c0 > c1) ? 3 : 2;
+
+	unsigned int indices = 0;
+	for (int i = 0; i < 16; i++)
+	{
+		const unsigned char* p = px + i * 4;
+		unsigned int index;
+		if (transparent && p[3] < 128)
+			index = 3;
+		else if (len == 0)
+			index = 0;
+		else
+		{
+			int dot = (p[0] - e0[0]) * axis[0] + (p[1] - e0[1]) * axis[1] +
+				(p[2] - e0[2]) * axis[2];
+			int q = (dot * steps * 2 + len) / (len * 2);
+			q = max(0, min(steps, q));
+			index = (steps == 3) ? map4[q] : map3[q];
+		}
+		indices |= index << (i * 2);
+	}
+
+	out[0] = (unsigned char)(c0 & 0xFF); out[1] = (unsigned char)(c0 >> 8);
+	out[2] = (unsigned char)(c1 & 0xFF); out[3] = (unsigned char)(c1 >> 8);
+	memcpy(out + 4, &indices, 4);
+}
+
+static void encodeAlphaBlock(const unsigned char* px, unsigned char* out)
+{
+	int a0 = 0, a1 = 255;
+	for (int i = 0; i < 16; i++)
+	{
+		a0 = max(a0, px[i * 4 + 3]);
+		a1 = min(a1, px[i * 4 + 3]);
+	}
+
+	/* 8 alpha mode, code 0 = a0, 1 = a1, 2..7 interpolate towards a1 */
+	static const unsigned char map8[8] = { 1, 7, 6, 5, 4, 3, 2, 0 };
+	unsigned long long indices = 0;
+	int range = a0 - a1;
+	for (int i = 0; i < 16 && range > 0; i++)
+	{
+		int q = ((px[i * 4 + 3] - a1) * 14 + range) / (range * 2);
+		indices |= (unsigned long long)map8[q] << (i * 3);
+	}
+
+	out[0] = (unsigned char)a0;
+	out[1] = (unsigned char)a1;
+	for (int i = 0; i < 6; i++)
+		out[2 + i] = (unsigned char)(indices >> (i * 8));
+}
+
+static DWORD WINAPI compressWorker(LPVOID param)
+{
+	bcJob* job = param;
+	int bw = (job->w + 3) / 4;
+	int blockBytes = _fmtBytes[job->format];
+	unsigned char px[64];
+
+	for (int by = job->rowStart; by < job->rowEnd; by++)
+	{
+		for (int bx = 0; bx < bw; bx++)
+		{
+			/* gather block, replicating edges of partial blocks */
+			for (int y = 0; y < 4; y++)
+			{
+				int sy = min(by * 4 + y, job->h - 1);
+				for (int x = 0; x < 4; x++)
+				{
+					int sx = min(bx * 4 + x, job->w - 1);
+					memcpy(px + (y * 4 + x) * 4,
+						job->src + (sy * job->w + sx) * 4, 4);
+				}
+			}
+
+			unsigned char* out = job->dst + (by * bw + bx) * blockBytes;
+			if (job->format == VG_FORMAT_BC3)
+			{
+				encodeAlphaBlock(px, out);
+				encodeColorBlock(px, FALSE, out + 8);
+			}
+			else
+				encodeColorBlock(px, TRUE, out);
+		}
+	}
+
+	return 0;
+}
+
+static void compressBlocks(int w, int h, int format,
+	const unsigned char* src, unsigned char* dst)
+{
+	bcJob jobs[ENCODE_THREADS_MAX];
+	HANDLE threads[ENCODE_THREADS_MAX];
+	int rows = (h + 3) / 4;
+
+	/* one worker per core, each taking at least 16 block rows */
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	int count = min((int)info.dwNumberOfProcessors, ENCODE_THREADS_MAX);
+	count = max(1, min(count, rows / 16));
+
+	for (int i = 0; i < count; i++)
+	{
+		jobs[i].w = w;
+		jobs[i].h = h;
+		jobs[i].format = format;
+		jobs[i].rowStart = rows * i / count;
+		jobs[i].rowEnd = rows * (i + 1) / count;
+		jobs[i].src = src;
+		jobs[i].dst = dst;
+	}
+
+	/* calling thread takes the first slice */
+	PROFILE_BEGIN("texture compress");
+	for (int i = 1; i < count; i++)
+		threads[i] = CreateThread(NULL, 0, compressWorker, &jobs[i], 0, NULL);
+	compressWorker(&jobs[0]);
+
+	for (int i = 1; i < count; i++)
+	{
+		/* thread creation failed, do the slice here */
+		if (threads[i] == NULL)
+		{
+			compressWorker(&jobs[i]);
+			continue;
+		}
+		WaitForSingleObject(threads[i], INFINITE);
+		CloseHandle(threads[i]);
+	}
+	PROFILE_END();
+}
+
+static void decodeColorBlock(const unsigned char* in, int fourColor,
+	unsigned char* px)
+{
+	unsigned short c0 = (unsigned short)(in[0] | (in[1] << 8));
+	unsigned short c1 = (unsigned short)(in[2] | (in[3] << 8));
+	int pal[4][4];
+	from565(c0, pal[0]);
+	from565(c1, pal[1]);
+	pal[0][3] = pal[1][3] = 255;
+
+	for (int c = 0; c < 3; c++)
+	{
+		if (fourColor || c0 > c1)
+		{
+			pal[2][c] = (2 * pal[0][c] + pal[1][c]) / 3;
+			pal[3][c] = (pal[0][c] + 2 * pal[1][c]) / 3;
+		}
+		else
+		{
+			pal[2][c] = (pal[0][c] + pal[1][c]) / 2;
+			pal[3][c] = 0;
+		}
+	}
+	pal[2][3] = 255;
+	pal[3][3] = (fourColor || c0 > c1) ? 255 : 0;
+
+	unsigned int indices;
+	memcpy(&indices, in + 4, 4);
+	for (int i = 0; i < 16; i++)
+	{
+		int index = (indices >> (i * 2)) & 3;
+		for (int c = 0; c < 4; c++)
+			px[i * 4 + c] = (unsigned char)pal[index][c];
+	}
+}
+
+static void decodeAlphaBlock(const unsigned char* in, unsigned char* px)
+{
+	int a[8];
+	a[0] = in[0];
+	a[1] = in[1];
+	for (int i = 2; i < 8; i++)
+	{
+		if (a[0] > a[1])
+			a[i] = ((8 - i) * a[0] + (i - 1) * a[1]) / 7;
+		else if (i < 6)
+			a[i] = ((6 - i) * a[0] + (i - 1) * a[1]) / 5;
+		else
+			a[i] = (i == 6) ? 0 : 255;
+	}
+
+	unsigned long long indices = 0;
+	for (int i = 0; i < 6; i++)
+		indices |= (unsigned long long)in[2 + i] << (i * 8);
+	for (int i = 0; i < 16; i++)
+		px[i * 4 + 3] = (unsigned char)a[(indices >> (i * 3)) & 7];
+}
+
+static inline void uploadLevel(int level, int w, int h, int format, int sub,
+	const void* data)
+{
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+	if (fmtCompressed(format))
+	{
+		int size = vgFormatSize(format, w, h);
+		if (sub)
+		{
+			if (data != NULL)
+				glCompressedTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, w, h,
+					_fmtInternal[format], size, data);
+		}
+		else
+			glCompressedTexImage2D(GL_TEXTURE_2D, level,
+				_fmtInternal[format], w, h, NULL, size, data);
+		return;
+	}
+
+	if (sub)
+	{
+		if (data != NULL)
+			glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, w, h,
+				_fmtUpload[format], _fmtType[format], data);
+	}
+	else
+		glTexImage2D(GL_TEXTURE_2D, level, fmtInternal(format), w, h, NULL,
+			_fmtUpload[format], _fmtType[format], data);
+}
+
+static inline void uploadChain(int w, int h, int level, int levels,
+	int format, int sub, const unsigned char* data)
+{
+	/* box filter on CPU, ping-pong between two halves of one buffer */
+	/* data is the RGBA8 texels of level, the levels after it are built */
+	int halfSize = max(1, w >> 1) * max(1, h >> 1) * 4;
+	unsigned char* scratch = malloc(halfSize * 2);
+	unsigned char* conv = NULL;
+	if (format != VG_FORMAT_RGBA8)
+		conv = malloc(vgFormatSize(format, max(1, w >> 1), max(1, h >> 1)));
+	if (scratch == NULL || (format != VG_FORMAT_RGBA8 && conv == NULL))
+	{
+		free(scratch);
+		free(conv);
+		return;
+	}
+
+	const unsigned char* src = data;
+	unsigned char* dst = scratch;
+	for (int i = level + 1; i < levels; i++)
+	{
+		vgBuildMipmapData(w, h, src, dst);
+		w = max(1, w >> 1);
+		h = max(1, h >> 1);
+
+		if (conv != NULL)
+			vgConvertTextureData(w, h, format, dst, conv);
+		uploadLevel(i, w, h, format, sub, conv ? conv : dst);
+
+		src = dst;
+		dst = (dst == scratch) ? scratch + halfSize : scratch;
+	}
+
+	free(scratch);
+	free(conv);
+}
+
+static inline void uploadMipmaps(int w, int h, int levels, int format,
+	int sub, const unsigned char* data)
+{
+	/* converted texels of the current level, RGBA8 uploads as is */
+	unsigned char* conv = NULL;
+	if (data != NULL && format != VG_FORMAT_RGBA8)
+	{
+		conv = malloc(vgFormatSize(format, w, h));
+		if (conv == NULL) return;
+	}
+
+	/* level 0 */
+	if (conv != NULL)
+		vgConvertTextureData(w, h, format, data, conv);
+	uploadLevel(0, w, h, format, sub, conv ? conv : data);
+
+	if (levels <= 1)
+	{
+		free(conv);
+		return;
+	}
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+
+	/* no data, only allocate the chain */
+	if (data == NULL)
+	{
+		if (sub) return;
+		for (int i = 1; i < levels; i++)
+			uploadLevel(i, max(1, w >> i), max(1, h >> i), format, FALSE,
+				NULL);
+		return;
+	}
+
+	/* prefer letting the driver build the chain */
+	/* compressed formats can't be rendered to, so build those on CPU */
+	if (!_cpuMipmaps && glGenerateMipmap != NULL && !fmtCompressed(format))
+	{
+		glGenerateMipmap(GL_TEXTURE_2D);
+		free(conv);
+		return;
+	}
+
+	free(conv);
+	uploadChain(w, h, 0, levels, format, sub, data);
+}
+
+static inline void uploadReady(int w, int h, int levels, int format,
+	int sub, int ready, const unsigned char* data)
+{
+	/* data holds the first ready levels in the texture's own format, */
+	/* back to back, the rest of the chain is built from the last one */
+	if (levels > 1)
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+
+	const unsigned char* last = data;
+	for (int i = 0; i < levels; i++)
+	{
+		int lw = max(1, w >> i), lh = max(1, h >> i);
+		uploadLevel(i, lw, lh, format, sub, i < ready ? data : NULL);
+		if (i >= ready) continue;
+		last = data;
+		data += vgFormatSize(format, lw, lh);
+	}
+	if (ready >= levels) return;
+
+	if (!_cpuMipmaps && glGenerateMipmap != NULL && !fmtCompressed(format))
+	{
+		glGenerateMipmap(GL_TEXTURE_2D);
+		return;
+	}
+
+	/* texels of the last ready level, without going through GL if we can */
+	int lw = max(1, w >> (ready - 1)), lh = max(1, h >> (ready - 1));
+	unsigned char* rgba = malloc(lw * lh * 4);
+	if (rgba == NULL) return;
+	if (fmtCompressed(format))
+		vgDecompressTextureData(lw, lh, format, last, rgba);
+	else if (format == VG_FORMAT_RGBA8)
+		memcpy(rgba, last, lw * lh * 4);
+	else
+	{
+		glPixelStorei(GL_PACK_ALIGNMENT, 1);
+		glGetTexImage(GL_TEXTURE_2D, ready - 1, GL_RGBA, GL_UNSIGNED_BYTE,
+			rgba);
+	}
+
+	uploadChain(lw, lh, ready - 1, levels, format, TRUE, rgba);
+	free(rgba);
+}
+
+static inline GLenum texEnable(vgTexture tex)
+{
+	/* array textures live in a 3D texture, the fixed function */
+	/* pipeline has no way to sample GL_TEXTURE_2D_ARRAY */
+	GLenum target = _texLayers[tex] ? GL_TEXTURE_3D : GL_TEXTURE_2D;
+	_hudBinds += texBind(target, _texBuffer[tex]);
+	glEnable(target);
+	return target;
+}
+
+static inline float layerCoord(vgTexture tex, int layer)
+{
+	/* sample the center of the layer so filtering never blends layers */
+	if (_texLayers[tex] == 0) return 0;
+	return ((float)layer + 0.5f) / (float)_texLayers[tex];
+}
+
+static void uploadQueue(vgTexture handle, int linear, int repeat, int ready,
+	const void* data)
+{
+	/* the caller may free its buffer as soon as this returns */
+	/* ready levels are in the texture's format, otherwise it is RGBA8 */
+	unsigned char* copy = NULL;
+	if (data != NULL)
+	{
+		int w = _texWidth[handle], h = _texHeight[handle];
+		size_t size = ready ? 0 : (size_t)w * h * 4;
+		for (int i = 0; i < ready; i++)
+			size += vgFormatSize(_texFormat[handle], max(1, w >> i),
+				max(1, h >> i));
+		copy = malloc(size);
+		if (copy) memcpy(copy, data, size);
+	}
+
+	EnterCriticalSection(&_upLock);
+	_upData[handle] = copy;
+	_upReady[handle] = ready;
+	_upLinear[handle] = linear;
+	_upRepeat[handle] = repeat;
+	_upCancel[handle] = FALSE;
+	_upDone[handle] = FALSE;
+	_upQueue[(_upQueueHead + _upQueueCount) % VG_TEXTURES_MAX] = handle;
+	_upQueueCount++;
+	LeaveCriticalSection(&_upLock);
+
+	InterlockedIncrement(&_upOutstanding);
+	SetEvent(_upWake);
+}
+
+static void textureUpload(vgTexture handle, int linear, int repeat,
+	int ready, const void* data)
+{
+	/* off the GL thread, hand it to the upload thread */
+	if (_upRunning && GetCurrentThreadId() != _glThread)
+	{
+		uploadQueue(handle, linear, repeat, ready, data);
+		return;
+	}
+
+	int w = _texWidth[handle], h = _texHeight[handle];
+	int levels = _texLevels[handle], format = _texFormat[handle];
+
+	/* reuse retired storage of the same size if there is any */
+	GLuint name = _usePool ? poolTake(w, h, levels, format) : 0;
+	int recycled = name != 0;
+	if (!recycled) glGenTextures(1, &name);
+	texBind(GL_TEXTURE_2D, name);
+
+	PROFILE_BEGIN("texture upload");
+	if (ready) uploadReady(w, h, levels, format, recycled, ready, data);
+	else uploadMipmaps(w, h, levels, format, recycled, data);
+	PROFILE_END();
+
+	glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+	texParams(linear, repeat);
+
+	publishTexture(handle, name);
+}
+
+static inline void uploadPublish(void)
+{
+	if (!InterlockedExchange(&_upAnyDone, FALSE)) return;
+
+	int waiting = FALSE;
+	for (int i = 0; i < VG_TEXTURES_MAX; i++)
+	{
+		EnterCriticalSection(&_upLock);
+		int done = _upDone[i];
+		GLsync fence = _upFence[i];
+		LeaveCriticalSection(&_upLock);
+		if (!done) continue;
+
+		/* never block, a busy upload is picked up next update */
+		if (fence)
+		{
+			if (glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+			{
+				waiting = TRUE;
+				continue;
+			}
+			glDeleteSync(fence);
+		}
+
+		EnterCriticalSection(&_upLock);
+		GLuint name = _upName[i];
+		int cancel = _upCancel[i];
+		_upDone[i] = FALSE;
+		_upFence[i] = NULL;
+		_upName[i] = 0;
+		_upCancel[i] = FALSE;
+		if (cancel) _texPending[i] = FALSE;
+		LeaveCriticalSection(&_upLock);
+
+		if (cancel) texDelete(1, &name);
+		else publishTexture(i, name);
+		InterlockedDecrement(&_upOutstanding);
+	}
+
+	if (waiting) InterlockedExchange(&_upAnyDone, TRUE);
+}
+
+static inline void hotReloadForget(vgTexture tex)
+{
+	if (!_hrLockInit) return;
+
+	EnterCriticalSection(&_hrLock);
+	free(_hrPath[tex]);
+	free(_hrPending[tex]);
+	_hrPath[tex] = NULL;
+	_hrPending[tex] = NULL;
+	_hrGen[tex]++;
+	LeaveCriticalSection(&_hrLock);
+}
+
+static inline void hotReloadApply(void)
+{
+	if (!InterlockedExchange(&_hrAnyPending, FALSE)) return;
+
+	for (int i = 0; i < VG_TEXTURES_MAX; i++)
+	{
+		/* not uploaded yet, try again next update */
+		if (_texPending[i])
+		{
+			if (_hrPending[i]) InterlockedExchange(&_hrAnyPending, TRUE);
+			continue;
+		}
+
+		EnterCriticalSection(&_hrLock);
+		unsigned char* data = _hrPending[i];
+		_hrPending[i] = NULL;
+		LeaveCriticalSection(&_hrLock);
+
+		if (data == NULL) continue;
+
+		/* same handle, same storage, only the texels change */
+		texBind(GL_TEXTURE_2D, _texBuffer[i]);
+		PROFILE_BEGIN("texture reload");
+		uploadMipmaps(_texWidth[i], _texHeight[i], _texLevels[i],
+			_texFormat[i], TRUE, data);
+		PROFILE_END();
+		_hrReloads++;
+
+		free(data);
+	}
+}
+
+static void pathDirectory(const char* path, char* dir)
+{
+	const char* slash = strrchr(path, '\\');
+	const char* fwd = strrchr(path, '/');
+	if (slash == NULL || (fwd != NULL && fwd > slash)) slash = fwd;
+	if (slash == NULL)
+	{
+		strcpy(dir, ".");
+		return;
+	}
+
+	size_t len = min((size_t)(slash - path), MAX_PATH - 1);
+	memcpy(dir, path, len);
+	dir[len] = 0;
+}
+
+static void hotReloadWatch(vgTexture tex, const char* file)
+{
+	char* path = malloc(strlen(file) + 1);
+	if (path == NULL) return;
+	strcpy(path, file);
+
+	WIN32_FILE_ATTRIBUTE_DATA attr = { 0 };
+	GetFileAttributesExA(file, GetFileExInfoStandard, &attr);
+
+	EnterCriticalSection(&_hrLock);
+	free(_hrPath[tex]);
+	_hrPath[tex] = path;
+	_hrTime[tex] = attr.ftLastWriteTime;
+	LeaveCriticalSection(&_hrLock);
+
+	/* new directory may need watching */
+	InterlockedExchange(&_hrDirty, TRUE);
+	SetEvent(_hrWake);
+}
+
+static inline vgShape findFreeShape(void)
+{
+	for (int i = 0; i < VG_SHAPES_MAX; i++)
+	{
+		if (_shapeBuffer[i] == NULL)
+			return i;
+	}
+
+	return VG_INVALID;
+}
+
+static inline int captureReady(int slot, int wait)
+{
+	/* without sync objects, trust the driver's queue depth */
+	if (_capFence[slot] == NULL)
+		return wait || _frames >= _capFrame[slot] + VG_DEFER_FRAMES;
+
+	GLenum status = glClientWaitSync(_capFence[slot],
+		GL_SYNC_FLUSH_COMMANDS_BIT, wait ? GL_TIMEOUT_IGNORED : 0);
+	if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+		return FALSE;
+
+	glDeleteSync(_capFence[slot]);
+	_capFence[slot] = NULL;
+	return TRUE;
+}
+
+static inline void captureCollect(int wait)
+{
+	/* the writer is done with these, the mapping can go */
+	for (int i = 0; i < VG_CAPTURE_RING; i++)
+	{
+		if (_capState[i] != CAPTURE_WRITTEN) continue;
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, _capBuffer[i]);
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+		_capPixels[i] = NULL;
+		_capState[i] = CAPTURE_FREE;
+	}
+
+	/* map finished reads in the order they were issued */
+	while (_capMapped < _capIssued)
+	{
+		int slot = -1;
+		for (int i = 0; i < VG_CAPTURE_RING; i++)
+			if (_capState[i] == CAPTURE_READING && _capSeq[i] == _capMapped)
+				slot = i;
+		if (slot < 0 || !captureReady(slot, wait)) break;
+
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, _capBuffer[slot]);
+		_capPixels[slot] = glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+		_capMapped++;
+		if (_capPixels[slot] == NULL)
+		{
+			_capState[slot] = CAPTURE_FREE;
+			InterlockedIncrement(&_capDropped);
+			continue;
+		}
+
+		_capState[slot] = CAPTURE_MAPPED;
+		EnterCriticalSection(&_capLock);
+		_capQueue[(_capQueueHead + _capQueueCount) % VG_CAPTURE_RING] = slot;
+		_capQueueCount++;
+		LeaveCriticalSection(&_capLock);
+		SetEvent(_capWake);
+	}
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+static inline void captureFrame(void)
+{
+	captureCollect(FALSE);
+	if (_capSwaps++ % _capEvery) return;
+
+	int slot = -1;
+	for (int i = 0; i < VG_CAPTURE_RING && slot < 0; i++)
+		if (_capState[i] == CAPTURE_FREE) slot = i;
+
+	/* the writer has fallen behind, skip rather than stall the frame */
+	if (slot < 0)
+	{
+		InterlockedIncrement(&_capDropped);
+		return;
+	}
+
+	/* the read lands in the buffer, nothing waits on it here */
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, _framebuffer);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, _capBuffer[slot]);
+	glReadPixels(0, 0, _capW, _capH, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	if (GLEW_ARB_sync)
+		_capFence[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	_capSeq[slot] = _capIssued++;
+	_capFrame[slot] = _frames;
+	_capState[slot] = CAPTURE_READING;
+}
+
+static inline void screenshotCollect(int wait)
+{
+	for (int i = 0; i < VG_SCREENSHOTS_MAX; i++)
+	{
+		if (_shotState[i] == SHOT_READING)
+		{
+			/* without sync objects, trust the driver's queue depth */
+			int ready = wait || _frames >= _shotFrame[i] + VG_DEFER_FRAMES;
+			if (_shotFence[i])
+			{
+				GLenum status = glClientWaitSync(_shotFence[i],
+					GL_SYNC_FLUSH_COMMANDS_BIT, wait ? GL_TIMEOUT_IGNORED : 0);
+				ready = status == GL_ALREADY_SIGNALED ||
+					status == GL_CONDITION_SATISFIED;
+				if (ready) glDeleteSync(_shotFence[i]);
+				if (ready) _shotFence[i] = NULL;
+			}
+			if (!ready) continue;
+
+			/* copy out so the encoder never holds a mapping */
+			size_t size = (size_t)_shotW[i] * _shotH[i] * 4;
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, _shotBuffer[i]);
+			const void* mapped = glMapBuffer(GL_PIXEL_PACK_BUFFER,
+				GL_READ_ONLY);
+			_shotPixels[i] = mapped ? malloc(size) : NULL;
+			if (_shotPixels[i]) memcpy(_shotPixels[i], mapped, size);
+			if (mapped) glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+			glDeleteBuffers(1, &_shotBuffer[i]);
+			_shotBuffer[i] = 0;
+
+			_shotState[i] = SHOT_ENCODING;
+			SetEvent(_shotGo[i]);
+		}
+
+		if (_shotState[i] == SHOT_ENCODING && wait)
+			WaitForSingleObject(_shotThread[i], INFINITE);
+
+		if (_shotState[i] != SHOT_DONE) continue;
+
+		/* report on this thread, the slot is free again by then */
+		char* file = _shotFile[i];
+		vgScreenshotCallback callback = _shotCallback[i];
+		void* user = _shotUser[i];
+		int result = _shotResult[i];
+		WaitForSingleObject(_shotThread[i], INFINITE);
+		CloseHandle(_shotThread[i]);
+		CloseHandle(_shotGo[i]);
+		_shotThread[i] = NULL;
+		_shotGo[i] = NULL;
+		_shotFile[i] = NULL;
+		_shotState[i] = SHOT_FREE;
+
+		if (callback) callback(file, result, user);
+		free(file);
+	}
+}
+
+static void traceCall(int op, const void* data, int size,
+	const char* args, ...)
+{
+	vgTraceArg arg[VG_TRACE_ARGS_MAX];
+	int count = 0;
+
+	/* 'f' marks a float, which arrives promoted to double */
+	/* the hitch recorder only needs to know when GL thread calls start */
+	if (_hitchOn && GetCurrentThreadId() == _glThread)
+	{
+		LARGE_INTEGER now;
+		QueryPerformanceCounter(&now);
+		hitchCall* call = &_hcRing[_hcHead++ & (VG_HITCH_CALLS - 1)];
+		call->time = now.QuadPart;
+		call->op = op;
+	}
+	if (_traceFile == NULL) return;
+
+	va_list list;
+	va_start(list, args);
+	for (; count < VG_TRACE_ARGS_MAX && args[count]; count++)
+	{
+		if (args[count] == 'f') arg[count].f = (float)va_arg(list, double);
+		else arg[count].i = va_arg(list, int);
+	}
+	va_end(list);
+
+	vgTraceRecord record = { (unsigned short)op, (unsigned short)count,
+		(unsigned int)size };
+
+	EnterCriticalSection(&_traceLock);
+	if (_traceFile != NULL)
+	{
+		fwrite(&record, sizeof(record), 1, _traceFile);
+		fwrite(arg, sizeof(vgTraceArg), count, _traceFile);
+		if (size) fwrite(data, 1, size, _traceFile);
+		_traceCalls++;
+	}
+	LeaveCriticalSection(&_traceLock);
+}
+
+static void traceSwap(void)
+{
+	/* swaps carry the frame time they were recorded at in microseconds */
+	LARGE_INTEGER now, freq;
+	QueryPerformanceCounter(&now);
+	QueryPerformanceFrequency(&freq);
+	int frame = 0;
+	if (_traceSwap.QuadPart)
+		frame = (int)((now.QuadPart - _traceSwap.QuadPart) * 1000000 /
+			freq.QuadPart);
+	_traceSwap = now;
+
+	traceCall(VG_TRACE_SWAP, NULL, 0, "i", frame);
+}
+
+static inline int frameBucket(unsigned int us)
+{
+	int shift = 0;
+	while ((us >> shift) >= 128) shift++;
+	return 64 * shift + (us >> shift);
+}
+
+static void hitchSave(void)
+{
+	/* oldest record makes room, the ring may have lost the earliest calls */
+	hitchRecord* record = &_hitch[_hitchSaved % VG_HITCHES_MAX];
+	long long from = max(_hcPendingFrom, _hcHead - VG_HITCH_CALLS);
+	int count = (int)(_hcHead - from);
+
+	free(record->calls);
+	record->calls = malloc(count * sizeof(hitchCall));
+	record->count = record->calls ? count : 0;
+	for (int i = 0; i < record->count; i++)
+		record->calls[i] = _hcRing[(from + i) & (VG_HITCH_CALLS - 1)];
+	record->frame = _hcPendingFrame;
+	record->frameTime = _hcPendingTime;
+	_hitchSaved++;
+}
+
+static void frameStats(void)
+{
+	LARGE_INTEGER now, freq;
+	QueryPerformanceCounter(&now);
+	QueryPerformanceFrequency(&freq);
+	long long last = _ftLast;
+	_ftLast = now.QuadPart;
+	if (last == 0) return;
+
+	long long elapsed = (now.QuadPart - last) * 1000000 / freq.QuadPart;
+	unsigned int us = (unsigned int)min(elapsed, 0xFFFFFFFFLL);
+	_ftBucket[frameBucket(us)]++;
+	_ftCount++;
+	_ftMax = max(_ftMax, us);
+	_hudTimes[_hudHead++ % HUD_SAMPLES] = us;
+
+	if (!_hitchOn) return;
+
+	/* frame _frames - 1 has ended, the next one starts here */
+	hitchCall* marker = &_hcRing[_hcHead++ & (VG_HITCH_CALLS - 1)];
+	marker->time = now.QuadPart;
+	marker->op = 0;
+	marker->frameTime = us;
+	_hcFrameStart[_frames % HITCH_FRAME_RING] = _hcHead;
+
+	if (_hcPendingLeft > 0 && --_hcPendingLeft == 0) hitchSave();
+	if (us < _hitchThreshold) return;
+
+	/* a hitch inside another one's window just extends it */
+	_hitchCount++;
+	if (_hcPendingLeft == 0)
+	{
+		unsigned long long first = _frames - 1 -
+			min(_frames - 1, VG_HITCH_FRAMES_BEFORE);
+		_hcPendingFrom = _hcFrameStart[first % HITCH_FRAME_RING];
+		_hcPendingFrame = _frames - 1;
+		_hcPendingTime = us;
+	}
+	_hcPendingLeft = VG_HITCH_FRAMES_AFTER;
+	if (_hcPendingLeft == 0) hitchSave();
+}
+
+static void overdrawCollect(void)
+{
+	static const unsigned char ramp[][3] = {
+		{ 0, 0, 0 }, { 0, 0, 160 }, { 0, 160, 160 }, { 0, 192, 0 },
+		{ 192, 192, 0 }, { 255, 128, 0 }, { 255, 0, 0 }, { 255, 0, 255 },
+		{ 255, 255, 255 } };
+	const int rampTop = sizeof(ramp) / sizeof(ramp[0]) - 1;
+
+	/* the count stalls until the frame is drawn, fine for a debug mode */
+	PROFILE_BEGIN("overdraw readback");
+	int pixels = _resW * _resH;
+	glBindFramebuffer(GL_FRAMEBUFFER, _framebuffer);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, _resW, _resH, GL_STENCIL_INDEX, GL_UNSIGNED_BYTE,
+		_odCounts);
+	glDisable(GL_STENCIL_TEST);
+	glClear(GL_STENCIL_BUFFER_BIT);
+
+	memset(_odPixels, 0, sizeof(_odPixels));
+	_odWrites = 0;
+	_odMax = 0;
+	for (int i = 0; i < pixels; i++)
+	{
+		int count = _odCounts[i];
+		_odPixels[count]++;
+		_odWrites += count;
+		_odMax = max(_odMax, count);
+	}
+	PROFILE_END();
+
+	if (_odMode != VG_OVERDRAW_HEATMAP) return;
+
+	for (int i = 0; i < pixels; i++)
+	{
+		const unsigned char* color = ramp[min(_odCounts[i], rampTop)];
+		_odHeat[i * 4 + 0] = color[0];
+		_odHeat[i * 4 + 1] = color[1];
+		_odHeat[i * 4 + 2] = color[2];
+		_odHeat[i * 4 + 3] = 255;
+	}
+
+	texBind(GL_TEXTURE_2D, _odTexture);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, _resW, _resH, GL_RGBA,
+		GL_UNSIGNED_BYTE, _odHeat);
+}
+
+static unsigned long long hudTextureMemory(void)
+{
+	/* live, deferred and pooled storage, a mip chain adds a third */
+	unsigned long long total = 0;
+	for (int i = 0; i < VG_TEXTURES_MAX; i++)
+	{
+		if (_texBuffer[i] == 0) continue;
+		unsigned long long size = (unsigned long long)vgFormatSize(
+			_texFormat[i], _texWidth[i], _texHeight[i]) * max(1, _texLayers[i]);
+		total += _texLevels[i] > 1 ? size + size / 3 : size;
+	}
+	for (int i = 0; i < _deferCount; i++)
+	{
+		unsigned long long size = (unsigned long long)vgFormatSize(
+			_deferFormat[i], _deferW[i], _deferH[i]) * max(1, _deferLayers[i]);
+		total += _deferLevels[i] > 1 ? size + size / 3 : size;
+	}
+	for (int i = 0; i < _poolCount; i++)
+	{
+		unsigned long long size = vgFormatSize(_poolFormat[i], _poolW[i],
+			_poolH[i]);
+		total += _poolLevels[i] > 1 ? size + size / 3 : size;
+	}
+
+	return total;
+}
+
+static inline void hudQuad(int x, int y, int w, int h)
+{
+	glVertex2i(x, y);
+	glVertex2i(x, y + h);
+	glVertex2i(x + w, y + h);
+	glVertex2i(x + w, y);
+}
+
+static void hudText(int x, int y, const char* text)
+{
+	for (; *text; text++, x += 4 * HUD_SCALE)
+	{
+		int c = *text >= 'a' && *text <= 'z' ? *text - 0x20 : *text;
+		if (c < 0x20 || c >= 0x60) continue;
+
+		unsigned short glyph = _hudFont[c - 0x20];
+		for (int bit = 0; bit < 15; bit++)
+		{
+			if (!(glyph & (0x4000 >> bit))) continue;
+			hudQuad(x + (bit % 3) * HUD_SCALE, y + (4 - bit / 3) * HUD_SCALE,
+				HUD_SCALE, HUD_SCALE);
+		}
+	}
+}
+
+static void hudDraw(void)
+{
+	const int pad = 4, line = 7 * HUD_SCALE, graphH = 0x40;
+	int w = HUD_SAMPLES * 2 + pad * 2;
+	int h = graphH + line * 4 + pad * 3;
+	int right = _hudCorner == VG_HUD_TOP_RIGHT ||
+		_hudCorner == VG_HUD_BOTTOM_RIGHT;
+	int top = _hudCorner == VG_HUD_TOP_LEFT || _hudCorner == VG_HUD_TOP_RIGHT;
+	int x = right ? _windowWidth - w : 0;
+	int y = top ? _windowHeight - h : 0;
+
+	char text[4][0x30];
+	unsigned int last = _hudHead ? _hudTimes[(_hudHead - 1) % HUD_SAMPLES] : 0;
+	snprintf(text[0], sizeof(text[0]), "FRAME %.2f MS  P99 %.2f",
+		last / 1000.0f, vgFrameTimePercentile(99));
+	snprintf(text[1], sizeof(text[1]), "DRAWS %d  BINDS %d", _hudLastDraws,
+		_hudLastBinds);
+	snprintf(text[2], sizeof(text[2]), "CULLED %d", _hudLastCulled);
+	snprintf(text[3], sizeof(text[3]), "TEXTURES %.1f MB",
+		hudTextureMemory() / 1048576.0);
+
+	/* everything in one batch, the present quad already holds depth 0 */
+	glDisable(GL_DEPTH_TEST);
+	glBegin(GL_QUADS);
+	glColor4ub(0, 0, 0, 160);
+	hudQuad(x, y, w, h);
+
+	/* a bar per frame, newest on the right, full height is 33.3 ms */
+	int samples = (int)min(_hudHead, HUD_SAMPLES);
+	for (int i = 0; i < samples; i++)
+	{
+		unsigned int us = _hudTimes[(_hudHead - samples + i) % HUD_SAMPLES];
+		if (us < 16667) glColor4ub(64, 200, 64, 255);
+		else if (us < 33334) glColor4ub(220, 200, 40, 255);
+		else glColor4ub(220, 50, 50, 255);
+		int bar = (int)min(graphH, max(1, us * (long long)graphH / 33333));
+		hudQuad(x + pad + (HUD_SAMPLES - samples + i) * 2, y + pad, 2, bar);
+	}
+
+	/* 60 fps mark */
+	glColor4ub(255, 255, 255, 96);
+	hudQuad(x + pad, y + pad + graphH / 2, HUD_SAMPLES * 2, 1);
+
+	glColor4ub(255, 255, 255, 255);
+	for (int i = 0; i < 4; i++)
+		hudText(x + pad, y + h - pad - (i + 1) * line + HUD_SCALE, text[i]);
+	glEnd();
+	glEnable(GL_DEPTH_TEST);
+}
+
+/* WINDOW CALLBACK */
+static LRESULT CALLBACK vgWProc(HWND hWnd, UINT message,
+	WPARAM wParam, LPARAM lParam)
+{
+	PIXELFORMATDESCRIPTOR pfd = { 0 };
+
+	switch (message)
+	{
+	case WM_CREATE:
+		/* configure pixelformat */
+		pfd.nSize = sizeof(PIXELFORMATDESCRIPTOR);
+		pfd.nVersion = 1;
+		pfd.dwFlags = PFD_DRAW_TO_WINDOW | PFD_SUPPORT_OPENGL |
+			PFD_DOUBLEBUFFER;
+		pfd.iPixelType = PFD_TYPE_RGBA;
+		pfd.cColorBits = 32;
+		pfd.cDepthBits = 16;
+		pfd.cStencilBits = 16;
+
+		/* get device context */
+		_deviceContext = GetDC(hWnd);
+
+		/* init pixelformat and bind */
+		int formatHandle = ChoosePixelFormat(_deviceContext,
+			&pfd);
+		SetPixelFormat(_deviceContext, formatHandle, &pfd);
+
+		/* create rendering context */
+		_glContext = wglCreateContext(_deviceContext);
+		wglMakeCurrent(_deviceContext, _glContext);
+
+		/* set size properly */
+		
+		break;
+
+	/* on destroy */
+	case WM_DESTROY:
+
+		/* set windowstate to false */
+		_winState = FALSE;
+
+		/* finish background uploads so their textures get freed too */
+		vgUseUploadThread(FALSE);
+		vgStopCapture();
+		vgFinishScreenshots();
+		vgStopTrace();
+		vgUseOverdraw(VG_OVERDRAW_OFF);
+
+		/* free all openGL objects */
+		glDeleteFramebuffers(1, &_framebuffer);
+		glDeleteFramebuffers(1, &_eFrameBuffer);
+		glDeleteFramebuffers(1, &_rFrameBuffer);
+		glDeleteFramebuffers(1, &_bFrameBuffer);
+		glDeleteRenderbuffers(1, &_depth);
+		texDelete(1, &_texture);
+
+		for (int i = 0; i < VG_TEXTURES_MAX; i++)
+		{
+			texDelete(1, &_texBuffer[i]);
+			_texBuffer[i] = NULL;
+		}
+
+		texDelete(_deferCount, _deferName);
+		texDelete(_poolCount, _poolName);
+		_deferCount = 0;
+		_poolCount = 0;
+
+		for (int i = 0; i < VG_FENCE_RING; i++)
+		{
+			if (_fenceSync[i]) glDeleteSync(_fenceSync[i]);
+			_fenceSync[i] = NULL;
+		}
+
+		for (int i = 0; i < VG_SHAPES_MAX; i++)
+		{
+			glDeleteLists(_shapeBuffer[i], 1);
+			_shapeBuffer[i] = NULL;
+			free(_shapeData[i]);
+			_shapeData[i] = NULL;
+		}
+
+		for (int i = 0; i < VG_LARGE_IMAGES_MAX; i++)
+			vgCloseLargeImage(i);
+
+		vgUseHotReload(FALSE);
+
+		for (int i = 0; i < VG_ARCHIVES_MAX; i++)
+			vgCloseArchive(i);
+
+		/* release DC */
+		ReleaseDC(_window, _deviceContext);
+
+		/* destroy gl context */
+		wglDeleteContext(_glContext);
+
+		return DefWindowProc(hWnd, message, wParam, lParam);
+		break;
+
+	/* on default */
+	default:
+		return DefWindowProc(hWnd, message, wParam, lParam);
+		break;
+	}
+
+	return DefWindowProc(hWnd, message, wParam, lParam);
+}
+
+/* INIT AND TERMINATE FUNCTIONS */
+
+VAPI void vgInitRenderFormat(int format)
+{
+	/* only formats that are color renderable are accepted */
+	switch (format)
+	{
+	case VG_FORMAT_RGB8:
+	case VG_FORMAT_RGBA8:
+	case VG_FORMAT_RGB565:
+	case VG_FORMAT_RGBA4444:
+	case VG_FORMAT_RGB5A1:
+		_renderFormat = format;
+		break;
+
+	default:
+		_renderFormat = VG_FORMAT_RGB8;
+		break;
+	}
+}
+
+VAPI void vgInit(int window_w, int window_h, int resolution_w,
+	int resolution_h, int linear)
+{
+	/* setup update count and layer */
+	_updates = 0;
+	_layer = 1.0f;
+	_swapTime = VG_SWAP_TIME_MIN;
+	_renderSkip    = FALSE;
+	_useRenderSkip = TRUE;
+	_texCount = 0;
+	_frames = 0;
+	_retiredFrame = 0;
+	_glThread = GetCurrentThreadId();
+	_renderLinear = linear;
+
+	/* enable DPI awareness */
+	SetProcessDPIAware();
+
+	/* create window */
+
+	/* setup and register window class */
+	WNDCLASSA wClass = { 0 };
+	wClass.lpfnWndProc = vgWProc;
+	wClass.lpszClassName = "vgWindow";
+	int regResult = RegisterClassA(&wClass);
+
+	/* check if reg failed */
+	/* 1410 means class already exists, so it's ok */
+	int errCode = GetLastError();
+	if (!regResult && errCode != 1410)
+	{
+		char cBuff[0xFF];
+		sprintf(cBuff, "Register Window Class!\nError Code: %d\n",
+			errCode);
+		MessageBoxA(NULL, cBuff, "CRITICAL ENGINE FAILURE", MB_OK);
+		exit(1);
+	}
+
+	/* ensure window size is big enough */
+	RECT clientRect = { 0, 0, window_w, window_h };
+	AdjustWindowRectExForDpi(&clientRect,
+		WS_VISIBLE | WS_SYSMENU | WS_MAXIMIZEBOX |
+		WS_THICKFRAME, TRUE,
+		WS_VISIBLE | WS_SYSMENU | WS_MAXIMIZEBOX |
+		WS_THICKFRAME,
+		GetDpiForSystem());
+	int winWidth = clientRect.right - clientRect.left;
+	int winHeight = clientRect.bottom - clientRect.top;
+
+	/* create window */
+	_window = CreateWindowA(wClass.lpszClassName, " ",
+		WS_VISIBLE | WS_SYSMENU | WS_MAXIMIZEBOX, CW_USEDEFAULT,
+		CW_USEDEFAULT, winWidth, winHeight, 0, 0, NULL, 0);
+
+	/* window err handling */
+	if (_window == NULL)
+	{
+		char cBuff[0xFF];
+		sprintf(cBuff, "Window Creation Failed!\nError Code: %d\n",
+			GetLastError());
+		MessageBoxA(NULL, cBuff, "CRITICAL ENGINE FAILURE", MB_OK);
+		exit(1);
+	}
+
+	int glewStatus = glewInit();
+	if (glewStatus != GLEW_OK)
+	{
+		MessageBoxA(NULL, "Could not locate OpenGL extensions!", "FATAL ERROR",
+			MB_OK);
+		exit(1);
+	}
+
+	/* check for missing support */
+	if (glBindFramebuffer == NULL)
+	{
+		const char* msg = "Your OpenGL does not support Framebuffers\n"
+			"This is a crucial feature used in VGraphics.dll and cannot"
+			"be skipped.";
+		MessageBoxA(NULL, msg, "FATAL ERROR", MB_OK);
+		exit(1);
+	}
+
+	/* clear and swap to remove artifacts */
+	glBindFramebuffer(GL_FRAMEBUFFER, NULL);
+	glClear(GL_COLOR_BUFFER_BIT);
+	SwapBuffers(_deviceContext);
+
+	/* create framebuffer and texture */
+	glGenFramebuffers(1, &_framebuffer);
+	glGenTextures(1, &_texture);
+	glBindFramebuffer(GL_FRAMEBUFFER, _framebuffer);
+	texBind(GL_TEXTURE_2D, _texture);
+	glTexImage2D(GL_TEXTURE_2D, NULL, fmtInternal(_renderFormat),
+		resolution_w, resolution_h, NULL, _fmtUpload[_renderFormat],
+		_fmtType[_renderFormat], NULL);
+
+	/* set texture filter params */
+	switch (linear)
+	{
+	case 0:
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		break;
+	case 1:
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		break;
+	default:
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		break;
+	}
+
+	/* add depth to framebuffer, stencil is only used to count overdraw */
+	glGenRenderbuffers(1, &_depth);
+	glBindRenderbuffer(GL_RENDERBUFFER, _depth);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, resolution_w,
+		resolution_h);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT,
+		GL_RENDERBUFFER, _depth);
+
+	/* enable depth */
+	glEnable(GL_DEPTH_TEST);
+
+	/* connect framebuffer with texture */
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+		_texture, NULL);
+	glDrawBuffer(GL_COLOR_ATTACHMENT0);
+
+	/* fall back to RGB8 if the chosen format can't be rendered to */
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE &&
+		_renderFormat != VG_FORMAT_RGB8)
+	{
+		_renderFormat = VG_FORMAT_RGB8;
+		glTexImage2D(GL_TEXTURE_2D, NULL, GL_RGB8, resolution_w,
+			resolution_h, NULL, GL_RGB, GL_UNSIGNED_BYTE, NULL);
+	}
+
+	/* setup texture filter params */
+	_tcolR = 255;
+	_tcolG = 255;
+	_tcolB = 255;
+	_tcolA = 255;
+
+	/* setup projection */
+	_windowWidth = window_w;
+	_windowHeight = window_h;
+	_resW = resolution_w;
+	_resH = resolution_h;
+
+	_vpx = 0;
+	_vpy = 0;
+	_vpw = resolution_w;
+	_vph = resolution_h;
+
+	_rScale = 1; _useRScale = 1;
+	_rOffsetX = 0; _rOffsetY = 0; _useROffset = 1;
+
+	/* init texture editing data */
+	glGenFramebuffers(1, &_eFrameBuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, _eFrameBuffer);
+
+	/* init texture reading framebuffer */
+	glGenFramebuffers(1, &_rFrameBuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, _rFrameBuffer);
+	glGenFramebuffers(1, &_bFrameBuffer);
+
+	/* setup blend funcs */
+	glEnable(GL_BLEND);
+	glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA,
+		GL_ONE, GL_ONE);
+
+	/* set winstate to true */
+	_winState = TRUE;
+}
+
+VAPI void vgTerminate(void)
+{
+	/* if window is open, close it */
+	if (_winState) DestroyWindow(_window);
+}
+
+/* MODULE UPDATE FUNCTIONS */
+
+static long long _lastTick = 0;
+VAPI void vgUpdate(void)
+{
+	TRACE(VG_TRACE_UPDATE, "");
+	PROFILE_BEGIN("vgUpdate");
+	_updates++;
+
+	/* dispatch messages */
+	MSG messageCheck;
+	PeekMessageA(&messageCheck, NULL, NULL, NULL,
+		PM_REMOVE);
+	DispatchMessageA(&messageCheck);
+
+	/* textures finished by the upload thread become usable */
+	if (_upRunning) uploadPublish();
+
+	/* upload textures the watcher has re-read */
+	if (_hrRunning) hotReloadApply();
+
+	/* hand finished screenshot reads to their encoders */
+	screenshotCollect(FALSE);
+
+	/* flush openGL */
+	if (GetTickCount64() > _lastTick + 
+		VG_FLUSH_THRESHOLD)
+	{
+		glFlush();
+		_lastTick = GetTickCount64();
+	}
+	PROFILE_END();
+}
+
+VAPI unsigned long long vgUpdateCount(void)
+{
+	return _updates;
+}
+
+/* MISC RENDERING FUNCTIONS */
+
+VAPI void vgSetWindowSize(int window_w, int window_h)
+{
+	TRACE(VG_TRACE_SET_WINDOW_SIZE, "ii", window_w, window_h);
+
+	/* calculate target rect */
+	RECT tRect = { 0, 0, window_w, window_h };
+	AdjustWindowRectExForDpi(&tRect,
+		WS_VISIBLE | WS_SYSMENU | WS_MAXIMIZEBOX |
+		WS_THICKFRAME, TRUE,
+		WS_VISIBLE | WS_SYSMENU | WS_MAXIMIZEBOX |
+		WS_THICKFRAME,
+		GetDpiForSystem());
+	int winWidth  = tRect.right - tRect.left;
+	int winHeight = tRect.bottom - tRect.top;
+
+	/* set new window pos (NOMOVE) */
+	SetWindowPos(_window,
+		NULL, 0, 0,
+		winWidth,
+		winHeight,
+		SWP_NOMOVE);
+
+	/* clear and swap to remove artifacts */
+	glBindFramebuffer(GL_FRAMEBUFFER, NULL);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	SwapBuffers(_deviceContext);
+
+	/* update window dimensions */
+	_windowWidth = window_w;
+	_windowHeight = window_h;
+}
+
+VAPI void vgGetResolution(int* w, int* h)
+{
+	*w = _resW; *h = _resH;
+}
+
+VAPI void vgSetWindowTitle(const char* title)
+{
+	SetWindowTextA(_window, title);
+}
+
+VAPI void vgGetScreenSize(int* width, int* height)
+{
+	int screenX = GetSystemMetrics(SM_CXSCREEN);
+	int screenY = GetSystemMetrics(SM_CYSCREEN);
+	*width  = screenX;
+	*height = screenY;
+}
+
+VAPI int vgWindowIsClosed(void)
+{
+	return (!_winState);
+}
+
+VAPI void vgSetSwapTime(int swapTime)
+{
+	TRACE(VG_TRACE_SET_SWAP_TIME, "i", swapTime);
+
+	/* check for bad state */
+	if (swapTime < VG_SWAP_TIME_MIN) return;
+
+	/* set new swaptime */
+	_swapTime = swapTime;
+}
+
+VAPI void vgUseRenderSkip(int state)
+{
+	TRACE(VG_TRACE_USE_RENDER_SKIP, "i", state);
+
+	_useRenderSkip = state;
+}
+
+VAPI int vgGetRenderSkipState(void)
+{
+	return _renderSkip && _useRenderSkip;
+}
+
+/* CLEAR AND SWAP FUNCTIONS */
+
+VAPI void vgClear(void)
+{
+	TRACE(VG_TRACE_CLEAR, "");
+
+	RENDERSKIP(_useRenderSkip);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, _framebuffer);
+	glViewport(0, 0, _resW, _resH);
+	glClearColor(0, 0, 0, 1);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+VAPI void vgFill(int r, int g, int b)
+{
+	TRACE(VG_TRACE_FILL, "iii", r, g, b);
+
+	RENDERSKIP(_useRenderSkip);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, _framebuffer);
+	glViewport(0, 0, _resW, _resH);
+	glClearColor(r / 255.0f, g / 255.0f, b / 255.0f, 1);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+VAPI void vgFillRegion(int x, int y, int w, int h, int r, int g, int b)
+{
+	TRACE(VG_TRACE_FILL_REGION, "iiiiiii", x, y, w, h, r, g, b);
+
+	RENDERSKIP(_useRenderSkip);
+
+	/* same as vgFill, limited to a rectangle of the render target */
+	glBindFramebuffer(GL_FRAMEBUFFER, _framebuffer);
+	glViewport(0, 0, _resW, _resH);
+	glEnable(GL_SCISSOR_TEST);
+	glScissor(x, y, w, h);
+	glClearColor(r / 255.0f, g / 255.0f, b / 255.0f, 1);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	glDisable(GL_SCISSOR_TEST);
+}
+
+static ULONGLONG __lastSwap = 0;
+VAPI void vgSwap(void)
+{
+	if (TRACING()) traceSwap();
+
+	/* limit swap time */
+	ULONGLONG currentTime = GetTickCount64();
+	if ((currentTime - __lastSwap) < _swapTime)
+	{
+		_renderSkip = TRUE;
+		return;
+	}
+
+	__lastSwap  = currentTime;
+	_renderSkip = FALSE;
+
+	/* perform swap */
+	PROFILE_BEGIN("vgSwap");
+	if (_odMode) overdrawCollect();
+	_hudLastDraws = _hudDraws;
+	_hudLastBinds = _hudBinds;
+	_hudLastCulled = _hudCulled;
+	_hudDraws = 0;
+	_hudBinds = 0;
+	_hudCulled = 0;
+	rsetup();
+	
+	glClearColor(0, 0, 0, 1);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	texBind(GL_TEXTURE_2D, _odMode == VG_OVERDRAW_HEATMAP ?
+		_odTexture : _texture);
+
+	glColor4ub(255, 255, 255, 255);
+
+	glEnable(GL_TEXTURE_2D);
+	glBegin(GL_QUADS);
+	glTexCoord2i(0, 0); glVertex2i(0, 0);
+	glTexCoord2i(0, 1); glVertex2i(0, _windowHeight);
+	glTexCoord2i(1, 1); glVertex2i(_windowWidth, _windowHeight);
+	glTexCoord2i(1, 0); glVertex2i(_windowWidth, 0);
+	glEnd();
+	glDisable(GL_TEXTURE_2D);
+
+	/* over the presented frame, never part of the render target */
+	if (_hudCorner) hudDraw();
+
+	PROFILE_BEGIN("SwapBuffers");
+	SwapBuffers(_deviceContext);
+	PROFILE_END();
+
+	/* queue the finished frame's readback before fencing it */
+	if (_capRunning) captureFrame();
+	screenshotCollect(FALSE);
+
+	/* fence frame and recycle textures the GPU is done with */
+	fenceFrame();
+	retireTextures();
+	_frames++;
+	frameStats();
+	PROFILE_END();
+}
+
+/* BASIC DRAW FUNCTIONS */
+
+VAPI void vgColor3(int r, int g, int b)
+{
+	TRACE(VG_TRACE_COLOR3, "iii", r, g, b);
+
+	_colR = r;
+	_colG = g;
+	_colB = b;
+	_colA = 255;
+}
+
+VAPI void vgColor4(int r, int g, int b, int a)
+{
+	TRACE(VG_TRACE_COLOR4, "iiii", r, g, b, a);
+
+	_colR = r;
+	_colG = g;
+	_colB = b;
+	_colA = a;
+}
+
+VAPI void vgRect(int x, int y, int w, int h)
+{
+	TRACE(VG_TRACE_RECT, "iiii", x, y, w, h);
+
+	RENDERSKIP(_useRenderSkip); psetup();
+
+	glBegin(GL_QUADS);
+	glVertex2i(x, y);
+	glVertex2i(x, y + h);
+	glVertex2i(x + w, y + h);
+	glVertex2i(x + w, y);
+	glEnd();
+}
+
+VAPI void vgLineSize(float size)
+{
+	TRACE(VG_TRACE_LINE_SIZE, "f", size);
+
+	_lineW = size;
+}
+
+VAPI void vgLine(int x1, int y1, int x2, int y2)
+{
+	TRACE(VG_TRACE_LINE, "iiii", x1, y1, x2, y2);
+
+	RENDERSKIP(_useRenderSkip); psetup();
+
+	glLineWidth(_lineW);
+
+	glBegin(GL_LINES);
+	glVertex2i(x1, y1);
+	glVertex2i(x2, y2);
+	glEnd();
+}
+
+VAPI void vgPointSize(float size)
+{
+	TRACE(VG_TRACE_POINT_SIZE, "f", size);
+
+	_pointW = size;
+}
+
+VAPI void vgPoint(int x, int y)
+{
+	TRACE(VG_TRACE_POINT, "ii", x, y);
+
+	RENDERSKIP(_useRenderSkip); psetup();
+
+	glPointSize(_pointW);
+	
+	glBegin(GL_POINTS);
+	glVertex2i(x, y);
+	glEnd();
+}
+
+VAPI void vgViewport(int x, int y, int w, int h)
+{
+	TRACE(VG_TRACE_VIEWPORT, "iiii", x, y, w, h);
+
+	_vpx = x;
+	_vpy = y;
+	_vpw = w;
+	_vph = h;
+}
+
+VAPI void vgViewportReset(void)
+{
+	TRACE(VG_TRACE_VIEWPORT_RESET, "");
+
+	_vpx = 0;
+	_vpy = 0;
+	_vpw = _resW;
+	_vph = _resH;
+}
+
+/* FLOAT VARIANTS */
+
+VAPI void vgRectf(float x, float y, float w, float h)
+{
+	TRACE(VG_TRACE_RECTF, "ffff", x, y, w, h);
+
+	RENDERSKIP(_useRenderSkip); psetup();
+
+	glBegin(GL_QUADS);
+	glVertex2f(x, y);
+	glVertex2f(x, y + h);
+	glVertex2f(x + w, y + h);
+	glVertex2f(x + w, y);
+	glEnd();
+}
+
+VAPI void vgLinef(float x1, float y1, float x2, float y2)
+{
+	TRACE(VG_TRACE_LINEF, "ffff", x1, y1, x2, y2);
+
+	RENDERSKIP(_useRenderSkip); psetup();
+
+	glLineWidth(_lineW);
+
+	glBegin(GL_LINES);
+	glVertex2f(x1, y1);
+	glVertex2f(x2, y2);
+	glEnd();
+}
+
+VAPI void vgPointf(float x, float y)
+{
+	TRACE(VG_TRACE_POINTF, "ff", x, y);
+
+	RENDERSKIP(_useRenderSkip); psetup();
+
+	glPointSize(_pointW);
+
+	glBegin(GL_POINTS);
+	glVertex2f(x, y);
+	glEnd();
+}
+
+/* ADVANCED DRAW FUNCTIONS */
+
+VAPI vgTexture vgCreateTexture(int w, int h, int linear, int repeat,
+	void* data)
+{
+	return vgCreateTextureFormat(w, h, linear, repeat, VG_FORMAT_RGBA8,
+		data);
+}
+
+VAPI vgTexture vgCreateTextureFormat(int w, int h, int linear, int repeat,
+	int format, void* data)
+{
+	if (format < 0 || format >= FORMAT_COUNT) format = VG_FORMAT_RGBA8;
+
+	/* no S3TC support, keep the texture uncompressed */
+	if (fmtCompressed(format) && !GLEW_EXT_texture_compression_s3tc)
+		format = VG_FORMAT_RGBA8;
+
+	int mipmap = (linear == VG_LINEAR_MIPMAP || linear == VG_NEAREST_MIPMAP);
+	int levels = mipmap ? mipLevels(w, h) : 1;
+	vgTexture handle = reserveTexture(w, h, levels, format);
+	if (handle == VG_INVALID) return VG_INVALID;
+	TRACE_DATA(VG_TRACE_CREATE_TEXTURE, data, data ? w * h * 4 : 0, "iiiiii",
+		w, h, linear, repeat, format, handle);
+
+	textureUpload(handle, linear, repeat, 0, data);
+	return handle;
+}
+
+VAPI void vgDestroyTexture(vgTexture tex)
+{
+	TRACE(VG_TRACE_DESTROY_TEXTURE, "i", tex);
+
+	VALIDATE(liveTexture(tex), VG_VALIDATE_HANDLE, "texture %d is not live",
+		tex);
+
+	/* still uploading, the upload thread drops it when it gets there */
+	if (_texPending[tex])
+	{
+		EnterCriticalSection(&_upLock);
+		_upCancel[tex] = TRUE;
+		_texCount--;
+		LeaveCriticalSection(&_upLock);
+		hotReloadForget(tex);
+		return;
+	}
+
+	if (_texBuffer[tex] == 0) return;
+
+	/* queue is full, fall back to deleting immediately */
+	if (_deferCount >= VG_DEFER_MAX)
+	{
+		readForget(_texBuffer[tex]);
+		texDelete(1, &_texBuffer[tex]);
+	}
+	else
+	{
+		/* the GPU may still be reading it, defer until frame retires */
+		_deferName[_deferCount] = _texBuffer[tex];
+		_deferW[_deferCount] = _texWidth[tex];
+		_deferH[_deferCount] = _texHeight[tex];
+		_deferLevels[_deferCount] = _texLevels[tex];
+		_deferFormat[_deferCount] = _texFormat[tex];
+		_deferLayers[_deferCount] = _texLayers[tex];
+		_deferFrame[_deferCount] = _frames;
+		_deferCount++;
+	}
+
+	if (_upLockInit) EnterCriticalSection(&_upLock);
+	_texBuffer[tex] = NULL;
+	_texCount--;
+	if (_upLockInit) LeaveCriticalSection(&_upLock);
+
+	hotReloadForget(tex);
+}
+
+VAPI void vgUseTexturePool(int state)
+{
+	TRACE(VG_TRACE_USE_TEXTURE_POOL, "i", state);
+
+	_usePool = state;
+	_traceMute++;
+	if (!_usePool) vgTexturePoolClear();
+	_traceMute--;
+}
+
+VAPI void vgTexturePoolClear(void)
+{
+	TRACE(VG_TRACE_TEXTURE_POOL_CLEAR, "");
+
+	for (int i = 0; i < _poolCount; i++)
+		readForget(_poolName[i]);
+	texDelete(_poolCount, _poolName);
+	_poolCount = 0;
+}
+
+VAPI void vgUseCPUMipmaps(int state)
+{
+	TRACE(VG_TRACE_USE_CPU_MIPMAPS, "i", state);
+
+	_cpuMipmaps = state;
+}
+
+VAPI void vgTextureLODBias(vgTexture tex, float bias)
+{
+	TRACE(VG_TRACE_TEXTURE_LOD_BIAS, "if", tex, bias);
+
+	VALIDATE(liveTexture(tex), VG_VALIDATE_HANDLE, "texture %d is not live",
+		tex);
+
+	texBind(GL_TEXTURE_2D, _texBuffer[tex]);
+	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_LOD_BIAS, bias);
+}
+
+VAPI void vgRegenerateMipmaps(vgTexture tex)
+{
+	TRACE(VG_TRACE_REGENERATE_MIPMAPS, "i", tex);
+
+	VALIDATE(liveTexture(tex), VG_VALIDATE_HANDLE, "texture %d is not live",
+		tex);
+
+	if (_texLevels[tex] <= 1) return;
+
+	texBind(GL_TEXTURE_2D, _texBuffer[tex]);
+
+	/* GPU path, no readback needed */
+	if (!_cpuMipmaps && glGenerateMipmap != NULL &&
+		!fmtCompressed(_texFormat[tex]))
+	{
+		glGenerateMipmap(GL_TEXTURE_2D);
+		return;
+	}
+
+	/* CPU path, rebuild chain from level 0 and leave level 0 alone, */
+	/* encoding it again would only lose detail on compressed formats */
+	unsigned char* data = malloc(_texWidth[tex] * _texHeight[tex] * 4);
+	if (data == NULL) return;
+
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+	uploadChain(_texWidth[tex], _texHeight[tex], 0, _texLevels[tex],
+		_texFormat[tex], TRUE, data);
+
+	free(data);
+}
+
+VAPI void vgBuildMipmapData(int w, int h, const void* src, void* dst)
+{
+	const unsigned char* s = src;
+	unsigned char* d = dst;
+	int dw = max(1, w >> 1);
+	int dh = max(1, h >> 1);
+	int stride = w * 4;
+
+	for (int y = 0; y < dh; y++)
+	{
+		/* clamp for 1 texel tall sources */
+		const unsigned char* r0 = s + (min(y * 2, h - 1) * stride);
+		const unsigned char* r1 = s + (min(y * 2 + 1, h - 1) * stride);
+		unsigned char* out = d + (y * dw * 4);
+		int x = 0;
+
+		/* 4 output texels per step, averaging row pairs then columns */
+		/* each pair is fully inside the source unless w == 1 */
+		if (w > 1)
+		{
+			for (; x + 4 <= dw; x += 4)
+			{
+				__m128i a0 = _mm_loadu_si128((const __m128i*)(r0 + x * 8));
+				__m128i a1 = _mm_loadu_si128((const __m128i*)(r0 + x * 8 + 16));
+				__m128i b0 = _mm_loadu_si128((const __m128i*)(r1 + x * 8));
+				__m128i b1 = _mm_loadu_si128((const __m128i*)(r1 + x * 8 + 16));
+				__m128 v0 = _mm_castsi128_ps(_mm_avg_epu8(a0, b0));
+				__m128 v1 = _mm_castsi128_ps(_mm_avg_epu8(a1, b1));
+				__m128i even = _mm_castps_si128(_mm_shuffle_ps(v0, v1,
+					_MM_SHUFFLE(2, 0, 2, 0)));
+				__m128i odd = _mm_castps_si128(_mm_shuffle_ps(v0, v1,
+					_MM_SHUFFLE(3, 1, 3, 1)));
+				_mm_storeu_si128((__m128i*)(out + x * 4),
+					_mm_avg_epu8(even, odd));
+			}
+		}
+
+		/* remaining texels */
+		for (; x < dw; x++)
+		{
+			int c0 = x * 2 * 4;
+			int c1 = min(x * 2 + 1, w - 1) * 4;
+			for (int c = 0; c < 4; c++)
+			{
+				out[x * 4 + c] = (unsigned char)((r0[c0 + c] + r0[c1 + c] +
+					r1[c0 + c] + r1[c1 + c] + 2) >> 2);
+			}
+		}
+	}
+}
+
+VAPI int vgFormatSize(int format, int w, int h)
+{
+	if (format < 0 || format >= FORMAT_COUNT) return 0;
+	if (fmtCompressed(format))
+		return _fmtBytes[format] * ((w + 3) / 4) * ((h + 3) / 4);
+	return _fmtBytes[format] * w * h;
+}
+
+VAPI void vgConvertTextureData(int w, int h, int format, const void* src,
+	void* dst)
+{
+	const unsigned char* s = src;
+	unsigned char* d = dst;
+	int count = w * h;
+	int i = 0;
+
+	const __m128i m565r = _mm_set1_epi32(0xF8);
+	const __m128i m565g = _mm_set1_epi32(0xFC00);
+	const __m128i m565b = _mm_set1_epi32(0xF80000);
+	const __m128i m4r = _mm_set1_epi32(0xF0);
+	const __m128i m4g = _mm_set1_epi32(0xF000);
+	const __m128i m4b = _mm_set1_epi32(0xF00000);
+	const __m128i m5g = _mm_set1_epi32(0xF800);
+	const __m128i mLow = _mm_set1_epi32(0xFFFF);
+
+	switch (format)
+	{
+	case VG_FORMAT_RGBA8:
+		memcpy(d, s, count * 4);
+		break;
+
+	case VG_FORMAT_A8:
+		/* 16 texels per step, keep the top byte of each */
+		for (; i + 16 <= count; i += 16)
+		{
+			const __m128i* in = (const __m128i*)(s + i * 4);
+			__m128i a0 = _mm_srli_epi32(_mm_loadu_si128(in + 0), 24);
+			__m128i a1 = _mm_srli_epi32(_mm_loadu_si128(in + 1), 24);
+			__m128i a2 = _mm_srli_epi32(_mm_loadu_si128(in + 2), 24);
+			__m128i a3 = _mm_srli_epi32(_mm_loadu_si128(in + 3), 24);
+			_mm_storeu_si128((__m128i*)(d + i), _mm_packus_epi16(
+				_mm_packs_epi32(a0, a1), _mm_packs_epi32(a2, a3)));
+		}
+		for (; i < count; i++)
+			d[i] = s[i * 4 + 3];
+		break;
+
+	case VG_FORMAT_RG8:
+		for (; i + 8 <= count; i += 8)
+		{
+			const __m128i* in = (const __m128i*)(s + i * 4);
+			__m128i p0 = _mm_and_si128(_mm_loadu_si128(in + 0), mLow);
+			__m128i p1 = _mm_and_si128(_mm_loadu_si128(in + 1), mLow);
+			_mm_storeu_si128((__m128i*)(d + i * 2), pack32to16(p0, p1));
+		}
+		for (; i < count; i++)
+		{
+			d[i * 2 + 0] = s[i * 4 + 0];
+			d[i * 2 + 1] = s[i * 4 + 1];
+		}
+		break;
+
+	case VG_FORMAT_RGB565:
+		for (; i + 8 <= count; i += 8)
+		{
+			__m128i out[2];
+			for (int j = 0; j < 2; j++)
+			{
+				__m128i p = _mm_loadu_si128((const __m128i*)(s + i * 4) + j);
+				__m128i r = _mm_slli_epi32(_mm_and_si128(p, m565r), 8);
+				__m128i g = _mm_srli_epi32(_mm_and_si128(p, m565g), 5);
+				__m128i b = _mm_srli_epi32(_mm_and_si128(p, m565b), 19);
+				out[j] = _mm_or_si128(_mm_or_si128(r, g), b);
+			}
+			_mm_storeu_si128((__m128i*)(d + i * 2),
+				pack32to16(out[0], out[1]));
+		}
+		for (; i < count; i++)
+		{
+			const unsigned char* p = s + i * 4;
+			unsigned short v = (unsigned short)(((p[0] >> 3) << 11) |
+				((p[1] >> 2) << 5) | (p[2] >> 3));
+			memcpy(d + i * 2, &v, 2);
+		}
+		break;
+
+	case VG_FORMAT_RGBA4444:
+		for (; i + 8 <= count; i += 8)
+		{
+			__m128i out[2];
+			for (int j = 0; j < 2; j++)
+			{
+				__m128i p = _mm_loadu_si128((const __m128i*)(s + i * 4) + j);
+				__m128i r = _mm_slli_epi32(_mm_and_si128(p, m4r), 8);
+				__m128i g = _mm_srli_epi32(_mm_and_si128(p, m4g), 4);
+				__m128i b = _mm_srli_epi32(_mm_and_si128(p, m4b), 16);
+				__m128i a = _mm_srli_epi32(p, 28);
+				out[j] = _mm_or_si128(_mm_or_si128(r, g), _mm_or_si128(b, a));
+			}
+			_mm_storeu_si128((__m128i*)(d + i * 2),
+				pack32to16(out[0], out[1]));
+		}
+		for (; i < count; i++)
+		{
+			const unsigned char* p = s + i * 4;
+			unsigned short v = (unsigned short)(((p[0] >> 4) << 12) |
+				((p[1] >> 4) << 8) | ((p[2] >> 4) << 4) | (p[3] >> 4));
+			memcpy(d + i * 2, &v, 2);
+		}
+		break;
+
+	case VG_FORMAT_RGB5A1:
+		for (; i + 8 <= count; i += 8)
+		{
+			__m128i out[2];
+			for (int j = 0; j < 2; j++)
+			{
+				__m128i p = _mm_loadu_si128((const __m128i*)(s + i * 4) + j);
+				__m128i r = _mm_slli_epi32(_mm_and_si128(p, m565r), 8);
+				__m128i g = _mm_srli_epi32(_mm_and_si128(p, m5g), 5);
+				__m128i b = _mm_srli_epi32(_mm_and_si128(p, m565b), 18);
+				__m128i a = _mm_srli_epi32(p, 31);
+				out[j] = _mm_or_si128(_mm_or_si128(r, g), _mm_or_si128(b, a));
+			}
+			_mm_storeu_si128((__m128i*)(d + i * 2),
+				pack32to16(out[0], out[1]));
+		}
+		for (; i < count; i++)
+		{
+			const unsigned char* p = s + i * 4;
+			unsigned short v = (unsigned short)(((p[0] >> 3) << 11) |
+				((p[1] >> 3) << 6) | ((p[2] >> 3) << 1) | (p[3] >> 7));
+			memcpy(d + i * 2, &v, 2);
+		}
+		break;
+
+	case VG_FORMAT_RGB8:
+		for (; i < count; i++)
+		{
+			d[i * 3 + 0] = s[i * 4 + 0];
+			d[i * 3 + 1] = s[i * 4 + 1];
+			d[i * 3 + 2] = s[i * 4 + 2];
+		}
 		break;
+
+	case VG_FORMAT_BC1:
+	case VG_FORMAT_BC3:
+		compressBlocks(w, h, format, s, d);
+		break;
+
 	default:
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 		break;
 	}
+}
+
+VAPI void vgUseTexture(vgTexture target)
+{
+	TRACE(VG_TRACE_USE_TEXTURE, "i", target);
+
+	VALIDATE(liveTexture(target), VG_VALIDATE_HANDLE, "texture %d is not live",
+		target);
+
+	_useTex = target;
+}
+
+VAPI void vgTextureFilter(int r, int g, int b, int a)
+{
+	TRACE(VG_TRACE_TEXTURE_FILTER, "iiii", r, g, b, a);
+
+	_tcolR = r;
+	_tcolG = g;
+	_tcolB = b;
+	_tcolA = a;
+}
+
+VAPI void vgTextureFilterReset(void)
+{
+	TRACE(VG_TRACE_TEXTURE_FILTER_RESET, "");
+
+	_tcolR = 255;
+	_tcolG = 255;
+	_tcolB = 255;
+	_tcolA = 255;
+}
+
+VAPI void vgRectTexture(int x, int y, int w, int h)
+{
+	TRACE(VG_TRACE_RECT_TEXTURE, "iiii", x, y, w, h);
+
+	_traceMute++;
+	vgRectTextureLayer(x, y, w, h, _useLayer);
+	_traceMute--;
+}
+
+VAPI void vgRectTextureOffset(int x, int y, int w, int h, float s, float t)
+{
+	TRACE(VG_TRACE_RECT_TEXTURE_OFFSET, "iiiiff", x, y, w, h, s, t);
+
+	VALIDATE(liveTexture(_useTex), VG_VALIDATE_STATE,
+		"texture %d in use is not live", _useTex);
+
+	RENDERSKIP(_useRenderSkip); psetup();
+
+	GLenum target = texEnable(_useTex);
+	glColor4ub(_tcolR, _tcolG, _tcolB, _tcolA);
+	float r = layerCoord(_useTex, _useLayer);
+
+	/* apply texture coordinate offsets */
+	glMatrixMode(GL_TEXTURE);
+	glLoadIdentity();
+	glTranslatef(s, t, 0);
+
+	glMatrixMode(GL_MODELVIEW);
+
+	glBegin(GL_QUADS);
+	glTexCoord3f(0, 0, r); glVertex2i(x, y);
+	glTexCoord3f(0, 1, r); glVertex2i(x, y + h);
+	glTexCoord3f(1, 1, r); glVertex2i(x + w, y + h);
+	glTexCoord3f(1, 0, r); glVertex2i(x + w, y);
+	glEnd();
+
+	glDisable(target);
+}
+
+VAPI vgTexture vgCreateTextureArray(int w, int h, int layers, int linear,
+	int repeat, void** data)
+{
+	int sized = w > 0 && h > 0 && w <= TEXTURE_SIZE_MAX &&
+		h <= TEXTURE_SIZE_MAX && layers > 0 && layers <= TEXTURE_SIZE_MAX;
+	VALIDATE_OR(VG_INVALID, sized, VG_VALIDATE_BOUNDS,
+		"%d layers of %d x %d", layers, w, h);
+	if (!sized) return VG_INVALID;
+
+	vgTexture handle = reserveTexture(w, h, 1, VG_FORMAT_RGBA8);
+	if (handle == VG_INVALID) return VG_INVALID;
+	_texLayers[handle] = layers;
+
+	GLuint name;
+	glGenTextures(1, &name);
+	texBind(GL_TEXTURE_3D, name);
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage3D(GL_TEXTURE_3D, 0, GL_RGBA8, w, h, layers, 0, GL_RGBA,
+		GL_UNSIGNED_BYTE, NULL);
+
+	/* one upload per layer, NULL layers are left undefined */
+	for (int i = 0; data != NULL && i < layers; i++)
+	{
+		if (data[i] == NULL) continue;
+		glTexSubImage3D(GL_TEXTURE_3D, 0, 0, 0, i, w, h, 1, GL_RGBA,
+			GL_UNSIGNED_BYTE, data[i]);
+	}
+
+	/* layers must never wrap or blend into each other */
+	GLint wrap = (repeat == 1) ? GL_REPEAT : GL_CLAMP;
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, wrap);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, wrap);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+
+	/* mipmaps of a 3D texture would mix layers, so they are ignored */
+	GLint filter = (linear == VG_LINEAR || linear == VG_LINEAR_MIPMAP) ?
+		GL_LINEAR : GL_NEAREST;
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, filter);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, filter);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAX_LEVEL, 0);
+
+	publishTexture(handle, name);
+
+	/* layers are traced back to back, missing ones as zeroes, the hitch */
+	/* recorder alone only needs the call and never gets the copy, nor */
+	/* does an array too large for a trace record */
+	if (TRACING())
+	{
+		size_t layerSize = (size_t)w * h * 4;
+		int fits = layerSize * layers <= 0x7FFFFFFF;
+		unsigned char* all = _traceFile && fits ?
+			calloc(layers, layerSize) : NULL;
+		for (int i = 0; all != NULL && data != NULL && i < layers; i++)
+			if (data[i] != NULL)
+				memcpy(all + i * layerSize, data[i], layerSize);
+		traceCall(VG_TRACE_CREATE_TEXTURE_ARRAY, all,
+			all ? (int)(layers * layerSize) : 0, "iiiiii", w, h, layers,
+			linear, repeat, handle);
+		free(all);
+	}
+
+	return handle;
+}
+
+VAPI void vgEditTextureLayer(vgTexture tex, int layer, void* data)
+{
+	VALIDATE(liveTexture(tex), VG_VALIDATE_HANDLE, "texture %d is not live",
+		tex);
+	VALIDATE(layer >= 0 && layer < _texLayers[tex], VG_VALIDATE_BOUNDS,
+		"layer %d of texture %d with %d layers", layer, tex, _texLayers[tex]);
+
+	/* tex indexes the tables, so it is checked before anything reads */
+	/* them, validation or not */
+	if (tex >= VG_TEXTURES_MAX || _texBuffer[tex] == 0 || layer < 0 ||
+		layer >= _texLayers[tex]) return;
+
+	TRACE_DATA(VG_TRACE_EDIT_TEXTURE_LAYER, data,
+		data ? _texWidth[tex] * _texHeight[tex] * 4 : 0, "ii", tex, layer);
+
+	texBind(GL_TEXTURE_3D, _texBuffer[tex]);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexSubImage3D(GL_TEXTURE_3D, 0, 0, 0, layer, _texWidth[tex],
+		_texHeight[tex], 1, GL_RGBA, GL_UNSIGNED_BYTE, data);
+}
+
+VAPI void vgUseTextureLayer(int layer)
+{
+	TRACE(VG_TRACE_USE_TEXTURE_LAYER, "i", layer);
+
+	_useLayer = layer;
+}
+
+VAPI void vgRectTextureLayer(int x, int y, int w, int h, int layer)
+{
+	TRACE(VG_TRACE_RECT_TEXTURE_LAYER, "iiiii", x, y, w, h, layer);
+
+	VALIDATE(liveTexture(_useTex), VG_VALIDATE_STATE,
+		"texture %d in use is not live", _useTex);
+	VALIDATE(!_texLayers[_useTex] ||
+		(layer >= 0 && layer < _texLayers[_useTex]), VG_VALIDATE_BOUNDS,
+		"layer %d of texture %d with %d layers", layer, _useTex,
+		_texLayers[_useTex]);
+
+	RENDERSKIP(_useRenderSkip); psetup();
+
+	GLenum target = texEnable(_useTex);
+	glColor4ub(_tcolR, _tcolG, _tcolB, _tcolA);
+	float r = layerCoord(_useTex, layer);
+
+	glBegin(GL_QUADS);
+	glTexCoord3f(0, 0, r); glVertex2i(x, y);
+	glTexCoord3f(0, 1, r); glVertex2i(x, y + h);
+	glTexCoord3f(1, 1, r); glVertex2i(x + w, y + h);
+	glTexCoord3f(1, 0, r); glVertex2i(x + w, y);
+	glEnd();
+
+	glDisable(target);
+}
+
+VAPI vgShape vgCompileShape(float* f2d_data, int size)
+{
+	vgShape handle = findFreeShape();
+	if (handle == VG_INVALID) return VG_INVALID;
+
+	_shapeBuffer[handle] =  glGenLists(1);
+
+	glNewList(_shapeBuffer[handle], GL_COMPILE);
+	glBegin(GL_POLYGON);
+	for (int i = 0; i < size * 2; i += 2)
+	{
+		glVertex2f(f2d_data[i], f2d_data[i + 1]);
+	}
+	glEnd();
+	glEndList();
+
+	/* display lists can't be read back, keep the vertices for traces */
+	_shapeData[handle] = malloc(size * 2 * sizeof(float));
+	if (_shapeData[handle] != NULL)
+		memcpy(_shapeData[handle], f2d_data, size * 2 * sizeof(float));
+	_shapeSize[handle] = size;
+	_shapeTextured[handle] = FALSE;
+
+	TRACE_DATA(VG_TRACE_COMPILE_SHAPE, f2d_data, size * 2 * sizeof(float),
+		"ii", size, handle);
+	return handle;
+}
+
+VAPI vgShape vgCompileShapeTextured(float* f2d_data, float* t2d_data,
+	int size)
+{
+	vgShape handle = findFreeShape();
+	if (handle == VG_INVALID) return VG_INVALID;
+
+	_shapeBuffer[handle] = glGenLists(1);
+
+	glNewList(_shapeBuffer[handle], GL_COMPILE);
+	glBegin(GL_POLYGON);
+	for (int i = 0; i < size * 2; i += 2)
+	{
+		glTexCoord2f(t2d_data[i], t2d_data[i + 1]);
+		glVertex2f(f2d_data[i], f2d_data[i + 1]);
+	}
+	glEnd();
+	glEndList();
+
+	/* positions, then texture coordinates, kept for traces */
+	int half = size * 2 * sizeof(float);
+	unsigned char* both = malloc(half * 2);
+	if (both != NULL) memcpy(both, f2d_data, half);
+	if (both != NULL) memcpy(both + half, t2d_data, half);
+	_shapeData[handle] = (float*)both;
+	_shapeSize[handle] = size;
+	_shapeTextured[handle] = TRUE;
+
+	TRACE_DATA(VG_TRACE_COMPILE_SHAPE_TEXTURED, both, both ? half * 2 : 0,
+		"ii", size, handle);
+	return handle;
+}
+
+VAPI void vgDestroyShape(vgShape shape)
+{
+	TRACE(VG_TRACE_DESTROY_SHAPE, "i", shape);
+
+	VALIDATE(liveShape(shape), VG_VALIDATE_HANDLE, "shape %d is not live",
+		shape);
+
+	if (shape >= VG_SHAPES_MAX || _shapeBuffer[shape] == 0) return;
+
+	glDeleteLists(_shapeBuffer[shape], 1);
+	_shapeBuffer[shape] = 0;
+	free(_shapeData[shape]);
+	_shapeData[shape] = NULL;
+}
+
+VAPI void vgDrawShape(vgShape shape, float x, float y, float r, float s)
+{
+	TRACE(VG_TRACE_DRAW_SHAPE, "iffff", shape, x, y, r, s);
+
+	VALIDATE(liveShape(shape), VG_VALIDATE_HANDLE, "shape %d is not live",
+		shape);
+
+	RENDERSKIP(_useRenderSkip); psetup();
+	PROFILE_BEGIN("vgDrawShape");
+
+	glTranslatef(x, y, 0); /* lastly, transalate */
+	glRotatef(r, 0, 0, 1); /* second, rotate */
+	glScalef(s, s, 1); /* first, scale */
+
+	glCallList(_shapeBuffer[shape]);
+	PROFILE_END();
+}
+
+VAPI void vgDrawShapeTextured(vgShape shape, float x, float y, float r,
+	float s)
+{
+	TRACE(VG_TRACE_DRAW_SHAPE_TEXTURED, "iffff", shape, x, y, r, s);
+
+	VALIDATE(liveShape(shape), VG_VALIDATE_HANDLE, "shape %d is not live",
+		shape);
+	VALIDATE(liveTexture(_useTex), VG_VALIDATE_STATE,
+		"texture %d in use is not live", _useTex);
+
+	RENDERSKIP(_useRenderSkip); psetup();
+	PROFILE_BEGIN("vgDrawShapeTextured");
+
+	glTranslatef(x, y, 0); /* lastly, transalate */
+	glRotatef(r, 0, 0, 1); /* second, rotate */
+	glScalef(s, s, 1); /* first, scale */
+
+	GLenum target = texEnable(_useTex);
+	glColor4ub(_tcolR, _tcolG, _tcolB, _tcolA);
+
+	/* shapes only carry s and t, move r onto the selected layer */
+	if (_texLayers[_useTex])
+	{
+		glMatrixMode(GL_TEXTURE);
+		glPushMatrix();
+		glTranslatef(0, 0, layerCoord(_useTex, _useLayer));
+		glCallList(_shapeBuffer[shape]);
+		glPopMatrix();
+		glMatrixMode(GL_MODELVIEW);
+	}
+	else
+		glCallList(_shapeBuffer[shape]);
+
+	glDisable(target);
+	PROFILE_END();
+}
+
+VAPI void vgRenderScale(float scale)
+{
+	TRACE(VG_TRACE_RENDER_SCALE, "f", scale);
+
+	_rScale = scale;
+}
+
+VAPI void vgUseRenderScaling(int value) 
+{
+	TRACE(VG_TRACE_USE_RENDER_SCALING, "i", value);
+
+	_useRScale = value;
+}
+
+VAPI void vgRenderOffset(float x, float y)
+{
+	TRACE(VG_TRACE_RENDER_OFFSET, "ff", x, y);
+
+	_rOffsetX = x;
+	_rOffsetY = y;
+}
+
+VAPI void vgUseRenderOffset(int value)
+{
+	TRACE(VG_TRACE_USE_RENDER_OFFSET, "i", value);
+
+	_useROffset = value;
+}
+
+VAPI void vgRenderLayer(float layer)
+{
+	TRACE(VG_TRACE_RENDER_LAYER, "f", layer);
+
+	_layer = min(0, -layer);
+}
+
+VAPI int vgCheckIfViewable(float x, float y, float extra)
+{
+	/* undo scale and transform */
+	if (_useROffset)
+	{
+		x -= _rOffsetX;
+		y -= _rOffsetY;
+	}
+	if (_useRScale)
+	{
+		x /= _rScale;
+		y /= _rScale;
+	}
+
+	/* object is now in "normalized screenspace" */
+	/* compare if object is seeable */
+	if (fabsf(x) > (1.0f + extra) || fabsf(y) > (1.0f + extra))
+	{
+		_hudCulled++;
+		return 0;
+	}
+
+	return 1;
+}
+
+/* ITEX FUNCTIONS */
+
+VAPI void vgITexDataClear(void)
+{
+	for (int i = 0; i < VG_ITEX_COLORS_MAX; i++)
+	{
+		_icolorR[i] = NULL;
+		_icolorG[i] = NULL;
+		_icolorB[i] = NULL;
+		_icolorA[i] = NULL;
+	}
+
+	for (int i = 0; i < VG_ITEX_SIZE_MAX; i++)
+	{
+		for (int j = 0; j < VG_ITEX_SIZE_MAX; j++)
+		{
+			_indexes[i][j] = NULL;
+		}
+	}
+}
+
+VAPI void vgITexDataColor(unsigned short index, int r, int g, int b, int a)
+{
+	VALIDATE(index < VG_ITEX_COLORS_MAX, VG_VALIDATE_BOUNDS, "color %d", index);
+
+	_icolorR[index] = r;
+	_icolorG[index] = g;
+	_icolorB[index] = b;
+	_icolorA[index] = a;
+}
+
+VAPI void vgITexDataIndex(unsigned short index, int x, int y)
+{
+	VALIDATE(itexInBounds(index, &x, &y, 1), VG_VALIDATE_BOUNDS,
+		"color %d at %d, %d", index, x, y);
+
+	_indexes[x][y] = index;
+}
+
+VAPI void vgITexDataIndexArray(unsigned short index, int* vx, int* vy,
+	int size)
+{
+	VALIDATE(itexInBounds(index, vx, vy, size), VG_VALIDATE_BOUNDS,
+		"color %d or a position out of range", index);
+
+	for (int i = 0; i < size; i++)
+	{
+		_indexes[vx[i]][vy[i]] = index;
+	}
+}
+
+VAPI vgTexture vgITexDataCompile(int width, int height, int repeat,
+	int linear)
+{
+	VALIDATE_OR(VG_INVALID, width > 0 && width <= VG_ITEX_SIZE_MAX &&
+		height > 0 && height <= VG_ITEX_SIZE_MAX, VG_VALIDATE_BOUNDS,
+		"size %d x %d", width, height);
+
+	/* create 2D compacted array buffer for color data to be stored */
+	unsigned char* colorBuffer;
+	colorBuffer = malloc(sizeof(unsigned char) * width * height * 4);
+	if (colorBuffer == NULL) return VG_INVALID;
+
+	int writeIndex = 0;
+
+	for (int i = 0; i < width; i++)
+	{
+		for (int j = 0; j < height; j++)
+		{
+			int colorIndex = _indexes[i][j];
+			colorBuffer[writeIndex + 0] = (unsigned char)_icolorR[colorIndex];
+			colorBuffer[writeIndex + 1] = (unsigned char)_icolorG[colorIndex];
+			colorBuffer[writeIndex + 2] = (unsigned char)_icolorB[colorIndex];
+			colorBuffer[writeIndex + 3] = (unsigned char)_icolorA[colorIndex];
+			writeIndex += 4;
+		}
+	}
+
+	vgTexture handle = vgCreateTexture(width, height, linear, repeat,
+		colorBuffer);
+
+	free(colorBuffer);
+
+	return handle;
+}
+
+/* TEXTURE EDITING FUNCTIONS */
+
+VAPI void vgEditTexture(vgTexture target, int w, int h)
+{
+	TRACE(VG_TRACE_EDIT_TEXTURE, "iii", target, w, h);
+
+	VALIDATE(liveTexture(target), VG_VALIDATE_HANDLE, "texture %d is not live",
+		target);
+	VALIDATE(!_texPending[target] && !_texLayers[target], VG_VALIDATE_STATE,
+		"texture %d is uploading or an array", target);
+
+	/* bind editing framebuffer to target texture */
+	glBindFramebuffer(GL_FRAMEBUFFER, _eFrameBuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+		_texBuffer[target], NULL);
+	glDrawBuffer(GL_COLOR_ATTACHMENT0);
+
+	/* setup other data */
+	_eWidth = w;
+	_eHeight = h;
+}
+
+VAPI void vgEditColor(int r, int g, int b, int a)
+{
+	TRACE(VG_TRACE_EDIT_COLOR, "iiii", r, g, b, a);
+
+	_ecolR = r;
+	_ecolG = g;
+	_ecolB = b;
+	_ecolA = a;
+}
+
+VAPI void vgEditPoint(int x, int y)
+{
+	TRACE(VG_TRACE_EDIT_POINT, "ii", x, y);
+
+	esetup();
+
+	glPointSize(1);
+
+	glBegin(GL_POINTS);
+	glVertex2i(x, y);
+	glEnd();
+}
+
+VAPI void vgEditLine(int x1, int y1, int x2, int y2)
+{
+	TRACE(VG_TRACE_EDIT_LINE, "iiii", x1, y1, x2, y2);
+
+	esetup();
+
+	glLineWidth(1);
+
+	glBegin(GL_LINES);
+	glVertex2i(x1, y1);
+	glVertex2i(x2, y2);
+	glEnd();
+}
+
+VAPI void vgEditRect(int x, int y, int w, int h)
+{
+	TRACE(VG_TRACE_EDIT_RECT, "iiii", x, y, w, h);
+
+	esetup();
+
+	glBegin(GL_QUADS);
+	glVertex2i(x, y);
+	glVertex2i(x, y + h);
+	glVertex2i(x + w, y + h);
+	glVertex2i(x + w, y);
+	glEnd();
+}
+
+VAPI void vgEditShape(vgShape shape, float x, float y, float r, float s)
+{
+	TRACE(VG_TRACE_EDIT_SHAPE, "iffff", shape, x, y, r, s);
+
+	VALIDATE(liveShape(shape), VG_VALIDATE_HANDLE, "shape %d is not live",
+		shape);
+
+	esetup();
+
+	glTranslatef(x, y, 0); /* third, transalate */
+	glScalef(s, s, 1); /* second, scale */
+	glRotatef(r, 0, 0, 1); /* first, rotate */
+
+	glCallList(_shapeBuffer[shape]);
+}
+
+VAPI void vgEditUseTexture(vgTexture tex)
+{
+	TRACE(VG_TRACE_EDIT_USE_TEXTURE, "i", tex);
+
+	VALIDATE(liveTexture(tex), VG_VALIDATE_HANDLE, "texture %d is not live",
+		tex);
+
+	_euTex = tex;
+}
+
+VAPI void vgEditShapeTextured(vgShape shape, float x, float y, float r,
+	float s)
+{
+	TRACE(VG_TRACE_EDIT_SHAPE_TEXTURED, "iffff", shape, x, y, r, s);
+
+	VALIDATE(liveShape(shape), VG_VALIDATE_HANDLE, "shape %d is not live",
+		shape);
+	VALIDATE(liveTexture(_euTex), VG_VALIDATE_STATE,
+		"texture %d in use is not live", _euTex);
+
+	esetup();
+
+	glTranslatef(x, y, 0); /* third, transalate */
+	glScalef(s, s, 1); /* second, scale */
+	glRotatef(r, 0, 0, 1); /* first, rotate */
+
+	GLenum target = texEnable(_euTex);
+
+	glColor4ub(_tcolR, _tcolG, _tcolB, _tcolA);
+
+	if (_texLayers[_euTex])
+	{
+		glMatrixMode(GL_TEXTURE);
+		glPushMatrix();
+		glTranslatef(0, 0, layerCoord(_euTex, _useLayer));
+		glCallList(_shapeBuffer[shape]);
+		glPopMatrix();
+		glMatrixMode(GL_MODELVIEW);
+	}
+	else
+		glCallList(_shapeBuffer[shape]);
+
+	glDisable(target);
+}
+
+VAPI void vgEditSetData(int width, int height, void* data)
+{
+	TRACE_DATA(VG_TRACE_EDIT_SET_DATA, data, width * height * 4, "ii", width,
+		height);
+
+	esetup();
+
+	glDrawPixels(width, height, GL_RGBA, GL_UNSIGNED_BYTE, data);
+}
+
+VAPI void vgEditClear(void)
+{
+	TRACE(VG_TRACE_EDIT_CLEAR, "");
+
+	esetup();
+	
+	glClearColor(0, 0, 0, 0);
+	glClear(GL_COLOR_BUFFER_BIT);
+}
+
+static int texExtent(vgTexture tex, int* w, int* h)
+{
+	if (tex == VG_RENDER_TARGET)
+	{
+		*w = _resW;
+		*h = _resH;
+		return TRUE;
+	}
+
+	if (tex >= VG_TEXTURES_MAX || _texBuffer[tex] == 0) return FALSE;
+	*w = _texWidth[tex];
+	*h = _texHeight[tex];
+	return TRUE;
+}
+
+static int fboAttach(GLenum target, GLuint fbo, vgTexture tex,
+	GLuint* cache, int* cacheLayer, int* complete)
+{
+	glBindFramebuffer(target, fbo);
+
+	/* only reattach when the texture changes */
+	GLuint name = _texBuffer[tex];
+	int layer = _texLayers[tex] ? min(max(_useLayer, 0),
+		_texLayers[tex] - 1) : 0;
+	if (name == *cache && layer == *cacheLayer) return *complete;
+
+	if (_texLayers[tex])
+		glFramebufferTextureLayer(target, GL_COLOR_ATTACHMENT0, name, 0,
+			layer);
+	else
+		glFramebufferTexture2D(target, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+			name, 0);
+	if (target == GL_READ_FRAMEBUFFER) glReadBuffer(GL_COLOR_ATTACHMENT0);
+	else glDrawBuffer(GL_COLOR_ATTACHMENT0);
+
+	/* alpha-only and compressed storage can't be colour attachments */
+	*cache = name;
+	*cacheLayer = layer;
+	*complete = glCheckFramebufferStatus(target) == GL_FRAMEBUFFER_COMPLETE;
+	return *complete;
+}
+
+static int bindSource(vgTexture tex)
+{
+	/* the scene texture is always attached to its framebuffer */
+	if (tex == VG_RENDER_TARGET)
+	{
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, _framebuffer);
+		return TRUE;
+	}
+
+	return fboAttach(GL_READ_FRAMEBUFFER, _rFrameBuffer, tex,
+		&_readAttached, &_readLayer, &_readComplete);
+}
+
+static int bindDest(vgTexture tex)
+{
+	if (tex == VG_RENDER_TARGET)
+	{
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, _framebuffer);
+		return TRUE;
+	}
+
+	return fboAttach(GL_DRAW_FRAMEBUFFER, _bFrameBuffer, tex,
+		&_blitAttached, &_blitLayer, &_blitComplete);
+}
+
+static int blitTexels(vgTexture src, int sx, int sy, int sw, int sh,
+	vgTexture dst, int dx, int dy, int dw, int dh, int linear)
+{
+	if (!bindSource(src) || !bindDest(dst)) return VG_FALSE;
+
+	/* the blit clips to both attachments, scaling as needed */
+	PROFILE_BEGIN("vgBlitTexture");
+	glBlitFramebuffer(sx, sy, sx + sw, sy + sh, dx, dy, dx + dw, dy + dh,
+		GL_COLOR_BUFFER_BIT, linear == VG_LINEAR ? GL_LINEAR : GL_NEAREST);
+
+	/* mip chains follow the new top level */
+	_traceMute++;
+	if (dst != VG_RENDER_TARGET && _texLevels[dst] > 1)
+		vgRegenerateMipmaps(dst);
+	_traceMute--;
+	PROFILE_END();
+
+	return VG_TRUE;
+}
+
+static inline int blockAligned(int x, int w, int size)
+{
+	/* BC regions are whole blocks, only the texture's edge may cut one */
+	return x % 4 == 0 && (w % 4 == 0 || x + w == size);
+}
+
+VAPI void* vgGetTextureData(vgTexture tex, int w, int h)
+{
+	VALIDATE_OR(NULL, tex == VG_RENDER_TARGET || liveTexture(tex),
+		VG_VALIDATE_HANDLE, "texture %d is not live", tex);
+
+	void* data = calloc(1, sizeof(unsigned char) * w * h * 4);
+	if (data == NULL) return NULL;
+
+	vgReadPixels(tex, 0, 0, w, h, VG_FORMAT_RGBA8, data, 0);
+
+	return data;
+}
+
+VAPI int vgReadPixels(vgTexture tex, int x, int y, int w, int h, int format,
+	void* dst, int stride)
+{
+	TRACE(VG_TRACE_READ_PIXELS, "iiiiiii", tex, x, y, w, h, format, stride);
+
+	VALIDATE_OR(VG_FALSE, tex == VG_RENDER_TARGET || liveTexture(tex),
+		VG_VALIDATE_HANDLE, "texture %d is not live", tex);
+
+	if (format < 0 || format >= FORMAT_COUNT || fmtCompressed(format))
+		return VG_FALSE;
+
+	int tw, th;
+	if (!texExtent(tex, &tw, &th) || x < 0 || y < 0 || x + w > tw ||
+		y + h > th)
+		return VG_FALSE;
+	if (tex != VG_RENDER_TARGET && fmtCompressed(_texFormat[tex]))
+		return VG_FALSE;
+	if (!bindSource(tex)) return VG_FALSE;
+
+	/* rows land stride bytes apart, tightly packed if 0 */
+	PROFILE_BEGIN("vgReadPixels");
+	int bpp = _fmtBytes[format];
+	if (stride <= 0) stride = w * bpp;
+
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	if (stride % bpp == 0)
+	{
+		glPixelStorei(GL_PACK_ROW_LENGTH, stride / bpp);
+		glReadPixels(x, y, w, h, _fmtUpload[format], _fmtType[format], dst);
+		glPixelStorei(GL_PACK_ROW_LENGTH, 0);
+	}
+	else
+	{
+		unsigned char* row = dst;
+		for (int i = 0; i < h; i++, row += stride)
+			glReadPixels(x, y + i, w, 1, _fmtUpload[format], _fmtType[format],
+				row);
+	}
+	PROFILE_END();
+
+	return VG_TRUE;
+}
+
+VAPI int vgCopyTexture(vgTexture src, int sx, int sy, int w, int h,
+	vgTexture dst, int dx, int dy)
+{
+	TRACE(VG_TRACE_COPY_TEXTURE, "iiiiiiii", src, sx, sy, w, h, dst, dx, dy);
+
+	VALIDATE_OR(VG_FALSE, src == VG_RENDER_TARGET || liveTexture(src),
+		VG_VALIDATE_HANDLE, "texture %d is not live", src);
+	VALIDATE_OR(VG_FALSE, dst == VG_RENDER_TARGET || liveTexture(dst),
+		VG_VALIDATE_HANDLE, "texture %d is not live", dst);
+
+	int sw, sh, dw, dh;
+	if (!texExtent(src, &sw, &sh) || !texExtent(dst, &dw, &dh) ||
+		sx < 0 || sy < 0 || sx + w > sw || sy + h > sh ||
+		dx < 0 || dy < 0 || dx + w > dw || dy + h > dh)
+		return VG_FALSE;
+
+	/* copying onto itself is only defined without overlap */
+	if (src == dst && sx < dx + w && dx < sx + w && sy < dy + h &&
+		dy < sy + h)
+		return VG_FALSE;
+
+	int srcFormat = src == VG_RENDER_TARGET ? _renderFormat : _texFormat[src];
+	int dstFormat = dst == VG_RENDER_TARGET ? _renderFormat : _texFormat[dst];
+	if (fmtCompressed(srcFormat) && (!blockAligned(sx, w, sw) ||
+		!blockAligned(sy, h, sh) || !blockAligned(dx, w, dw) ||
+		!blockAligned(dy, h, dh)))
+		return VG_FALSE;
+
+	/* same storage, copy texels directly without any framebuffer */
+	if (GLEW_ARB_copy_image && srcFormat == dstFormat)
+	{
+		GLuint srcName = src == VG_RENDER_TARGET ? _texture : _texBuffer[src];
+		GLuint dstName = dst == VG_RENDER_TARGET ? _texture : _texBuffer[dst];
+		int srcLayers = src == VG_RENDER_TARGET ? 0 : _texLayers[src];
+		int dstLayers = dst == VG_RENDER_TARGET ? 0 : _texLayers[dst];
+		glCopyImageSubData(srcName, srcLayers ? GL_TEXTURE_3D : GL_TEXTURE_2D,
+			0, sx, sy, srcLayers ? min(max(_useLayer, 0), srcLayers - 1) : 0,
+			dstName, dstLayers ? GL_TEXTURE_3D : GL_TEXTURE_2D, 0, dx, dy,
+			dstLayers ? min(max(_useLayer, 0), dstLayers - 1) : 0, w, h, 1);
+
+		/* only level 0 was copied, like vgBlitTexture rebuild the rest */
+		_traceMute++;
+		if (dst != VG_RENDER_TARGET && _texLevels[dst] > 1)
+			vgRegenerateMipmaps(dst);
+		_traceMute--;
+		return VG_TRUE;
+	}
+
+	/* otherwise blit, which is defined for a texture onto itself as */
+	/* long as the regions don't overlap, vgBlitTexture just can't tell */
+	if (fmtCompressed(srcFormat) || fmtCompressed(dstFormat))
+		return VG_FALSE;
+	return blitTexels(src, sx, sy, w, h, dst, dx, dy, w, h, VG_NEAREST);
+}
+
+VAPI int vgBlitTexture(vgTexture src, int sx, int sy, int sw, int sh,
+	vgTexture dst, int dx, int dy, int dw, int dh, int linear)
+{
+	TRACE(VG_TRACE_BLIT_TEXTURE, "iiiiiiiiiii", src, sx, sy, sw, sh, dst, dx,
+		dy, dw, dh, linear);
+
+	VALIDATE_OR(VG_FALSE, src == VG_RENDER_TARGET || liveTexture(src),
+		VG_VALIDATE_HANDLE, "texture %d is not live", src);
+	VALIDATE_OR(VG_FALSE, dst == VG_RENDER_TARGET || liveTexture(dst),
+		VG_VALIDATE_HANDLE, "texture %d is not live", dst);
+
+	int srcW, srcH, dstW, dstH;
+	if (src == dst || !texExtent(src, &srcW, &srcH) ||
+		!texExtent(dst, &dstW, &dstH))
+		return VG_FALSE;
+
+	/* compressed formats can't be blitted */
+	if ((src != VG_RENDER_TARGET && fmtCompressed(_texFormat[src])) ||
+		(dst != VG_RENDER_TARGET && fmtCompressed(_texFormat[dst])))
+		return VG_FALSE;
+
+	return blitTexels(src, sx, sy, sw, sh, dst, dx, dy, dw, dh, linear);
+}
+
+VAPI vgTexture vgDuplicateTexture(vgTexture tex)
+{
+	VALIDATE_OR(VG_INVALID, liveTexture(tex), VG_VALIDATE_HANDLE,
+		"texture %d is not live", tex);
+
+	if (tex >= VG_TEXTURES_MAX || _texBuffer[tex] == 0 || _texLayers[tex])
+		return VG_INVALID;
+
+	int w = _texWidth[tex], h = _texHeight[tex];
+	int levels = _texLevels[tex];
+	_traceMute++;
+	vgTexture copy = vgCreateTextureFormat(w, h, levels > 1 ?
+		VG_LINEAR_MIPMAP : VG_NEAREST, VG_FALSE, _texFormat[tex], NULL);
+	_traceMute--;
+	if (copy == VG_INVALID) return VG_INVALID;
+	TRACE(VG_TRACE_DUPLICATE_TEXTURE, "ii", tex, copy);
+
+	/* same sampling and LOD bias as the original */
+	static const GLenum params[4] = { GL_TEXTURE_MIN_FILTER,
+		GL_TEXTURE_MAG_FILTER, GL_TEXTURE_WRAP_S, GL_TEXTURE_WRAP_T };
+	GLint values[4];
+	GLfloat bias;
+	texBind(GL_TEXTURE_2D, _texBuffer[tex]);
+	for (int i = 0; i < 4; i++)
+		glGetTexParameteriv(GL_TEXTURE_2D, params[i], &values[i]);
+	glGetTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_LOD_BIAS, &bias);
+	texBind(GL_TEXTURE_2D, _texBuffer[copy]);
+	for (int i = 0; i < 4; i++)
+		glTexParameteri(GL_TEXTURE_2D, params[i], values[i]);
+	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_LOD_BIAS, bias);
+
+	/* every level as is, or the top level and a rebuilt chain */
+	_traceMute++;
+	if (GLEW_ARB_copy_image)
+	{
+		for (int i = 0; i < levels; i++)
+			glCopyImageSubData(_texBuffer[tex], GL_TEXTURE_2D, i, 0, 0, 0,
+				_texBuffer[copy], GL_TEXTURE_2D, i, 0, 0, 0,
+				max(1, w >> i), max(1, h >> i), 1);
+
+		/* a short chain from an archive leaves the rest to rebuild */
+		if (_texLevels[copy] > levels && !fmtCompressed(_texFormat[tex]))
+			vgRegenerateMipmaps(copy);
+	}
+	else vgBlitTexture(tex, 0, 0, w, h, copy, 0, 0, w, h, VG_NEAREST);
+	_traceMute--;
+
+	return copy;
+}
+
+/* TEXTURE COMPRESSION FUNCTIONS */
+
+VAPI int vgCompressionSupported(void)
+{
+	return GLEW_EXT_texture_compression_s3tc ? VG_TRUE : VG_FALSE;
+}
+
+VAPI vgTexture vgCreateTextureCompressed(int w, int h, int linear,
+	int repeat, int format, void* blocks)
+{
+	int sized = w > 0 && h > 0 && w <= TEXTURE_SIZE_MAX &&
+		h <= TEXTURE_SIZE_MAX;
+	VALIDATE_OR(VG_INVALID, fmtCompressed(format) && sized,
+		VG_VALIDATE_BOUNDS, "format %d at %d x %d", format, w, h);
+	if (!fmtCompressed(format) || !sized) return VG_INVALID;
+
+	/* without S3TC the texture falls back to RGBA8 */
+	if (!GLEW_EXT_texture_compression_s3tc)
+	{
+		unsigned char* rgba = malloc((size_t)w * h * 4);
+		if (rgba == NULL) return VG_INVALID;
+
+		vgDecompressTextureData(w, h, format, blocks, rgba);
+		_traceMute++;
+		vgTexture handle = vgCreateTextureFormat(w, h, linear, repeat,
+			format, rgba);
+		_traceMute--;
+		TRACE_DATA(VG_TRACE_CREATE_TEXTURE_COMPRESSED, blocks,
+			vgFormatSize(format, w, h), "iiiiii", w, h, linear, repeat, format,
+			handle);
+
+		free(rgba);
+		return handle;
+	}
+
+	/* upload blocks as they are, only the generated levels get encoded */
+	int mipmap = (linear == VG_LINEAR_MIPMAP || linear == VG_NEAREST_MIPMAP);
+	vgTexture handle = reserveTexture(w, h, mipmap ? mipLevels(w, h) : 1,
+		format);
+	if (handle == VG_INVALID) return VG_INVALID;
+	TRACE_DATA(VG_TRACE_CREATE_TEXTURE_COMPRESSED, blocks,
+		vgFormatSize(format, w, h), "iiiiii", w, h, linear, repeat, format,
+		handle);
+
+	textureUpload(handle, linear, repeat, 1, blocks);
+	return handle;
+}
+
+VAPI void vgDecompressTextureData(int w, int h, int format, const void* src,
+	void* dst)
+{
+	const unsigned char* in = src;
+	unsigned char* out = dst;
+	int blockBytes = _fmtBytes[format];
+	unsigned char px[64];
+
+	if (!fmtCompressed(format)) return;
+
+	for (int by = 0; by < (h + 3) / 4; by++)
+	{
+		for (int bx = 0; bx < (w + 3) / 4; bx++)
+		{
+			if (format == VG_FORMAT_BC3)
+			{
+				decodeColorBlock(in + 8, TRUE, px);
+				decodeAlphaBlock(in, px);
+			}
+			else
+				decodeColorBlock(in, FALSE, px);
+			in += blockBytes;
+
+			/* write the part of the block that lies inside the image */
+			for (int y = 0; y < 4 && by * 4 + y < h; y++)
+			{
+				int cols = min(4, w - bx * 4);
+				memcpy(out + ((by * 4 + y) * w + bx * 4) * 4, px + y * 16,
+					cols * 4);
+			}
+		}
+	}
+}
+
+/* LARGE IMAGE FUNCTIONS */
+
+static void lgSampleTile(vgLargeImage img, int level, int tx, int ty,
+	int* vw, int* vh)
+{
+	int w = _lgW[img], h = _lgH[img];
+	int lw = (w + (1 << level) - 1) >> level;
+	int lh = (h + (1 << level) - 1) >> level;
+	*vw = min(VG_LARGE_TILE_SIZE, lw - tx * VG_LARGE_TILE_SIZE);
+	*vh = min(VG_LARGE_TILE_SIZE, lh - ty * VG_LARGE_TILE_SIZE);
+
+	/* full resolution rows come from the source, coarser ones from the */
+	/* pyramid, rows are contiguous in both */
+	const unsigned char* base = _lgData[img];
+	if (level > 0)
+		base = _lgPyr[img] ? _lgPyr[img] + _lgLevel[img][level] : NULL;
+
+	for (int j = 0; j < *vh; j++)
+	{
+		unsigned char* out = _lgScratch + (size_t)j * *vw * 4;
+
+		if (base != NULL)
+		{
+			size_t row = (size_t)ty * VG_LARGE_TILE_SIZE + j;
+			size_t col = (size_t)tx * VG_LARGE_TILE_SIZE;
+			memcpy(out, base + (row * lw + col) * 4, *vw * 4);
+			continue;
+		}
+
+		/* no pyramid, point sample the center of each footprint */
+		size_t sy = min(((ty * VG_LARGE_TILE_SIZE + j) << level) +
+			((1 << level) >> 1), h - 1);
+		const unsigned char* row = _lgData[img] + sy * w * 4;
+		for (int i = 0; i < *vw; i++)
+		{
+			size_t sx = min(((tx * VG_LARGE_TILE_SIZE + i) << level) +
+				((1 << level) >> 1), w - 1);
+			memcpy(out + i * 4, row + sx * 4, 4);
+		}
+	}
+}
+
+static void lgDownsampleRows(const unsigned char* src, int w, int rows,
+	unsigned char* dst)
+{
+	/* one row out of up to two, levels round up so odd widths keep */
+	/* their last column */
+	vgBuildMipmapData(w, rows, src, dst);
+	if (w == 1 || (w & 1) == 0) return;
+
+	const unsigned char* r0 = src + (size_t)(w - 1) * 4;
+	const unsigned char* r1 = rows > 1 ? r0 + (size_t)w * 4 : r0;
+	unsigned char* out = dst + (size_t)(w >> 1) * 4;
+	for (int c = 0; c < 4; c++)
+		out[c] = (unsigned char)((r0[c] + r1[c] + 1) >> 1);
+}
+
+static int lgMapPyramid(vgLargeImage img, const char* path,
+	unsigned long long size)
+{
+	/* a sidecar from an earlier run is kept while the source is unchanged */
+	HANDLE hFile = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (hFile == INVALID_HANDLE_VALUE) return FALSE;
+
+	LARGE_INTEGER have;
+	if (GetFileSizeEx(hFile, &have) &&
+		(unsigned long long)have.QuadPart == size)
+	{
+		HANDLE hMap = CreateFileMappingA(hFile, NULL, PAGE_READONLY, 0, 0,
+			NULL);
+		const unsigned char* view = hMap ?
+			MapViewOfFile(hMap, FILE_MAP_READ, 0, 0, 0) : NULL;
+		if (view != NULL &&
+			memcmp(view, &_lgPyrWant[img], sizeof(vgPyramidHeader)) == 0)
+		{
+			_lgPyrFile[img] = hFile;
+			_lgPyrMapping[img] = hMap;
+			_lgPyr[img] = view;
+			return TRUE;
+		}
+		if (view) UnmapViewOfFile(view);
+		if (hMap) CloseHandle(hMap);
+	}
+	CloseHandle(hFile);
+	return FALSE;
+}
+
+static int lgCreatePyramid(vgLargeImage img, const char* path,
+	unsigned long long size)
+{
+	HANDLE hFile = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, 0, NULL,
+		CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (hFile == INVALID_HANDLE_VALUE) return FALSE;
+	HANDLE hMap = CreateFileMappingA(hFile, NULL, PAGE_READWRITE,
+		(DWORD)(size >> 32), (DWORD)size, NULL);
+	unsigned char* view = hMap ? MapViewOfFile(hMap, FILE_MAP_WRITE, 0, 0, 0) :
+		NULL;
+	if (view == NULL)
+	{
+		if (hMap) CloseHandle(hMap);
+		CloseHandle(hFile);
+		DeleteFileA(path);
+		return FALSE;
+	}
+
+	strcpy(_lgPyrPath[img], path);
+	_lgPyrFile[img] = hFile;
+	_lgPyrMapping[img] = hMap;
+	_lgPyrBuilt[img] = view;
+	return TRUE;
+}
+
+static DWORD WINAPI lgPyramidWorker(LPVOID param)
+{
+	vgLargeImage img = (vgLargeImage)(INT_PTR)param;
+	unsigned char* view = _lgPyrBuilt[img];
+
+	PROFILE_BEGIN("large image pyramid");
+	const unsigned char* src = _lgData[img];
+	int sw = _lgW[img], sh = _lgH[img];
+	for (int k = 1; k <= _lgTopLevel[img]; k++)
+	{
+		unsigned char* dst = view + _lgLevel[img][k];
+		int dw = (sw + 1) / 2, dh = (sh + 1) / 2;
+		for (int y = 0; y < dh; y++)
+		{
+			if (_lgPyrCancel[img]) break;
+			lgDownsampleRows(src + (size_t)y * 2 * sw * 4, sw,
+				min(2, sh - y * 2), dst + (size_t)y * dw * 4);
+		}
+		src = dst;
+		sw = dw;
+		sh = dh;
+	}
+	PROFILE_END();
+
+	/* header last, an interrupted build never looks finished */
+	if (_lgPyrCancel[img]) return 0;
+	memcpy(view, &_lgPyrWant[img], sizeof(vgPyramidHeader));
+	InterlockedExchange(&_lgPyrDone[img], TRUE);
+	return 0;
+}
+
+static void lgOpenPyramid(vgLargeImage img, const char* file,
+	const char* pyramid, int temp, unsigned long long sourceSize)
+{
+	int w = _lgW[img], h = _lgH[img], top = _lgTopLevel[img];
+	unsigned long long size = sizeof(vgPyramidHeader);
+	for (int k = 1; k <= top; k++)
+	{
+		_lgLevel[img][k] = size;
+		size += (unsigned long long)((w + (1 << k) - 1) >> k) *
+			((h + (1 << k) - 1) >> k) * 4;
+	}
+	if (top == 0 || pyramid == NULL || strlen(pyramid) >= MAX_PATH) return;
+
+	WIN32_FILE_ATTRIBUTE_DATA attr = { 0 };
+	GetFileAttributesExA(file, GetFileExInfoStandard, &attr);
+	vgPyramidHeader want = { { 'V', 'G', 'L', 'P' }, w, h, top, sourceSize,
+		(unsigned long long)attr.ftLastWriteTime.dwHighDateTime << 32 |
+		attr.ftLastWriteTime.dwLowDateTime };
+	_lgPyrWant[img] = want;
+
+	/* the default sidecar moves to the temp directory when the source */
+	/* sits somewhere that can't be written */
+	char tempPath[MAX_PATH] = { 0 };
+	if (temp)
+	{
+		const char* name = strrchr(file, '\\');
+		const char* fwd = strrchr(file, '/');
+		if (name == NULL || (fwd != NULL && fwd > name)) name = fwd;
+		name = name ? name + 1 : file;
+		DWORD len = GetTempPathA(MAX_PATH, tempPath);
+		if (len == 0 || len + strlen(name) + 5 > MAX_PATH) tempPath[0] = 0;
+		else sprintf(tempPath + len, "%s.pyr", name);
+	}
+
+	if (lgMapPyramid(img, pyramid, size)) return;
+	if (tempPath[0] && lgMapPyramid(img, tempPath, size)) return;
+
+	/* otherwise build it, without one coarse levels are point sampled */
+	if (!lgCreatePyramid(img, pyramid, size) &&
+		!(tempPath[0] && lgCreatePyramid(img, tempPath, size)))
+		return;
+
+	_lgPyrCancel[img] = FALSE;
+	_lgPyrDone[img] = FALSE;
+	_lgPyrThread[img] = CreateThread(NULL, 0, lgPyramidWorker,
+		(LPVOID)(INT_PTR)img, 0, NULL);
+	if (_lgPyrThread[img] != NULL) return;
+
+	UnmapViewOfFile(_lgPyrBuilt[img]);
+	CloseHandle(_lgPyrMapping[img]);
+	CloseHandle(_lgPyrFile[img]);
+	DeleteFileA(_lgPyrPath[img]);
+	_lgPyrBuilt[img] = NULL;
+}
+
+static void lgClosePyramid(vgLargeImage img)
+{
+	if (_lgPyrThread[img])
+	{
+		/* a build still running is stopped and its file thrown away */
+		InterlockedExchange(&_lgPyrCancel[img], TRUE);
+		WaitForSingleObject(_lgPyrThread[img], INFINITE);
+		CloseHandle(_lgPyrThread[img]);
+		_lgPyrThread[img] = NULL;
+		_lgPyr[img] = _lgPyrBuilt[img];
+		_lgPyrBuilt[img] = NULL;
+		if (!_lgPyrDone[img])
+		{
+			UnmapViewOfFile(_lgPyr[img]);
+			CloseHandle(_lgPyrMapping[img]);
+			CloseHandle(_lgPyrFile[img]);
+			DeleteFileA(_lgPyrPath[img]);
+			_lgPyr[img] = NULL;
+		}
+	}
+
+	if (_lgPyr[img])
+	{
+		UnmapViewOfFile(_lgPyr[img]);
+		CloseHandle(_lgPyrMapping[img]);
+		CloseHandle(_lgPyrFile[img]);
+	}
+	_lgPyr[img] = NULL;
+}
+
+static void lgPyramidLanded(vgLargeImage img)
+{
+	if (_lgPyrThread[img] == NULL || !_lgPyrDone[img]) return;
+
+	WaitForSingleObject(_lgPyrThread[img], INFINITE);
+	CloseHandle(_lgPyrThread[img]);
+	_lgPyrThread[img] = NULL;
+	_lgPyr[img] = _lgPyrBuilt[img];
+	_lgPyrBuilt[img] = NULL;
+
+	/* point sampled tiles above level 0 are refiltered as they page in */
+	for (int i = 0; i < LARGE_SLOTS; i++)
+		if (_lgSlotKey[img][i] && (_lgSlotKey[img][i] - 1) >> 48 != 0)
+			_lgSlotKey[img][i] = 0;
+
+	int vw, vh;
+	lgSampleTile(img, _lgTopLevel[img], 0, 0, &vw, &vh);
+	texBind(GL_TEXTURE_2D, _lgCoarse[img]);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, vw, vh, GL_RGBA,
+		GL_UNSIGNED_BYTE, _lgScratch);
+}
+
+static int lgRequest(vgLargeImage img, int level, int tx, int ty)
+{
+	unsigned long long key = ((unsigned long long)level << 48 |
+		(unsigned long long)ty << 24 | (unsigned long long)tx) + 1;
+
+	/* resident already, otherwise prefer an empty slot over the LRU one */
+	int victim = 0;
+	for (int i = 0; i < LARGE_SLOTS; i++)
+	{
+		if (_lgSlotKey[img][i] == key)
+		{
+			_lgSlotUsed[img][i] = _frames;
+			return i;
+		}
+		if (_lgSlotKey[img][victim] == 0) continue;
+		if (_lgSlotKey[img][i] == 0 ||
+			_lgSlotUsed[img][i] < _lgSlotUsed[img][victim])
+			victim = i;
+	}
+
+	/* upload budget is shared by all images for one frame */
+	if (_lgUploadFrame != _frames)
+	{
+		_lgUploadFrame = _frames;
+		_lgUploads = 0;
+	}
+	if (_lgUploads >= VG_LARGE_UPLOADS_MAX) return -1;
+
+	/* never evict what this frame is drawing */
+	if (_lgSlotKey[img][victim] && _lgSlotUsed[img][victim] == _frames)
+		return -1;
+
+	int vw, vh;
+	lgSampleTile(img, level, tx, ty, &vw, &vh);
+
+	texBind(GL_TEXTURE_2D, _lgCache[img]);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexSubImage2D(GL_TEXTURE_2D, 0,
+		(victim % LARGE_CACHE_TILES) * VG_LARGE_TILE_SIZE,
+		(victim / LARGE_CACHE_TILES) * VG_LARGE_TILE_SIZE,
+		vw, vh, GL_RGBA, GL_UNSIGNED_BYTE, _lgScratch);
+
+	_lgSlotKey[img][victim] = key;
+	_lgSlotUsed[img][victim] = _frames;
+	_lgUploads++;
+	return victim;
+}
+
+static vgLargeImage lgOpen(const char* file, int w, int h, int linear,
+	const char* pyramid, int temp)
+{
+	/* find free image */
+	vgLargeImage img = VG_INVALID;
+	for (int i = 0; i < VG_LARGE_IMAGES_MAX; i++)
+	{
+		if (_lgData[i] == NULL)
+		{
+			img = i;
+			break;
+		}
+	}
+	if (img == VG_INVALID) return VG_INVALID;
+
+	/* map the whole source, pages are only read when tiles need them */
+	HANDLE hFile = CreateFileA(file, GENERIC_READ, FILE_SHARE_READ, NULL,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (hFile == INVALID_HANDLE_VALUE) return VG_INVALID;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(hFile, &size) ||
+		(unsigned long long)size.QuadPart < (unsigned long long)w * h * 4)
+	{
+		CloseHandle(hFile);
+		return VG_INVALID;
+	}
+
+	HANDLE hMap = CreateFileMappingA(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+	const void* view = hMap ? MapViewOfFile(hMap, FILE_MAP_READ, 0, 0, 0) :
+		NULL;
+	if (view == NULL)
+	{
+		if (hMap) CloseHandle(hMap);
+		CloseHandle(hFile);
+		return VG_INVALID;
+	}
+
+	_lgFile[img] = hFile;
+	_lgMapping[img] = hMap;
+	_lgData[img] = view;
+	_lgW[img] = w;
+	_lgH[img] = h;
+
+	/* top level is the first one that fits in a single tile */
+	int top = 0;
+	while ((max(w, h) >> top) > VG_LARGE_TILE_SIZE) top++;
+	_lgTopLevel[img] = top;
+	lgOpenPyramid(img, file, pyramid, temp, size.QuadPart);
+
+	for (int i = 0; i < LARGE_SLOTS; i++)
+	{
+		_lgSlotKey[img][i] = 0;
+		_lgSlotUsed[img][i] = 0;
+	}
+
+	GLint filter = (linear == VG_LINEAR || linear == VG_LINEAR_MIPMAP) ?
+		GL_LINEAR : GL_NEAREST;
+
+	/* tile cache */
+	glGenTextures(1, &_lgCache[img]);
+	texBind(GL_TEXTURE_2D, _lgCache[img]);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, VG_LARGE_CACHE_SIZE,
+		VG_LARGE_CACHE_SIZE, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+
+	/* always resident coarse image, drawn under missing tiles */
+	int vw, vh;
+	lgSampleTile(img, top, 0, 0, &vw, &vh);
+	glGenTextures(1, &_lgCoarse[img]);
+	texBind(GL_TEXTURE_2D, _lgCoarse[img]);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, vw, vh, 0, GL_RGBA,
+		GL_UNSIGNED_BYTE, _lgScratch);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+
+	return img;
+}
+
+VAPI vgLargeImage vgOpenLargeImage(const char* file, int w, int h,
+	int linear)
+{
+	/* too long a name for the sidecar only costs the pyramid */
+	char path[MAX_PATH];
+	if (strlen(file) + 5 > MAX_PATH)
+		return lgOpen(file, w, h, linear, NULL, FALSE);
+	sprintf(path, "%s.pyr", file);
+	return lgOpen(file, w, h, linear, path, TRUE);
+}
+
+VAPI vgLargeImage vgOpenLargeImagePyramid(const char* file, int w, int h,
+	int linear, const char* pyramid)
+{
+	return lgOpen(file, w, h, linear, pyramid, FALSE);
+}
+
+VAPI void vgCloseLargeImage(vgLargeImage image)
+{
+	if (image >= VG_LARGE_IMAGES_MAX || _lgData[image] == NULL) return;
+
+	/* the pyramid worker reads the source, so it goes first */
+	lgClosePyramid(image);
+	texDelete(1, &_lgCache[image]);
+	texDelete(1, &_lgCoarse[image]);
+	UnmapViewOfFile(_lgData[image]);
+	CloseHandle(_lgMapping[image]);
+	CloseHandle(_lgFile[image]);
+
+	_lgData[image] = NULL;
+	_lgCache[image] = 0;
+	_lgCoarse[image] = 0;
+}
+
+VAPI void vgDrawLargeImage(vgLargeImage image, float x, float y, float w,
+	float h)
+{
+	RENDERSKIP(_useRenderSkip);
+	if (image >= VG_LARGE_IMAGES_MAX || _lgData[image] == NULL) return;
+	lgPyramidLanded(image);
+	psetup();
+
+	int iw = _lgW[image], ih = _lgH[image];
+
+	/* visible world rect, same projection as psetup */
+	float ratio = (float)_windowHeight / (float)_windowWidth;
+	float ex = _useRScale ? _rScale : 1.0f;
+	float ey = ex * ratio;
+	float cx = _useROffset ? _rOffsetX : 0.0f;
+	float cy = _useROffset ? _rOffsetY : 0.0f;
+
+	/* visible part of the image in source pixels */
+	float px0 = max(0.0f, (cx - ex - x) / w * iw);
+	float px1 = min((float)iw, (cx + ex - x) / w * iw);
+	float py0 = max(0.0f, (cy - ey - y) / h * ih);
+	float py1 = min((float)ih, (cy + ey - y) / h * ih);
+	if (px0 >= px1 || py0 >= py1)
+	{
+		_hudCulled++;
+		return;
+	}
+
+	/* pick the finest level with at most one texel per screen pixel, */
+	/* coarser still if the visible tiles would not fit in the cache, */
+	/* visible tiles are never evicted and the view would never finish */
+	float texelsPerPixel = ((float)iw / w) * (2.0f * ex / (float)_vpw);
+	int level = 0;
+	while (level < _lgTopLevel[image] &&
+		texelsPerPixel > (float)(1 << level)) level++;
+
+	int span, tx0, tx1, ty0, ty1;
+	for (;;)
+	{
+		span = VG_LARGE_TILE_SIZE << level;
+		tx0 = (int)px0 / span;
+		tx1 = ((int)ceilf(px1) - 1) / span;
+		ty0 = (int)py0 / span;
+		ty1 = ((int)ceilf(py1) - 1) / span;
+		if (level >= _lgTopLevel[image] ||
+			(tx1 - tx0 + 1) * (ty1 - ty0 + 1) <= LARGE_SLOTS) break;
+		level++;
+	}
+
+	PROFILE_BEGIN("vgDrawLargeImage");
+	glColor4ub(_tcolR, _tcolG, _tcolB, _tcolA);
+	glEnable(GL_TEXTURE_2D);
+
+	/* coarse image first, without depth so tiles land on top of it */
+	_hudBinds += texBind(GL_TEXTURE_2D, _lgCoarse[image]);
+	glDepthMask(GL_FALSE);
+	glBegin(GL_QUADS);
+	glTexCoord2f(0, 0); glVertex2f(x, y);
+	glTexCoord2f(0, 1); glVertex2f(x, y + h);
+	glTexCoord2f(1, 1); glVertex2f(x + w, y + h);
+	glTexCoord2f(1, 0); glVertex2f(x + w, y);
+	glEnd();
+	glDepthMask(GL_TRUE);
+
+	/* resident tiles in one batch, missing ones are paged in */
+	float texel = 1.0f / VG_LARGE_CACHE_SIZE;
+	_hudBinds += texBind(GL_TEXTURE_2D, _lgCache[image]);
+	glBegin(GL_QUADS);
+	for (int ty = ty0; ty <= ty1; ty++)
+	{
+		for (int tx = tx0; tx <= tx1; tx++)
+		{
+			int slot = lgRequest(image, level, tx, ty);
+			if (slot < 0) continue;
+
+			int vw = min(VG_LARGE_TILE_SIZE,
+				((iw + (1 << level) - 1) >> level) - tx * VG_LARGE_TILE_SIZE);
+			int vh = min(VG_LARGE_TILE_SIZE,
+				((ih + (1 << level) - 1) >> level) - ty * VG_LARGE_TILE_SIZE);
+
+			float s0 = ((slot % LARGE_CACHE_TILES) * VG_LARGE_TILE_SIZE +
+				0.5f) * texel;
+			float t0 = ((slot / LARGE_CACHE_TILES) * VG_LARGE_TILE_SIZE +
+				0.5f) * texel;
+			float s1 = s0 + (vw - 1) * texel;
+			float t1 = t0 + (vh - 1) * texel;
+
+			float x0 = x + (float)tx * span / iw * w;
+			float y0 = y + (float)ty * span / ih * h;
+			float x1 = x + (float)min(iw, (tx + 1) * span) / iw * w;
+			float y1 = y + (float)min(ih, (ty + 1) * span) / ih * h;
+
+			glTexCoord2f(s0, t0); glVertex2f(x0, y0);
+			glTexCoord2f(s0, t1); glVertex2f(x0, y1);
+			glTexCoord2f(s1, t1); glVertex2f(x1, y1);
+			glTexCoord2f(s1, t0); glVertex2f(x1, y0);
+		}
+	}
+	glEnd();
+	glDisable(GL_TEXTURE_2D);
+	PROFILE_END();
+
+	/* prefetch the ring around the view with what budget is left */
+	int tilesX = (iw + span - 1) / span;
+	int tilesY = (ih + span - 1) / span;
+	for (int ty = max(0, ty0 - 1); ty <= min(tilesY - 1, ty1 + 1); ty++)
+	{
+		for (int tx = max(0, tx0 - 1); tx <= min(tilesX - 1, tx1 + 1); tx++)
+		{
+			if (tx >= tx0 && tx <= tx1 && ty >= ty0 && ty <= ty1) continue;
+			if (_lgUploads >= VG_LARGE_UPLOADS_MAX) return;
+			lgRequest(image, level, tx, ty);
+		}
+	}
+}
+
+/* CURSOR RELATED FUNCTIONS */
+
+VAPI void vgGetCursorPos(int* x, int* y)
+{
+	POINT p; /* cursor point */
+
+	/* get cursor position and convert to window pos */
+	GetCursorPos(&p);
+	ScreenToClient(_window, &p);
+	
+	/* set params*/
+	*x = p.x; *y = p.y;
+}
+
+VAPI void vgGetCursorPosScaled(float* x, float* y)
+{
+	/* get mouse coordinates */
+	int   mx, my;
+	float fx, fy;
+	vgGetCursorPos(&mx, &my);
+	fx = (float)mx;
+	fy = (float)my;
+
+	/* first, offset to center so that (W/2, H/2) maps to (0, 0)*/
+	fx -= ((float)_windowWidth  / 2.0f);
+	fy -= ((float)_windowHeight / 2.0f);
+
+	/* normalize position so that (W,H) maps to (1, 1) */
+	fx /= (float)((float)_windowWidth / 2.0f);
+	fy /= (float)((float)_windowHeight / 2.0f);
+	fy *= -1; /* flip y coord */
+
+	/* scale and transform */
+	if (_useRScale)
+	{
+		fx *= _rScale;
+		fy *= _rScale;
+	}
+	if (_useROffset)
+	{
+		fx += _rOffsetX;
+		fy += _rOffsetY;
+	}
+
+	/* convert back to int and return */
+	*x = fx; *y = fy;
+}
+
+VAPI int vgOnLeftClick(void)
+{
+	return GetKeyState(VK_LBUTTON) < 0;
+}
+
+VAPI int vgOnRightClick(void)
+{
+	return GetKeyState(VK_RBUTTON) < 0;
+}
+
+VAPI int vgCursorOverlap(float x, float y, float w, float h)
+{
+	float mx, my;
+	vgGetCursorPosScaled(&mx, &my);
+	return (mx > x && mx < x + w) && (my > y && my < y + h);
+}
+
+/* TEXTURE LOADING AND SAVING FUNCTIONS */
+
+VAPI void vgSaveTexture(vgTexture texture, const char* file, int w, int h)
+{
+	VALIDATE(texture == VG_RENDER_TARGET || liveTexture(texture),
+		VG_VALIDATE_HANDLE, "texture %d is not live", texture);
+
+	/* create file and open */
+	FILE* output;
+	output = fopen(file, "wb");
+	if (output == NULL) return;
+
+	/* get texture data */
+	unsigned char* tData = vgGetTextureData(texture, w, h);
+
+	/* write to file */
+	if (tData != NULL)
+		fwrite(tData, sizeof(unsigned char), w * h * 4, output);
+
+	/* free memory and close file */
+	free(tData);
+	fflush(output); fclose(output);
+}
+
+VAPI vgTexture vgLoadTexture(const char* file, int w, int h, int linear,
+	int repeat)
+{
+	/* allocate data buffer */
+	unsigned char* buffer = calloc(1, w * h * 4);
+	if (buffer == 0) return NULL;
+
+	/* open file and read */
+	FILE* rFile = fopen(file, "rb");
+	if (rFile == NULL)
+	{
+		free(buffer);
+		return VG_INVALID;
+	}
+
+	fread(buffer, sizeof(unsigned char), w * h * 4, rFile);
+
+	/* create texture, free and close */
+	vgTexture rTex = vgCreateTexture(w, h, linear, repeat, buffer);
+
+	free(buffer);
+	fflush(rFile);
+	fclose(rFile);
+
+	/* remember where it came from */
+	if (_hrRunning && rTex != VG_INVALID) hotReloadWatch(rTex, file);
+
+	return rTex;
+}
+
+VAPI void* vgLoadTextureData(const char* file, int w, int h)
+{
+	/* allocate data buffer */
+	unsigned char* buffer = calloc(1, w * h * 4);
+	if (buffer == 0) return NULL;
+
+	/* open file and read */
+	FILE* rFile = fopen(file, "rb");
+	if (rFile == NULL)
+	{
+		free(buffer);
+		return NULL;
+	}
+
+	fread(buffer, sizeof(unsigned char), w * h * 4, rFile);
+	fclose(rFile);
+
+	return buffer;
+}
+
+/* IMAGE IMPORT FUNCTIONS */
+
+#define IMPORT_THREADS_MAX ENCODE_THREADS_MAX
+#define ZFAST_BITS 9
+#define ZFAST_MASK ((1 << ZFAST_BITS) - 1)
+
+/* canonical huffman table, short codes resolve in one lookup */
+typedef struct zHuffman
+{
+	unsigned short fast[1 << ZFAST_BITS];
+	unsigned short firstCode[16];
+	unsigned short firstSymbol[16];
+	int maxCode[17];
+	unsigned char size[288];
+	unsigned short value[288];
+} zHuffman;
+
+typedef struct zStream
+{
+	const unsigned char* in;
+	const unsigned char* end;
+	unsigned int bits;
+	int count;
+	int overrun;
+	unsigned char* out;
+	size_t outPos;
+	size_t outSize;
+} zStream;
+
+static const unsigned short _zLenBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11,
+	13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163,
+	195, 227, 258 };
+static const unsigned char _zLenExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1,
+	1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+static const unsigned short _zDistBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17,
+	25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049,
+	3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+static const unsigned char _zDistExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3,
+	4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+static inline int bitReverse(int v, int bits)
+{
+	v = ((v & 0xAAAA) >> 1) | ((v & 0x5555) << 1);
+	v = ((v & 0xCCCC) >> 2) | ((v & 0x3333) << 2);
+	v = ((v & 0xF0F0) >> 4) | ((v & 0x0F0F) << 4);
+	v = ((v & 0xFF00) >> 8) | ((v & 0x00FF) << 8);
+	return v >> (16 - bits);
+}
+
+static int zBuild(zHuffman* z, const unsigned char* sizes, int count)
+{
+	int sizeCount[16] = { 0 };
+	int nextCode[16];
+
+	memset(z->fast, 0, sizeof(z->fast));
+	for (int i = 0; i < count; i++)
+		sizeCount[sizes[i]]++;
+	sizeCount[0] = 0;
+
+	/* first code and symbol of every length */
+	int code = 0, symbol = 0;
+	for (int i = 1; i < 16; i++)
+	{
+		nextCode[i] = code;
+		z->firstCode[i] = code;
+		z->firstSymbol[i] = symbol;
+		code += sizeCount[i];
+		if (sizeCount[i] && code - 1 >= (1 << i)) return FALSE;
+		z->maxCode[i] = code << (16 - i);
+		code <<= 1;
+		symbol += sizeCount[i];
+	}
+	z->maxCode[16] = 0x10000;
 
-	/* add depth to framebuffer */
-	glGenRenderbuffers(1, &_depth);
-	glBindRenderbuffer(GL_RENDERBUFFER, _depth);
-	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, resolution_w,
-		resolution_h);
-	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
-		GL_RENDERBUFFER, _depth);
+	for (int i = 0; i < count; i++)
+	{
+		int s = sizes[i];
+		if (s == 0) continue;
 
-	/* enable depth */
-	glEnable(GL_DEPTH_TEST);
+		int c = nextCode[s] - z->firstCode[s] + z->firstSymbol[s];
+		z->size[c] = s;
+		z->value[c] = i;
 
-	/* connect framebuffer with texture */
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
-		_texture, NULL);
-	glDrawBuffer(GL_COLOR_ATTACHMENT0);
+		/* codes are stored bit reversed, fill every suffix */
+		if (s <= ZFAST_BITS)
+		{
+			for (int j = bitReverse(nextCode[s], s); j < (1 << ZFAST_BITS);
+				j += 1 << s)
+				z->fast[j] = (unsigned short)((s << 9) | i);
+		}
+		nextCode[s]++;
+	}
 
-	/* setup texture filter params */
-	_tcolR = 255;
-	_tcolG = 255;
-	_tcolB = 255;
-	_tcolA = 255;
+	return TRUE;
+}
 
-	/* setup projection */
-	_windowWidth = window_w;
-	_windowHeight = window_h;
-	_resW = resolution_w;
-	_resH = resolution_h;
+static inline void zFill(zStream* z)
+{
+	while (z->count <= 24)
+	{
+		/* zeros past the end, too many means the stream is truncated */
+		unsigned int b = 0;
+		if (z->in < z->end) b = *z->in++;
+		else z->overrun++;
+		z->bits |= b << z->count;
+		z->count += 8;
+	}
+}
 
-	_vpx = 0;
-	_vpy = 0;
-	_vpw = resolution_w;
-	_vph = resolution_h;
+static inline unsigned int zBits(zStream* z, int n)
+{
+	if (z->count < n) zFill(z);
+	unsigned int v = z->bits & ((1u << n) - 1);
+	z->bits >>= n;
+	z->count -= n;
+	return v;
+}
 
-	_rScale = 1; _useRScale = 1;
-	_rOffsetX = 0; _rOffsetY = 0; _useROffset = 1;
+static inline int zDecode(zStream* z, const zHuffman* h)
+{
+	if (z->count < 16) zFill(z);
 
-	/* init texture editing data */
-	glGenFramebuffers(1, &_eFrameBuffer);
-	glBindFramebuffer(GL_FRAMEBUFFER, _eFrameBuffer);
+	int fast = h->fast[z->bits & ZFAST_MASK];
+	if (fast)
+	{
+		int s = fast >> 9;
+		z->bits >>= s;
+		z->count -= s;
+		return fast & 0x1FF;
+	}
 
-	/* init texture reading framebuffer */
-	glGenFramebuffers(1, &_rFrameBuffer);
-	glBindFramebuffer(GL_FRAMEBUFFER, _rFrameBuffer);
+	/* long code, find its length by comparing left aligned */
+	int k = bitReverse(z->bits & 0xFFFF, 16);
+	int s = ZFAST_BITS + 1;
+	while (k >= h->maxCode[s]) s++;
+	if (s >= 16) return -1;
+
+	int c = (k >> (16 - s)) - h->firstCode[s] + h->firstSymbol[s];
+	if (c < 0 || c >= 288 || h->size[c] != s) return -1;
+	z->bits >>= s;
+	z->count -= s;
+	return h->value[c];
+}
 
-	/* setup blend funcs */
-	glEnable(GL_BLEND);
-	glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA,
-		GL_ONE, GL_ONE);
+static int zBlock(zStream* z, const zHuffman* lit, const zHuffman* dist)
+{
+	for (;;)
+	{
+		if (z->overrun > 4) return FALSE;
 
-	/* set winstate to true */
-	_winState = TRUE;
+		int s = zDecode(z, lit);
+		if (s < 0) return FALSE;
+		if (s < 256)
+		{
+			if (z->outPos >= z->outSize) return FALSE;
+			z->out[z->outPos++] = (unsigned char)s;
+			continue;
+		}
+		if (s == 256) return TRUE;
+
+		s -= 257;
+		if (s >= 29) return FALSE;
+		int len = _zLenBase[s] + zBits(z, _zLenExtra[s]);
+		int d = zDecode(z, dist);
+		if (d < 0 || d >= 30) return FALSE;
+		size_t back = _zDistBase[d] + zBits(z, _zDistExtra[d]);
+		if (back > z->outPos || z->outPos + len > z->outSize) return FALSE;
+
+		/* overlapping copies repeat, so go byte by byte */
+		unsigned char* p = z->out + z->outPos;
+		const unsigned char* q = p - back;
+		if (back == 1) memset(p, *q, len);
+		else for (int i = 0; i < len; i++) p[i] = q[i];
+		z->outPos += len;
+	}
 }
 
-VAPI void vgTerminate(void)
+static int zDynamic(zStream* z, zHuffman* lit, zHuffman* dist)
 {
-	/* if window is open, close it */
-	if (_winState) DestroyWindow(_window);
+	static const unsigned char order[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10,
+		5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+	unsigned char lens[286 + 32];
+	unsigned char codeLens[19] = { 0 };
+	zHuffman codes;
+
+	int hlit = zBits(z, 5) + 257;
+	int hdist = zBits(z, 5) + 1;
+	int hclen = zBits(z, 4) + 4;
+	for (int i = 0; i < hclen; i++)
+		codeLens[order[i]] = (unsigned char)zBits(z, 3);
+	if (!zBuild(&codes, codeLens, 19)) return FALSE;
+
+	int n = 0;
+	while (n < hlit + hdist)
+	{
+		int c = zDecode(z, &codes);
+		if (c < 0 || c >= 19) return FALSE;
+		if (c < 16)
+		{
+			lens[n++] = (unsigned char)c;
+			continue;
+		}
+
+		int fill = 0, repeat;
+		if (c == 16)
+		{
+			if (n == 0) return FALSE;
+			fill = lens[n - 1];
+			repeat = zBits(z, 2) + 3;
+		}
+		else if (c == 17) repeat = zBits(z, 3) + 3;
+		else repeat = zBits(z, 7) + 11;
+
+		if (n + repeat > hlit + hdist) return FALSE;
+		memset(lens + n, fill, repeat);
+		n += repeat;
+	}
+
+	return zBuild(lit, lens, hlit) && zBuild(dist, lens + hlit, hdist);
 }
 
-/* MODULE UPDATE FUNCTIONS */
+static int zInflate(zStream* z)
+{
+	zHuffman lit, dist;
+	int final;
 
-static long long _lastTick = 0;
-VAPI void vgUpdate(void)
+	/* zlib header, deflate with no preset dictionary */
+	if (z->end - z->in < 2) return FALSE;
+	int cmf = z->in[0], flg = z->in[1];
+	if ((cmf * 256 + flg) % 31 || (cmf & 15) != 8 || (flg & 32))
+		return FALSE;
+	z->in += 2;
+
+	do
+	{
+		final = zBits(z, 1);
+		int type = zBits(z, 2);
+
+		if (type == 0)
+		{
+			/* stored, realign and drain whole bytes left in the buffer */
+			zBits(z, z->count & 7);
+			int len = zBits(z, 16);
+			int nlen = zBits(z, 16);
+			if (len != (~nlen & 0xFFFF)) return FALSE;
+			if (z->outPos + len > z->outSize) return FALSE;
+
+			for (; len && z->count >= 8; len--)
+				z->out[z->outPos++] = (unsigned char)zBits(z, 8);
+			if (z->overrun || z->end - z->in < len) return FALSE;
+			memcpy(z->out + z->outPos, z->in, len);
+			z->outPos += len;
+			z->in += len;
+			continue;
+		}
+
+		if (type == 1)
+		{
+			unsigned char lens[288];
+			memset(lens, 8, 144);
+			memset(lens + 144, 9, 112);
+			memset(lens + 256, 7, 24);
+			memset(lens + 280, 8, 8);
+			zBuild(&lit, lens, 288);
+			memset(lens, 5, 30);
+			zBuild(&dist, lens, 30);
+		}
+		else if (type != 2 || !zDynamic(z, &lit, &dist)) return FALSE;
+
+		if (!zBlock(z, &lit, &dist)) return FALSE;
+	} while (!final);
+
+	return TRUE;
+}
+
+static inline int load32(const void* p)
 {
-	/* dispatch messages */
-	MSG messageCheck;
-	PeekMessageA(&messageCheck, NULL, NULL, NULL,
-		PM_REMOVE);
-	DispatchMessageA(&messageCheck);
+	/* unaligned, compiles to a plain load */
+	int v;
+	memcpy(&v, p, 4);
+	return v;
+}
 
-	/* flush openGL */
-	if (GetTickCount64() > _lastTick + 
-		VG_FLUSH_THRESHOLD)
+static inline void store32(void* p, int v)
+{
+	memcpy(p, &v, 4);
+}
+
+static inline unsigned int readBE32(const unsigned char* p)
+{
+	return ((unsigned int)p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+}
+
+static inline int pngPaeth(int a, int b, int c)
+{
+	int pa = abs(b - c), pb = abs(a - c), pc = abs(a + b - 2 * c);
+	if (pa <= pb && pa <= pc) return a;
+	return pb <= pc ? b : c;
+}
+
+static int pngUnfilter(unsigned char* cur, const unsigned char* prev, int n,
+	int bpp, int type)
+{
+	int i = 0;
+	__m128i zero = _mm_setzero_si128();
+
+	switch (type)
 	{
-		glFlush();
-		_lastTick = GetTickCount64();
+	case 0:
+		return TRUE;
+
+	case 1:
+		/* four byte pixels, prefix sum four at a time */
+		if (bpp == 4)
+		{
+			__m128i carry = zero;
+			for (; i + 16 <= n; i += 16)
+			{
+				__m128i x = _mm_loadu_si128((__m128i*)(cur + i));
+				x = _mm_add_epi8(x, _mm_slli_si128(x, 4));
+				x = _mm_add_epi8(x, _mm_slli_si128(x, 8));
+				x = _mm_add_epi8(x, carry);
+				_mm_storeu_si128((__m128i*)(cur + i), x);
+				carry = _mm_shuffle_epi32(x, 0xFF);
+			}
+		}
+		for (i = max(i, bpp); i < n; i++)
+			cur[i] += cur[i - bpp];
+		return TRUE;
+
+	case 2:
+		for (; i + 16 <= n; i += 16)
+		{
+			__m128i x = _mm_loadu_si128((__m128i*)(cur + i));
+			__m128i y = _mm_loadu_si128((__m128i*)(prev + i));
+			_mm_storeu_si128((__m128i*)(cur + i), _mm_add_epi8(x, y));
+		}
+		for (; i < n; i++)
+			cur[i] += prev[i];
+		return TRUE;
+
+	case 3:
+		for (; i < bpp; i++)
+			cur[i] += prev[i] >> 1;
+
+		/* floor average is the rounded average minus the odd bit */
+		if (bpp == 4)
+		{
+			__m128i one = _mm_set1_epi8(1);
+			__m128i a = _mm_cvtsi32_si128(load32(cur));
+			for (; i + 4 <= n; i += 4)
+			{
+				__m128i b = _mm_cvtsi32_si128(load32(prev + i));
+				__m128i avg = _mm_sub_epi8(_mm_avg_epu8(a, b),
+					_mm_and_si128(_mm_xor_si128(a, b), one));
+				a = _mm_add_epi8(avg, _mm_cvtsi32_si128(load32(cur + i)));
+				store32(cur + i, _mm_cvtsi128_si32(a));
+			}
+		}
+		for (; i < n; i++)
+			cur[i] += (cur[i - bpp] + prev[i]) >> 1;
+		return TRUE;
+
+	case 4:
+		for (; i < bpp; i++)
+			cur[i] += prev[i];
+
+		/* whole pixel at once in 16 bit lanes */
+		if (bpp == 4)
+		{
+			__m128i a = _mm_unpacklo_epi8(_mm_cvtsi32_si128(load32(cur)),
+				zero);
+			__m128i c = _mm_unpacklo_epi8(_mm_cvtsi32_si128(load32(prev)),
+				zero);
+			for (; i + 4 <= n; i += 4)
+			{
+				__m128i b = _mm_unpacklo_epi8(
+					_mm_cvtsi32_si128(load32(prev + i)), zero);
+				__m128i pa = _mm_sub_epi16(b, c);
+				__m128i pb = _mm_sub_epi16(a, c);
+				__m128i pc = _mm_add_epi16(pa, pb);
+				pa = _mm_max_epi16(pa, _mm_sub_epi16(zero, pa));
+				pb = _mm_max_epi16(pb, _mm_sub_epi16(zero, pb));
+				pc = _mm_max_epi16(pc, _mm_sub_epi16(zero, pc));
+
+				__m128i useC = _mm_cmpgt_epi16(pb, pc);
+				__m128i bc = _mm_or_si128(_mm_and_si128(useC, c),
+					_mm_andnot_si128(useC, b));
+				__m128i notA = _mm_or_si128(_mm_cmpgt_epi16(pa, pb),
+					_mm_cmpgt_epi16(pa, pc));
+				__m128i pred = _mm_or_si128(_mm_and_si128(notA, bc),
+					_mm_andnot_si128(notA, a));
+
+				__m128i x = _mm_add_epi8(_mm_packus_epi16(pred, pred),
+					_mm_cvtsi32_si128(load32(cur + i)));
+				store32(cur + i, _mm_cvtsi128_si32(x));
+				a = _mm_unpacklo_epi8(x, zero);
+				c = b;
+			}
+		}
+		for (; i < n; i++)
+			cur[i] += pngPaeth(cur[i - bpp], prev[i], prev[i - bpp]);
+		return TRUE;
 	}
+
+	return FALSE;
 }
 
-VAPI unsigned long long vgUpdateCount(void)
+static inline int pngSample(const unsigned char* row, int index, int depth)
 {
-	return _updates;
+	if (depth == 8) return row[index];
+	if (depth == 16) return (row[index * 2] << 8) | row[index * 2 + 1];
+
+	int bit = index * depth;
+	return (row[bit >> 3] >> (8 - depth - (bit & 7))) & ((1 << depth) - 1);
 }
 
-/* MISC RENDERING FUNCTIONS */
+static void pngExpandRow(const unsigned char* row, int count, int color,
+	int depth, const unsigned char* palette, const int* key,
+	unsigned char* dst, int step)
+{
+	/* the common case is already the upload layout */
+	if (color == 6 && depth == 8 && step == 4)
+	{
+		memcpy(dst, row, (size_t)count * 4);
+		return;
+	}
 
-VAPI void vgSetWindowSize(int window_w, int window_h)
+	int channels = color == 2 ? 3 : color == 4 ? 2 : color == 6 ? 4 : 1;
+	int scale = depth < 8 ? 255 / ((1 << depth) - 1) : 1;
+	int shift = depth == 16 ? 8 : 0;
+
+	for (int x = 0; x < count; x++, dst += step)
+	{
+		int s[4];
+		for (int c = 0; c < channels; c++)
+			s[c] = pngSample(row, x * channels + c, depth);
+
+		if (color == 3)
+		{
+			memcpy(dst, palette + s[0] * 4, 4);
+			continue;
+		}
+
+		if (channels <= 2)
+		{
+			int g = (s[0] >> shift) * scale;
+			dst[0] = dst[1] = dst[2] = (unsigned char)g;
+			if (channels == 2) dst[3] = (unsigned char)(s[1] >> shift);
+			else dst[3] = key && s[0] == key[0] ? 0 : 255;
+			continue;
+		}
+
+		dst[0] = (unsigned char)(s[0] >> shift);
+		dst[1] = (unsigned char)(s[1] >> shift);
+		dst[2] = (unsigned char)(s[2] >> shift);
+		if (channels == 4) dst[3] = (unsigned char)(s[3] >> shift);
+		else dst[3] = key && s[0] == key[0] && s[1] == key[1] &&
+			s[2] == key[2] ? 0 : 255;
+	}
+}
+
+static unsigned char* decodePNG(const unsigned char* file, size_t size,
+	int* w, int* h)
 {
-	/* calculate target rect */
-	RECT tRect = { 0, 0, window_w, window_h };
-	AdjustWindowRectExForDpi(&tRect,
-		WS_VISIBLE | WS_SYSMENU | WS_MAXIMIZEBOX |
-		WS_THICKFRAME, TRUE,
-		WS_VISIBLE | WS_SYSMENU | WS_MAXIMIZEBOX |
-		WS_THICKFRAME,
-		GetDpiForSystem());
-	int winWidth  = tRect.right - tRect.left;
-	int winHeight = tRect.bottom - tRect.top;
+	static const unsigned char sig[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
+	static const int passX[7] = { 0, 4, 0, 2, 0, 1, 0 };
+	static const int passY[7] = { 0, 0, 4, 0, 2, 0, 1 };
+	static const int passDX[7] = { 8, 8, 4, 4, 2, 2, 1 };
+	static const int passDY[7] = { 8, 8, 8, 4, 4, 2, 2 };
+
+	if (size < 8 || memcmp(file, sig, 8) != 0) return NULL;
+
+	unsigned char palette[256 * 4];
+	memset(palette, 255, sizeof(palette));
+	int key[3];
+	int hasKey = FALSE;
+	int width = 0, height = 0, depth = 0, color = -1, interlace = 0;
+	size_t idatSize = 0;
+
+	/* first pass, header and the total compressed size */
+	const unsigned char* p = file + 8;
+	const unsigned char* end = file + size;
+	while (end - p >= 12)
+	{
+		unsigned int len = readBE32(p);
+		const unsigned char* type = p + 4;
+		const unsigned char* data = p + 8;
+		if ((size_t)(end - data) < (size_t)len + 4) return NULL;
 
-	/* set new window pos (NOMOVE) */
-	SetWindowPos(_window,
-		NULL, 0, 0,
-		winWidth,
-		winHeight,
-		SWP_NOMOVE);
+		if (memcmp(type, "IHDR", 4) == 0 && len >= 13)
+		{
+			width = readBE32(data);
+			height = readBE32(data + 4);
+			depth = data[8];
+			color = data[9];
+			interlace = data[12];
+		}
+		else if (memcmp(type, "PLTE", 4) == 0)
+		{
+			for (unsigned int i = 0; i < len / 3 && i < 256; i++)
+				memcpy(palette + i * 4, data + i * 3, 3);
+		}
+		else if (memcmp(type, "tRNS", 4) == 0)
+		{
+			if (color == 3)
+			{
+				for (unsigned int i = 0; i < len && i < 256; i++)
+					palette[i * 4 + 3] = data[i];
+			}
+			else if (color == 0 && len >= 2)
+			{
+				key[0] = (data[0] << 8) | data[1];
+				hasKey = TRUE;
+			}
+			else if (color == 2 && len >= 6)
+			{
+				for (int i = 0; i < 3; i++)
+					key[i] = (data[i * 2] << 8) | data[i * 2 + 1];
+				hasKey = TRUE;
+			}
+		}
+		else if (memcmp(type, "IDAT", 4) == 0) idatSize += len;
+		else if (memcmp(type, "IEND", 4) == 0) break;
 
-	/* clear and swap to remove artifacts */
-	glBindFramebuffer(GL_FRAMEBUFFER, NULL);
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-	SwapBuffers(_deviceContext);
+		p = data + len + 4;
+	}
 
-	/* update window dimensions */
-	_windowWidth = window_w;
-	_windowHeight = window_h;
+	int channels = color == 2 ? 3 : color == 4 ? 2 : color == 6 ? 4 : 1;
+	int validDepth = depth == 8 || (depth == 16 && color != 3) ||
+		((depth == 1 || depth == 2 || depth == 4) && (color == 0 ||
+		color == 3));
+	if (width <= 0 || height <= 0 || width > TEXTURE_SIZE_MAX ||
+		height > TEXTURE_SIZE_MAX || color < 0 || color == 1 || color == 5 ||
+		color > 6 || !validDepth || interlace > 1 || idatSize == 0)
+		return NULL;
+
+	/* 8 bit keys compare against the raw sample */
+	if (depth < 16 && hasKey)
+		for (int i = 0; i < 3; i++) key[i] &= (1 << depth) - 1;
+
+	int bits = channels * depth;
+	int bpp = max(1, bits / 8);
+	int passes = interlace ? 7 : 1;
+
+	/* exact inflated size, so the stream decodes into one buffer */
+	size_t rawSize = 0;
+	for (int i = 0; i < passes; i++)
+	{
+		int dx = interlace ? passDX[i] : 1, dy = interlace ? passDY[i] : 1;
+		int x0 = interlace ? passX[i] : 0, y0 = interlace ? passY[i] : 0;
+		if (width <= x0 || height <= y0) continue;
+		size_t pw = (width - x0 + dx - 1) / dx;
+		size_t ph = (height - y0 + dy - 1) / dy;
+		rawSize += ph * (1 + (pw * bits + 7) / 8);
+	}
+
+	unsigned char* idat = malloc(idatSize);
+	unsigned char* raw = malloc(rawSize);
+	unsigned char* zeros = calloc(1, ((size_t)width * bits + 7) / 8);
+	unsigned char* rgba = malloc((size_t)width * height * 4);
+	int ok = idat && raw && zeros && rgba;
+
+	/* second pass, gather the compressed chunks */
+	size_t offset = 0;
+	p = file + 8;
+	while (ok && end - p >= 12)
+	{
+		unsigned int len = readBE32(p);
+		if (memcmp(p + 4, "IDAT", 4) == 0)
+		{
+			memcpy(idat + offset, p + 8, len);
+			offset += len;
+		}
+		if (memcmp(p + 4, "IEND", 4) == 0) break;
+		p += 12 + len;
+	}
+
+	zStream z = { 0 };
+	z.in = idat;
+	z.end = idat + idatSize;
+	z.out = raw;
+	z.outSize = rawSize;
+	ok = ok && zInflate(&z) && z.outPos == rawSize;
+
+	/* unfilter in place, expand straight into bottom-up rows */
+	unsigned char* row = raw;
+	for (int i = 0; ok && i < passes; i++)
+	{
+		int dx = interlace ? passDX[i] : 1, dy = interlace ? passDY[i] : 1;
+		int x0 = interlace ? passX[i] : 0, y0 = interlace ? passY[i] : 0;
+		if (width <= x0 || height <= y0) continue;
+		int pw = (width - x0 + dx - 1) / dx;
+		int rowBytes = (pw * bits + 7) / 8;
+
+		const unsigned char* prev = zeros;
+		for (int y = y0; ok && y < height; y += dy)
+		{
+			ok = pngUnfilter(row + 1, prev, rowBytes, bpp, row[0]);
+			unsigned char* dst = rgba + ((size_t)(height - 1 - y) * width +
+				x0) * 4;
+			pngExpandRow(row + 1, pw, color, depth, palette,
+				hasKey ? key : NULL, dst, dx * 4);
+			prev = row + 1;
+			row += rowBytes + 1;
+		}
+	}
+
+	free(idat);
+	free(raw);
+	free(zeros);
+	if (!ok)
+	{
+		free(rgba);
+		return NULL;
+	}
+
+	*w = width;
+	*h = height;
+	return rgba;
 }
 
-VAPI void vgGetResolution(int* w, int* h)
+static void swizzleBGRA(const unsigned char* src, unsigned char* dst,
+	int count)
 {
-	*w = _resW; *h = _resH;
+	/* swap the red and blue bytes of four pixels at once */
+	int i = 0;
+	__m128i ga = _mm_set1_epi32(0xFF00FF00);
+	__m128i lo = _mm_set1_epi32(0x000000FF);
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128i x = _mm_loadu_si128((__m128i*)(src + i * 4));
+		__m128i r = _mm_and_si128(_mm_srli_epi32(x, 16), lo);
+		__m128i b = _mm_slli_epi32(_mm_and_si128(x, lo), 16);
+		x = _mm_or_si128(_mm_and_si128(x, ga), _mm_or_si128(r, b));
+		_mm_storeu_si128((__m128i*)(dst + i * 4), x);
+	}
+	for (; i < count; i++)
+	{
+		unsigned char b = src[i * 4];
+		dst[i * 4 + 0] = src[i * 4 + 2];
+		dst[i * 4 + 1] = src[i * 4 + 1];
+		dst[i * 4 + 2] = b;
+		dst[i * 4 + 3] = src[i * 4 + 3];
+	}
+}
+
+static unsigned char* decodeBMP(const unsigned char* file, size_t size,
+	int* w, int* h)
+{
+	if (size < 54 || file[0] != 'B' || file[1] != 'M') return NULL;
+
+	unsigned int dataOffset = (unsigned int)load32(file + 10);
+	unsigned int headerSize = (unsigned int)load32(file + 14);
+	int width = load32(file + 18);
+	int height = load32(file + 22);
+	int bits = file[28] | (file[29] << 8);
+	int compression = load32(file + 30);
+	unsigned int colors = (unsigned int)load32(file + 46);
+
+	/* negative height is stored top row first */
+	int topDown = height < 0;
+	height = abs(height);
+
+	/* bitfields only with the usual BGRA masks */
+	int masksOk = compression == 0 || (compression == 3 && bits == 32 &&
+		size >= 66 && (unsigned int)load32(file + 54) == 0x00FF0000 &&
+		(unsigned int)load32(file + 58) == 0x0000FF00 &&
+		(unsigned int)load32(file + 62) == 0x000000FF);
+	if (headerSize < 40 || headerSize > size || width <= 0 || height <= 0 ||
+		width > TEXTURE_SIZE_MAX || height > TEXTURE_SIZE_MAX || !masksOk ||
+		(bits != 8 && bits != 24 && bits != 32))
+		return NULL;
+
+	size_t stride = (((size_t)width * bits + 31) / 32) * 4;
+	if (dataOffset > size || size - dataOffset < stride * height) return NULL;
+
+	const unsigned char* palette = file + 14 + headerSize;
+	if (colors == 0 || colors > 256) colors = 256;
+	if (bits == 8 && (size_t)(palette - file) + colors * 4 > dataOffset)
+		return NULL;
+
+	unsigned char* rgba = malloc((size_t)width * height * 4);
+	if (rgba == NULL) return NULL;
+
+	int anyAlpha = 0;
+	for (int y = 0; y < height; y++)
+	{
+		const unsigned char* src = file + dataOffset + stride *
+			(topDown ? height - 1 - y : y);
+		unsigned char* dst = rgba + (size_t)y * width * 4;
+
+		if (bits == 32)
+		{
+			swizzleBGRA(src, dst, width);
+			for (int x = 0; x < width; x++) anyAlpha |= dst[x * 4 + 3];
+			continue;
+		}
+
+		for (int x = 0; x < width; x++, dst += 4)
+		{
+			const unsigned char* c = bits == 8 ? (src[x] < colors ?
+				palette + src[x] * 4 : palette) : src + x * 3;
+			dst[0] = c[2];
+			dst[1] = c[1];
+			dst[2] = c[0];
+			dst[3] = 255;
+		}
+	}
+
+	/* plain 32 bit files leave the fourth byte zero */
+	if (bits == 32 && !anyAlpha)
+		for (size_t i = 0; i < (size_t)width * height; i++)
+			rgba[i * 4 + 3] = 255;
+
+	*w = width;
+	*h = height;
+	return rgba;
+}
+
+static inline void tgaPixel(const unsigned char* src, int bytes, int gray,
+	unsigned char* dst)
+{
+	if (gray)
+	{
+		dst[0] = dst[1] = dst[2] = src[0];
+		dst[3] = bytes == 2 ? src[1] : 255;
+		return;
+	}
+
+	if (bytes == 2)
+	{
+		int v = src[0] | (src[1] << 8);
+		dst[0] = (unsigned char)(((v >> 10) & 31) * 255 / 31);
+		dst[1] = (unsigned char)(((v >> 5) & 31) * 255 / 31);
+		dst[2] = (unsigned char)((v & 31) * 255 / 31);
+		dst[3] = 255;
+		return;
+	}
+
+	dst[0] = src[2];
+	dst[1] = src[1];
+	dst[2] = src[0];
+	dst[3] = bytes == 4 ? src[3] : 255;
+}
+
+static unsigned char* decodeTGA(const unsigned char* file, size_t size,
+	int* w, int* h)
+{
+	if (size < 18) return NULL;
+
+	int mapType = file[1], type = file[2];
+	int mapLength = file[5] | (file[6] << 8);
+	int mapBytes = (file[7] + 7) / 8;
+	int width = file[12] | (file[13] << 8);
+	int height = file[14] | (file[15] << 8);
+	int bytes = file[16] / 8;
+	int topDown = (file[17] >> 5) & 1;
+
+	int rle = type >= 9;
+	int base = type & 7;
+	int gray = base == 3;
+	if (mapType > 1 || (base != 1 && base != 2 && base != 3) ||
+		width == 0 || height == 0 || width > TEXTURE_SIZE_MAX ||
+		height > TEXTURE_SIZE_MAX || (base == 1 && (mapType != 1 ||
+		bytes != 1)) || (base == 2 && (bytes < 2 || bytes > 4)) ||
+		(base == 3 && bytes != 1 && bytes != 2))
+		return NULL;
+
+	const unsigned char* map = file + 18 + file[0];
+	const unsigned char* p = map + (mapType ? mapLength * mapBytes : 0);
+	const unsigned char* end = file + size;
+	if (p > end) return NULL;
+
+	/* colour mapped pixels read an index, then the map entry */
+	int inBytes = base == 1 ? 1 : bytes;
+	if (base == 1 && (mapBytes < 2 || mapBytes > 4)) return NULL;
+
+	unsigned char* rgba = malloc((size_t)width * height * 4);
+	if (rgba == NULL) return NULL;
+
+	int ok = TRUE, run = 0, literal = FALSE, fetch = FALSE;
+	unsigned char color[4] = { 0 };
+	for (int y = 0; ok && y < height; y++)
+	{
+		unsigned char* dst = rgba + (size_t)(topDown ? height - 1 - y : y) *
+			width * 4;
+
+		/* uncompressed true colour rows convert as a block */
+		if (!rle && base == 2 && bytes == 4)
+		{
+			ok = end - p >= width * 4;
+			if (ok) swizzleBGRA(p, dst, width);
+			p += width * 4;
+			continue;
+		}
+
+		for (int x = 0; ok && x < width; x++, dst += 4)
+		{
+			/* packets may run across rows */
+			if (rle && run == 0)
+			{
+				if (p >= end) { ok = FALSE; break; }
+				literal = !(*p & 128);
+				run = (*p & 127) + 1;
+				fetch = TRUE;
+				p++;
+			}
+
+			/* repeat packets decode their pixel once */
+			if (!rle || literal || fetch)
+			{
+				if (end - p < inBytes) { ok = FALSE; break; }
+				if (base != 1) tgaPixel(p, bytes, gray, color);
+				else if (*p < mapLength)
+					tgaPixel(map + *p * mapBytes, mapBytes, FALSE, color);
+				else ok = FALSE;
+				p += inBytes;
+				fetch = FALSE;
+			}
+
+			memcpy(dst, color, 4);
+			if (rle) run--;
+		}
+	}
+
+	if (!ok)
+	{
+		free(rgba);
+		return NULL;
+	}
+
+	*w = width;
+	*h = height;
+	return rgba;
+}
+
+static unsigned char* decodeImage(const char* file, int* w, int* h)
+{
+	/* one read for the whole file, decoders work from memory */
+	FILE* rFile = fopen(file, "rb");
+	if (rFile == NULL) return NULL;
+
+	fseek(rFile, 0, SEEK_END);
+	long size = ftell(rFile);
+	fseek(rFile, 0, SEEK_SET);
+
+	unsigned char* data = size > 0 ? malloc(size) : NULL;
+	size_t read = data ? fread(data, 1, size, rFile) : 0;
+	fclose(rFile);
+
+	unsigned char* rgba = NULL;
+	if (read == (size_t)size && data != NULL)
+	{
+		rgba = decodePNG(data, size, w, h);
+		if (rgba == NULL) rgba = decodeBMP(data, size, w, h);
+		if (rgba == NULL) rgba = decodeTGA(data, size, w, h);
+	}
+
+	free(data);
+	return rgba;
 }
 
-VAPI void vgSetWindowTitle(const char* title)
+static int isImagePath(const char* file)
 {
-	SetWindowTextA(_window, title);
+	const char* ext = strrchr(file, '.');
+	return ext != NULL && (_stricmp(ext, ".png") == 0 ||
+		_stricmp(ext, ".bmp") == 0 || _stricmp(ext, ".tga") == 0);
 }
 
-VAPI void vgGetScreenSize(int* width, int* height)
+typedef struct importJob
 {
-	int screenX = GetSystemMetrics(SM_CXSCREEN);
-	int screenY = GetSystemMetrics(SM_CYSCREEN);
-	*width  = screenX;
-	*height = screenY;
+	const char** files;
+	void** data;
+	int* w;
+	int* h;
+	int count;
+	volatile LONG* next;
+} importJob;
+
+static DWORD WINAPI importWorker(LPVOID param)
+{
+	importJob* job = param;
+
+	/* files vary a lot in size, so take them one at a time */
+	for (;;)
+	{
+		int i = InterlockedIncrement(job->next) - 1;
+		if (i >= job->count) break;
+		PROFILE_BEGIN("image decode");
+		job->data[i] = decodeImage(job->files[i], &job->w[i], &job->h[i]);
+		PROFILE_END();
+	}
+
+	return 0;
 }
 
-VAPI int vgWindowIsClosed(void)
+VAPI void* vgLoadImageData(const char* file, int* w, int* h)
 {
-	return (!_winState);
+	int width = 0, height = 0;
+	PROFILE_BEGIN("image decode");
+	unsigned char* rgba = decodeImage(file, &width, &height);
+	PROFILE_END();
+
+	if (w) *w = width;
+	if (h) *h = height;
+	return rgba;
 }
 
-VAPI void vgSetSwapTime(int swapTime)
+VAPI vgTexture vgLoadImage(const char* file, int linear, int repeat)
 {
-	/* check for bad state */
-	if (swapTime < VG_SWAP_TIME_MIN) return;
+	int w, h;
+	unsigned char* rgba = decodeImage(file, &w, &h);
+	if (rgba == NULL) return VG_INVALID;
 
-	/* set new swaptime */
-	_swapTime = swapTime;
+	vgTexture rTex = vgCreateTexture(w, h, linear, repeat, rgba);
+	free(rgba);
+
+	if (_hrRunning && rTex != VG_INVALID) hotReloadWatch(rTex, file);
+
+	return rTex;
 }
 
-VAPI void vgUseRenderSkip(int state)
+VAPI int vgLoadImageDataBatch(const char** files, int count, void** data,
+	int* w, int* h)
 {
-	_useRenderSkip = state;
+	HANDLE threads[IMPORT_THREADS_MAX];
+	volatile LONG next = 0;
+	importJob job = { files, data, w, h, count, &next };
+
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	int threadCount = min((int)info.dwNumberOfProcessors, IMPORT_THREADS_MAX);
+	threadCount = max(1, min(threadCount, count));
+
+	/* calling thread decodes too */
+	for (int i = 1; i < threadCount; i++)
+		threads[i] = CreateThread(NULL, 0, importWorker, &job, 0, NULL);
+	importWorker(&job);
+
+	for (int i = 1; i < threadCount; i++)
+	{
+		if (threads[i] == NULL) continue;
+		WaitForSingleObject(threads[i], INFINITE);
+		CloseHandle(threads[i]);
+	}
+
+	int loaded = 0;
+	for (int i = 0; i < count; i++)
+		if (data[i] != NULL) loaded++;
+
+	return loaded;
 }
 
-VAPI int vgGetRenderSkipState(void)
+VAPI int vgLoadImageBatch(const char** files, int count, vgTexture* textures,
+	int linear, int repeat)
 {
-	return _renderSkip && _useRenderSkip;
-}
+	void** data = calloc(count, sizeof(void*));
+	int* size = calloc(count * 2, sizeof(int));
+	if (data == NULL || size == NULL)
+	{
+		free(data);
+		free(size);
+		return 0;
+	}
 
-/* CLEAR AND SWAP FUNCTIONS */
+	/* decode everything in parallel, uploads stay on this thread */
+	vgLoadImageDataBatch(files, count, data, size, size + count);
 
-VAPI void vgClear(void)
-{
-	RENDERSKIP(_useRenderSkip);
+	int loaded = 0;
+	for (int i = 0; i < count; i++)
+	{
+		textures[i] = VG_INVALID;
+		if (data[i] == NULL) continue;
+
+		textures[i] = vgCreateTexture(size[i], size[count + i], linear,
+			repeat, data[i]);
+		if (_hrRunning && textures[i] != VG_INVALID)
+			hotReloadWatch(textures[i], files[i]);
+		free(data[i]);
+		if (textures[i] != VG_INVALID) loaded++;
+	}
 
-	glBindFramebuffer(GL_FRAMEBUFFER, _framebuffer);
-	glViewport(0, 0, _resW, _resH);
-	glClearColor(0, 0, 0, 1);
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	free(data);
+	free(size);
+	return loaded;
 }
 
-VAPI void vgFill(int r, int g, int b)
+/* HOT RELOAD FUNCTIONS */
+
+static void hotReloadScan(const char* dir)
 {
-	RENDERSKIP(_useRenderSkip);
+	char path[MAX_PATH];
+	char fileDir[MAX_PATH];
 
-	glBindFramebuffer(GL_FRAMEBUFFER, _framebuffer);
-	glViewport(0, 0, _resW, _resH);
-	glClearColor(r / 255.0f, g / 255.0f, b / 255.0f, 1);
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	for (int i = 0; i < VG_TEXTURES_MAX; i++)
+	{
+		/* copy what the read needs, the texture may die meanwhile */
+		EnterCriticalSection(&_hrLock);
+		int watched = _hrPath[i] != NULL && strlen(_hrPath[i]) < MAX_PATH;
+		if (watched) strcpy(path, _hrPath[i]);
+		unsigned int gen = _hrGen[i];
+		FILETIME last = _hrTime[i];
+		size_t size = (size_t)_texWidth[i] * _texHeight[i] * 4;
+		LeaveCriticalSection(&_hrLock);
+
+		if (!watched) continue;
+		pathDirectory(path, fileDir);
+		if (strcmp(fileDir, dir) != 0) continue;
+
+		WIN32_FILE_ATTRIBUTE_DATA attr;
+		if (!GetFileAttributesExA(path, GetFileExInfoStandard, &attr))
+			continue;
+		if (CompareFileTime(&attr.ftLastWriteTime, &last) <= 0) continue;
+
+		/* a short read means the file is still being written */
+		unsigned char* data = NULL;
+		if (isImagePath(path))
+		{
+			int w, h;
+			data = decodeImage(path, &w, &h);
+			if (data && (size_t)w * h * 4 != size)
+			{
+				free(data);
+				data = NULL;
+			}
+		}
+		else
+		{
+			data = malloc(size);
+			FILE* rFile = data ? fopen(path, "rb") : NULL;
+			size_t read = rFile ? fread(data, 1, size, rFile) : 0;
+			if (rFile) fclose(rFile);
+			if (read != size)
+			{
+				free(data);
+				data = NULL;
+			}
+		}
+		if (data == NULL) continue;
+
+		EnterCriticalSection(&_hrLock);
+		if (_hrGen[i] == gen)
+		{
+			free(_hrPending[i]);
+			_hrPending[i] = data;
+			_hrTime[i] = attr.ftLastWriteTime;
+			data = NULL;
+			InterlockedExchange(&_hrAnyPending, TRUE);
+		}
+		LeaveCriticalSection(&_hrLock);
+
+		free(data);
+	}
 }
 
-static ULONGLONG __lastSwap = 0;
-VAPI void vgSwap(void)
+static DWORD WINAPI hotReloadThread(LPVOID param)
 {
-	/* limit swap time */
-	ULONGLONG currentTime = GetTickCount64();
-	if ((currentTime - __lastSwap) < _swapTime)
+	HANDLE waits[MAXIMUM_WAIT_OBJECTS];
+	static char dirs[MAXIMUM_WAIT_OBJECTS - 1][MAX_PATH];
+	int dirCount = 0;
+	char dir[MAX_PATH];
+
+	while (_hrRunning)
 	{
-		_renderSkip = TRUE;
-		return;
+		/* rebuild the set of watched directories */
+		if (InterlockedExchange(&_hrDirty, FALSE))
+		{
+			for (int i = 0; i < dirCount; i++)
+				FindCloseChangeNotification(waits[i + 1]);
+			dirCount = 0;
+
+			EnterCriticalSection(&_hrLock);
+			for (int i = 0; i < VG_TEXTURES_MAX; i++)
+			{
+				if (_hrPath[i] == NULL) continue;
+				pathDirectory(_hrPath[i], dir);
+
+				int known = FALSE;
+				for (int j = 0; j < dirCount && !known; j++)
+					known = strcmp(dirs[j], dir) == 0;
+				if (known || dirCount >= MAXIMUM_WAIT_OBJECTS - 1) continue;
+
+				HANDLE change = FindFirstChangeNotificationA(dir, FALSE,
+					FILE_NOTIFY_CHANGE_LAST_WRITE);
+				if (change == INVALID_HANDLE_VALUE) continue;
+
+				strcpy(dirs[dirCount], dir);
+				waits[dirCount + 1] = change;
+				dirCount++;
+			}
+			LeaveCriticalSection(&_hrLock);
+		}
+
+		waits[0] = _hrWake;
+		DWORD result = WaitForMultipleObjects(dirCount + 1, waits, FALSE,
+			INFINITE);
+
+		int index = (int)(result - WAIT_OBJECT_0) - 1;
+		if (index < 0 || index >= dirCount) continue;
+
+		/* let the writer finish before reading */
+		FindNextChangeNotification(waits[index + 1]);
+		Sleep(VG_HOTRELOAD_DEBOUNCE);
+		hotReloadScan(dirs[index]);
 	}
 
-	__lastSwap  = currentTime;
-	_renderSkip = FALSE;
+	for (int i = 0; i < dirCount; i++)
+		FindCloseChangeNotification(waits[i + 1]);
 
-	/* perform swap */
-	rsetup();
-	
-	glClearColor(0, 0, 0, 1);
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	return 0;
+}
 
-	glBindTexture(GL_TEXTURE_2D, _texture);
+VAPI void vgUseHotReload(int state)
+{
+	if (state && !_hrRunning)
+	{
+		if (!_hrLockInit)
+		{
+			InitializeCriticalSection(&_hrLock);
+			_hrLockInit = TRUE;
+		}
 
-	glColor4ub(255, 255, 255, 255);
+		_hrWake = CreateEventA(NULL, FALSE, FALSE, NULL);
+		_hrRunning = TRUE;
+		_hrDirty = TRUE;
+		_hrThread = CreateThread(NULL, 0, hotReloadThread, NULL, 0, NULL);
+		if (_hrThread == NULL)
+		{
+			_hrRunning = FALSE;
+			CloseHandle(_hrWake);
+		}
+		return;
+	}
 
-	glEnable(GL_TEXTURE_2D);
-	glBegin(GL_QUADS);
-	glTexCoord2i(0, 0); glVertex2i(0, 0);
-	glTexCoord2i(0, 1); glVertex2i(0, _windowHeight);
-	glTexCoord2i(1, 1); glVertex2i(_windowWidth, _windowHeight);
-	glTexCoord2i(1, 0); glVertex2i(_windowWidth, 0);
-	glEnd();
-	glDisable(GL_TEXTURE_2D);
+	if (!state && _hrRunning)
+	{
+		/* stop watcher, paths are kept for a later restart */
+		InterlockedExchange(&_hrRunning, FALSE);
+		SetEvent(_hrWake);
+		WaitForSingleObject(_hrThread, INFINITE);
+		CloseHandle(_hrThread);
+		CloseHandle(_hrWake);
+		_hrThread = NULL;
+		_hrWake = NULL;
+	}
+}
 
-	SwapBuffers(_deviceContext);
+VAPI int vgHotReloadCount(void)
+{
+	return _hrReloads;
 }
 
-/* BASIC DRAW FUNCTIONS */
+/* ARCHIVE FUNCTIONS */
 
-VAPI void vgColor3(int r, int g, int b)
+#define ARCHIVE_VERSION 1
+#define ARCHIVE_ALIGN   0x10
+
+static unsigned int hashName(const char* name)
 {
-	_colR = r;
-	_colG = g;
-	_colB = b;
-	_colA = 255;
+	/* FNV-1a */
+	unsigned int hash = 2166136261u;
+	for (; *name; name++)
+	{
+		hash ^= (unsigned char)*name;
+		hash *= 16777619u;
+	}
+	return hash;
 }
 
-VAPI void vgColor4(int r, int g, int b, int a)
+static const vgArchiveEntry* archiveFind(vgArchive archive, const char* name)
 {
-	_colR = r;
-	_colG = g;
-	_colB = b;
-	_colA = a;
+	if (archive >= VG_ARCHIVES_MAX || _arcData[archive] == NULL) return NULL;
+
+	const unsigned char* base = _arcData[archive];
+	const vgArchiveHeader* header = (const vgArchiveHeader*)base;
+	const unsigned int* slots = (const unsigned int*)(base +
+		header->tocOffset);
+	const vgArchiveEntry* entries = (const vgArchiveEntry*)(slots +
+		header->slotCount);
+
+	/* open addressing, slots hold entry index + 1 */
+	unsigned int hash = hashName(name);
+	unsigned int mask = header->slotCount - 1;
+	for (unsigned int i = 0; i < header->slotCount; i++)
+	{
+		unsigned int slot = slots[(hash + i) & mask];
+		if (slot == 0) return NULL;
+
+		const vgArchiveEntry* entry = &entries[slot - 1];
+		if (entry->hash == hash && strcmp((const char*)base +
+			((unsigned long long)entry->nameHigh << 32 | entry->nameOffset),
+			name) == 0)
+			return entry;
+	}
+
+	return NULL;
 }
 
-VAPI void vgRect(int x, int y, int w, int h)
+static int archiveValid(const unsigned char* base, unsigned long long size)
 {
-	RENDERSKIP(_useRenderSkip); psetup();
+	/* everything the lookups and loaders read has to be inside the file */
+	const vgArchiveHeader* header = (const vgArchiveHeader*)base;
+	const unsigned int* slots = (const unsigned int*)(base +
+		header->tocOffset);
+	const vgArchiveEntry* entries = (const vgArchiveEntry*)(slots +
+		header->slotCount);
 
-	glBegin(GL_QUADS);
-	glVertex2i(x, y);
-	glVertex2i(x, y + h);
-	glVertex2i(x + w, y + h);
-	glVertex2i(x + w, y);
-	glEnd();
+	for (unsigned int i = 0; i < header->slotCount; i++)
+		if (slots[i] > header->entryCount) return FALSE;
+
+	for (unsigned int i = 0; i < header->entryCount; i++)
+	{
+		const vgArchiveEntry* e = &entries[i];
+		unsigned long long name = (unsigned long long)e->nameHigh << 32 |
+			e->nameOffset;
+		if (name >= size || memchr(base + name, 0, size - name) == NULL ||
+			e->dataOffset > size || e->dataSize > size - e->dataOffset)
+			return FALSE;
+
+		/* the payload has to hold what its type says it does */
+		unsigned long long need = 0;
+		switch (e->type)
+		{
+		case VG_ARCHIVE_TEXTURE:
+			if (e->format >= FORMAT_COUNT || e->w == 0 || e->h == 0 ||
+				e->w > TEXTURE_SIZE_MAX || e->h > TEXTURE_SIZE_MAX ||
+				e->levels == 0 || e->levels > (unsigned int)mipLevels(e->w,
+				e->h))
+				return FALSE;
+			for (unsigned int j = 0; j < e->levels; j++)
+				need += vgFormatSize(e->format, max(1, e->w >> j),
+					max(1, e->h >> j));
+			break;
+
+		case VG_ARCHIVE_SHAPE:
+			need = (unsigned long long)e->w * 2 * sizeof(float) *
+				(e->h ? 2 : 1);
+			break;
+
+		case VG_ARCHIVE_REGION:
+			need = 4 * sizeof(int) + 1;
+			if (e->dataSize >= need &&
+				base[e->dataOffset + e->dataSize - 1] != 0)
+				return FALSE;
+			break;
+		}
+		if (e->dataSize < need) return FALSE;
+	}
+
+	return TRUE;
 }
 
-VAPI void vgLineSize(float size)
+VAPI vgArchive vgOpenArchive(const char* file)
 {
-	_lineW = size;
+	vgArchive archive = VG_INVALID;
+	for (int i = 0; i < VG_ARCHIVES_MAX; i++)
+	{
+		if (_arcData[i] == NULL)
+		{
+			archive = i;
+			break;
+		}
+	}
+	if (archive == VG_INVALID) return VG_INVALID;
+
+	/* one open and one mapping for the whole archive */
+	HANDLE hFile = CreateFileA(file, GENERIC_READ, FILE_SHARE_READ, NULL,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (hFile == INVALID_HANDLE_VALUE) return VG_INVALID;
+
+	LARGE_INTEGER size;
+	HANDLE hMap = NULL;
+	const unsigned char* view = NULL;
+	if (GetFileSizeEx(hFile, &size) &&
+		size.QuadPart >= (LONGLONG)sizeof(vgArchiveHeader))
+	{
+		hMap = CreateFileMappingA(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (hMap) view = MapViewOfFile(hMap, FILE_MAP_READ, 0, 0, 0);
+	}
+
+	/* check header and that the table of contents fits */
+	const vgArchiveHeader* header = (const vgArchiveHeader*)view;
+	int valid = view != NULL && memcmp(header->magic, "VGPK", 4) == 0 &&
+		header->version == ARCHIVE_VERSION && header->slotCount != 0 &&
+		(header->slotCount & (header->slotCount - 1)) == 0 &&
+		header->tocOffset <= (unsigned long long)size.QuadPart &&
+		header->tocOffset + (unsigned long long)header->slotCount * 4 +
+		(unsigned long long)header->entryCount * sizeof(vgArchiveEntry) <=
+		(unsigned long long)size.QuadPart &&
+		archiveValid(view, size.QuadPart);
+
+	if (!valid)
+	{
+		if (view) UnmapViewOfFile(view);
+		if (hMap) CloseHandle(hMap);
+		CloseHandle(hFile);
+		return VG_INVALID;
+	}
+
+	_arcFile[archive] = hFile;
+	_arcMapping[archive] = hMap;
+	_arcData[archive] = view;
+	_arcSize[archive] = size.QuadPart;
+
+	return archive;
 }
 
-VAPI void vgLine(int x1, int y1, int x2, int y2)
+VAPI void vgCloseArchive(vgArchive archive)
 {
-	RENDERSKIP(_useRenderSkip); psetup();
-
-	glLineWidth(_lineW);
+	if (archive >= VG_ARCHIVES_MAX || _arcData[archive] == NULL) return;
 
-	glBegin(GL_LINES);
-	glVertex2i(x1, y1);
-	glVertex2i(x2, y2);
-	glEnd();
+	UnmapViewOfFile(_arcData[archive]);
+	CloseHandle(_arcMapping[archive]);
+	CloseHandle(_arcFile[archive]);
+	_arcData[archive] = NULL;
 }
 
-VAPI void vgPointSize(float size)
+VAPI int vgArchiveContains(vgArchive archive, const char* name)
 {
-	_pointW = size;
+	return archiveFind(archive, name) != NULL;
 }
 
-VAPI void vgPoint(int x, int y)
+VAPI vgTexture vgArchiveLoadTexture(vgArchive archive, const char* name,
+	int linear, int repeat)
 {
-	RENDERSKIP(_useRenderSkip); psetup();
+	const vgArchiveEntry* entry = archiveFind(archive, name);
+	if (entry == NULL || entry->type != VG_ARCHIVE_TEXTURE) return VG_INVALID;
+
+	const unsigned char* data = _arcData[archive] + entry->dataOffset;
+	int w = entry->w, h = entry->h, format = entry->format;
+
+	/* anything that needs the texels on CPU goes the long way */
+	if (format == VG_FORMAT_RGBA8 && entry->levels == 1)
+		return vgCreateTextureFormat(w, h, linear, repeat, format,
+			(void*)data);
+	if (fmtCompressed(format) && !GLEW_EXT_texture_compression_s3tc)
+		return vgCreateTextureCompressed(w, h, linear, repeat, format,
+			(void*)data);
+
+	/* texels are stored ready to upload, level after level, and the */
+	/* upload builds whatever the archive is missing */
+	int mipmap = (linear == VG_LINEAR_MIPMAP || linear == VG_NEAREST_MIPMAP);
+	int levels = mipmap ? mipLevels(w, h) : 1;
+	vgTexture handle = reserveTexture(w, h, levels, format);
+	if (handle == VG_INVALID) return VG_INVALID;
+
+	/* replay only gets the blocks, other formats need RGBA8 it lacks */
+	if (fmtCompressed(format))
+	{
+		TRACE_DATA(VG_TRACE_CREATE_TEXTURE_COMPRESSED, data,
+			vgFormatSize(format, w, h), "iiiiii", w, h, linear, repeat,
+			format, handle);
+	}
+	else
+	{
+		TRACE(VG_TRACE_CREATE_TEXTURE, "iiiiii", w, h, linear, repeat, format,
+			handle);
+	}
 
-	glPointSize(_pointW);
-	
-	glBegin(GL_POINTS);
-	glVertex2i(x, y);
-	glEnd();
+	textureUpload(handle, linear, repeat,
+		max(1, min((int)entry->levels, levels)), data);
+	return handle;
 }
 
-VAPI void vgViewport(int x, int y, int w, int h)
+VAPI vgShape vgArchiveLoadShape(vgArchive archive, const char* name)
 {
-	_vpx = x;
-	_vpy = y;
-	_vpw = w;
-	_vph = h;
+	const vgArchiveEntry* entry = archiveFind(archive, name);
+	if (entry == NULL || entry->type != VG_ARCHIVE_SHAPE) return VG_INVALID;
+
+	/* positions, then texture coordinates if h is set */
+	float* data = (float*)(_arcData[archive] + entry->dataOffset);
+	if (entry->h)
+		return vgCompileShapeTextured(data, data + entry->w * 2, entry->w);
+	return vgCompileShape(data, entry->w);
 }
 
-VAPI void vgViewportReset(void)
+VAPI const void* vgArchiveGetData(vgArchive archive, const char* name,
+	int* type, int* size)
 {
-	_vpx = 0;
-	_vpy = 0;
-	_vpw = _resW;
-	_vph = _resH;
+	const vgArchiveEntry* entry = archiveFind(archive, name);
+	if (entry == NULL) return NULL;
+
+	if (type) *type = entry->type;
+	if (size) *size = (int)entry->dataSize;
+	return _arcData[archive] + entry->dataOffset;
 }
 
-/* FLOAT VARIANTS */
+VAPI const char* vgArchiveGetRegion(vgArchive archive, const char* name,
+	int* x, int* y, int* w, int* h)
+{
+	const vgArchiveEntry* entry = archiveFind(archive, name);
+	if (entry == NULL || entry->type != VG_ARCHIVE_REGION) return NULL;
+
+	/* rectangle in texels, then the name of the atlas texture */
+	const int* rect = (const int*)(_arcData[archive] + entry->dataOffset);
+	if (x) *x = rect[0];
+	if (y) *y = rect[1];
+	if (w) *w = rect[2];
+	if (h) *h = rect[3];
+	return (const char*)(rect + 4);
+}
 
-VAPI void vgRectf(float x, float y, float w, float h)
+static void archiveAdd(const char* name, const vgArchiveEntry* entry,
+	const void* data, const void* data2, size_t size2)
 {
-	RENDERSKIP(_useRenderSkip); psetup();
+	if (_arcOut == NULL) return;
 
-	glBegin(GL_QUADS);
-	glVertex2f(x, y);
-	glVertex2f(x, y + h);
-	glVertex2f(x + w, y + h);
-	glVertex2f(x + w, y);
-	glEnd();
+	if (_arcEntryCount >= _arcEntryCap)
+	{
+		int cap = max(0x40, _arcEntryCap * 2);
+		vgArchiveEntry* entries = realloc(_arcEntries,
+			cap * sizeof(vgArchiveEntry));
+		char** names = realloc(_arcNames, cap * sizeof(char*));
+		if (entries) _arcEntries = entries;
+		if (names) _arcNames = names;
+		if (entries == NULL || names == NULL) return;
+		_arcEntryCap = cap;
+	}
+
+	char* copy = malloc(strlen(name) + 1);
+	if (copy == NULL) return;
+	strcpy(copy, name);
+
+	/* blobs are aligned so mapped data can be read with SIMD loads */
+	long long pos = _ftelli64(_arcOut);
+	while (pos % ARCHIVE_ALIGN) { fputc(0, _arcOut); pos++; }
+
+	vgArchiveEntry* out = &_arcEntries[_arcEntryCount];
+	*out = *entry;
+	out->hash = hashName(name);
+	out->dataOffset = pos;
+	fwrite(data, 1, (size_t)entry->dataSize - size2, _arcOut);
+	if (data2) fwrite(data2, 1, size2, _arcOut);
+
+	_arcNames[_arcEntryCount] = copy;
+	_arcEntryCount++;
 }
 
-VAPI void vgLinef(float x1, float y1, float x2, float y2)
+VAPI int vgArchiveBegin(const char* file)
 {
-	RENDERSKIP(_useRenderSkip); psetup();
+	if (_arcOut != NULL) return VG_FALSE;
 
-	glLineWidth(_lineW);
+	_arcOut = fopen(file, "wb");
+	if (_arcOut == NULL) return VG_FALSE;
 
-	glBegin(GL_LINES);
-	glVertex2f(x1, y1);
-	glVertex2f(x2, y2);
-	glEnd();
+	/* header is rewritten by vgArchiveEnd */
+	vgArchiveHeader header = { 0 };
+	fwrite(&header, sizeof(header), 1, _arcOut);
+	_arcEntryCount = 0;
+
+	return VG_TRUE;
 }
 
-VAPI void vgPointf(float x, float y)
+VAPI void vgArchiveAddTexture(const char* name, int w, int h, int format,
+	int levels, const void* data)
 {
-	RENDERSKIP(_useRenderSkip); psetup();
-
-	glPointSize(_pointW);
+	vgArchiveEntry entry = { 0 };
+	entry.type = VG_ARCHIVE_TEXTURE;
+	entry.w = w;
+	entry.h = h;
+	entry.format = format;
+	entry.levels = max(1, levels);
+
+	for (int i = 0; i < (int)entry.levels; i++)
+		entry.dataSize += vgFormatSize(format, max(1, w >> i),
+			max(1, h >> i));
+
+	archiveAdd(name, &entry, data, NULL, 0);
+}
 
-	glBegin(GL_POINTS);
-	glVertex2f(x, y);
-	glEnd();
+VAPI void vgArchiveAddShape(const char* name, float* f2d_data,
+	float* t2d_data, int size)
+{
+	vgArchiveEntry entry = { 0 };
+	size_t bytes = (size_t)size * 2 * sizeof(float);
+	entry.type = VG_ARCHIVE_SHAPE;
+	entry.w = size;
+	entry.h = t2d_data != NULL;
+	entry.dataSize = t2d_data ? bytes * 2 : bytes;
+
+	archiveAdd(name, &entry, f2d_data, t2d_data, t2d_data ? bytes : 0);
 }
 
-/* ADVANCED DRAW FUNCTIONS */
+VAPI void vgArchiveAddRegion(const char* name, const char* atlas, int x,
+	int y, int w, int h)
+{
+	int rect[4] = { x, y, w, h };
+	size_t atlasSize = strlen(atlas) + 1;
 
-VAPI vgTexture vgCreateTexture(int w, int h, int linear, int repeat,
-	void* data)
+	vgArchiveEntry entry = { 0 };
+	entry.type = VG_ARCHIVE_REGION;
+	entry.w = w;
+	entry.h = h;
+	entry.dataSize = sizeof(rect) + atlasSize;
+
+	archiveAdd(name, &entry, rect, atlas, atlasSize);
+}
+
+VAPI int vgArchiveEnd(void)
 {
-	vgTexture handle = findFreeTexture();
+	if (_arcOut == NULL) return VG_FALSE;
 
-	glGenTextures(1, &_texBuffer[handle]);
-	glBindTexture(GL_TEXTURE_2D, _texBuffer[handle]);
+	/* table at least twice the entry count keeps probes short */
+	unsigned int slotCount = 1;
+	while (slotCount < (unsigned int)_arcEntryCount * 2) slotCount <<= 1;
 
-	glTexImage2D(GL_TEXTURE_2D, NULL, GL_RGBA, w, h, NULL, GL_RGBA,
-		GL_UNSIGNED_BYTE, data);
+	unsigned int* slots = calloc(slotCount, sizeof(unsigned int));
+	int ok = slots != NULL;
 
-	glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+	/* names go after the table, patch their offsets first */
+	long long pos = _ftelli64(_arcOut);
+	while (pos % ARCHIVE_ALIGN) { fputc(0, _arcOut); pos++; }
+	unsigned long long tocOffset = pos;
+	unsigned long long nameOffset = tocOffset + slotCount * 4ull +
+		_arcEntryCount * (unsigned long long)sizeof(vgArchiveEntry);
 
-	switch (repeat)
+	for (int i = 0; ok && i < _arcEntryCount; i++)
 	{
-	case 0:
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
-		break;
+		_arcEntries[i].nameOffset = (unsigned int)nameOffset;
+		_arcEntries[i].nameHigh = (unsigned int)(nameOffset >> 32);
+		nameOffset += strlen(_arcNames[i]) + 1;
 
-	case 1:
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-		break;
+		/* later entries with the same name replace earlier ones */
+		unsigned int mask = slotCount - 1;
+		for (unsigned int j = 0; j < slotCount; j++)
+		{
+			unsigned int* slot = &slots[(_arcEntries[i].hash + j) & mask];
+			if (*slot != 0 && strcmp(_arcNames[*slot - 1], _arcNames[i]))
+				continue;
+			*slot = i + 1;
+			break;
+		}
+	}
 
-	default:
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
-		break;
+	if (ok)
+	{
+		fwrite(slots, sizeof(unsigned int), slotCount, _arcOut);
+		fwrite(_arcEntries, sizeof(vgArchiveEntry), _arcEntryCount, _arcOut);
+		for (int i = 0; i < _arcEntryCount; i++)
+			fwrite(_arcNames[i], 1, strlen(_arcNames[i]) + 1, _arcOut);
+
+		vgArchiveHeader header = { { 'V', 'G', 'P', 'K' }, ARCHIVE_VERSION,
+			_arcEntryCount, slotCount, tocOffset };
+		_fseeki64(_arcOut, 0, SEEK_SET);
+		fwrite(&header, sizeof(header), 1, _arcOut);
+	}
+
+	ok = ok && !ferror(_arcOut);
+	fclose(_arcOut);
+	_arcOut = NULL;
+
+	for (int i = 0; i < _arcEntryCount; i++)
+		free(_arcNames[i]);
+	free(slots);
+	free(_arcEntries);
+	free(_arcNames);
+	_arcEntries = NULL;
+	_arcNames = NULL;
+	_arcEntryCount = 0;
+	_arcEntryCap = 0;
+
+	return ok ? VG_TRUE : VG_FALSE;
+}
+
+/* UPLOAD THREAD FUNCTIONS */
+
+static void uploadJob(int handle)
+{
+	EnterCriticalSection(&_upLock);
+	unsigned char* data = _upData[handle];
+	int cancel = _upCancel[handle];
+	_upData[handle] = NULL;
+	LeaveCriticalSection(&_upLock);
+
+	GLuint name = 0;
+	GLsync fence = NULL;
+	if (!cancel)
+	{
+		glGenTextures(1, &name);
+		glBindTexture(GL_TEXTURE_2D, name);
+		PROFILE_BEGIN("texture upload");
+		if (_upReady[handle])
+			uploadReady(_texWidth[handle], _texHeight[handle],
+				_texLevels[handle], _texFormat[handle], FALSE,
+				_upReady[handle], data);
+		else
+			uploadMipmaps(_texWidth[handle], _texHeight[handle],
+				_texLevels[handle], _texFormat[handle], FALSE, data);
+		PROFILE_END();
+		texParams(_upLinear[handle], _upRepeat[handle]);
+
+		/* the render context may only use it once the GPU has it */
+		if (GLEW_ARB_sync)
+		{
+			fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			glFlush();
+		}
+		else glFinish();
 	}
+	free(data);
+
+	EnterCriticalSection(&_upLock);
+	_upName[handle] = name;
+	_upFence[handle] = fence;
+	_upDone[handle] = TRUE;
+	LeaveCriticalSection(&_upLock);
 
-	switch (linear)
+	InterlockedExchange(&_upAnyDone, TRUE);
+}
+
+static DWORD WINAPI uploadThread(LPVOID param)
+{
+	wglMakeCurrent(_deviceContext, _upContext);
+
+	/* drain the queue fully even when asked to stop */
+	for (;;)
 	{
-	case 0:
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-		break;
+		EnterCriticalSection(&_upLock);
+		int handle = -1;
+		if (_upQueueCount > 0)
+		{
+			handle = _upQueue[_upQueueHead];
+			_upQueueHead = (_upQueueHead + 1) % VG_TEXTURES_MAX;
+			_upQueueCount--;
+		}
+		LeaveCriticalSection(&_upLock);
 
-	case 1:
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		break;
+		if (handle >= 0)
+		{
+			uploadJob(handle);
+			continue;
+		}
 
-	default:
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-		break;
+		if (!_upRunning) break;
+		WaitForSingleObject(_upWake, INFINITE);
 	}
 
-	return handle;
+	wglMakeCurrent(NULL, NULL);
+	return 0;
 }
 
-VAPI void vgDestroyTexture(vgTexture tex)
+VAPI void vgUseUploadThread(int state)
 {
-	glDeleteTextures(1, &_texBuffer[tex]);
-	_texBuffer[tex] = NULL;
-	_texCount--;
+	if (state && !_upRunning)
+	{
+		if (!_upLockInit)
+		{
+			InitializeCriticalSection(&_upLock);
+			_upLockInit = TRUE;
+		}
+
+		/* sharing has to be set up before the new context owns anything */
+		_upContext = wglCreateContext(_deviceContext);
+		if (_upContext == NULL || !wglShareLists(_glContext, _upContext))
+		{
+			if (_upContext) wglDeleteContext(_upContext);
+			_upContext = NULL;
+			return;
+		}
+
+		_upWake = CreateEventA(NULL, FALSE, FALSE, NULL);
+		_upRunning = TRUE;
+		_upThread = CreateThread(NULL, 0, uploadThread, NULL, 0, NULL);
+		if (_upThread == NULL)
+		{
+			_upRunning = FALSE;
+			CloseHandle(_upWake);
+			wglDeleteContext(_upContext);
+			_upContext = NULL;
+		}
+		return;
+	}
+
+	if (!state && _upRunning)
+	{
+		/* thread finishes what is queued, then exits */
+		InterlockedExchange(&_upRunning, FALSE);
+		SetEvent(_upWake);
+		WaitForSingleObject(_upThread, INFINITE);
+		CloseHandle(_upThread);
+		CloseHandle(_upWake);
+		wglDeleteContext(_upContext);
+		_upThread = NULL;
+		_upWake = NULL;
+		_upContext = NULL;
+
+		/* everything is flushed, wait it out and publish */
+		for (int i = 0; i < VG_TEXTURES_MAX; i++)
+		{
+			if (!_upDone[i] || _upFence[i] == NULL) continue;
+			glClientWaitSync(_upFence[i], GL_SYNC_FLUSH_COMMANDS_BIT,
+				GL_TIMEOUT_IGNORED);
+		}
+		InterlockedExchange(&_upAnyDone, TRUE);
+		uploadPublish();
+	}
 }
 
-VAPI void vgUseTexture(vgTexture target)
+VAPI int vgTextureReady(vgTexture tex)
 {
-	_useTex = target;
+	VALIDATE_OR(VG_FALSE, tex < VG_TEXTURES_MAX, VG_VALIDATE_BOUNDS,
+		"texture %d", tex);
+
+	return _texBuffer[tex] != 0 && !_texPending[tex];
 }
 
-VAPI void vgTextureFilter(int r, int g, int b, int a)
+VAPI int vgUploadsPending(void)
 {
-	_tcolR = r;
-	_tcolG = g;
-	_tcolB = b;
-	_tcolA = a;
+	return _upOutstanding;
 }
 
-VAPI void vgTextureFilterReset(void)
+VAPI void vgFinishUploads(void)
 {
-	_tcolR = 255;
-	_tcolG = 255;
-	_tcolB = 255;
-	_tcolA = 255;
+	/* for loading screens, block until everything queued is usable */
+	while (_upRunning && _upOutstanding > 0)
+	{
+		uploadPublish();
+		if (_upOutstanding > 0) Sleep(1);
+	}
 }
 
-VAPI void vgRectTexture(int x, int y, int w, int h)
-{
-	RENDERSKIP(_useRenderSkip); psetup();
+/* CAPTURE FUNCTIONS */
 
-	glBindTexture(GL_TEXTURE_2D, _texBuffer[_useTex]);
-	glColor4ub(_tcolR, _tcolG, _tcolB, _tcolA);
+static void captureWrite(const unsigned char* pixels)
+{
+	int w = _capW, h = _capH;
+	size_t plane = (size_t)w * h;
 
-	glEnable(GL_TEXTURE_2D);
+	if (_capFormat == VG_CAPTURE_SHARED)
+	{
+		/* readers check a slot's sequence before and after using it */
+		long long seq = _capShared->latest + 1;
+		int slot = (int)(seq % VG_SHARED_SLOTS);
+		unsigned char* dst = (unsigned char*)_capShared +
+			_capShared->dataOffset + (size_t)slot * _capShared->slotSize;
+
+		InterlockedExchange64(&_capShared->sequence[slot], -1);
+		for (int y = 0; y < h; y++)
+			memcpy(dst + (size_t)y * _capShared->stride,
+				pixels + (size_t)(h - 1 - y) * w * 4, (size_t)w * 4);
+		InterlockedExchange64(&_capShared->sequence[slot], seq);
+		InterlockedExchange64(&_capShared->latest, seq);
+
+		/* a full semaphore means the consumer is behind, that's fine */
+		ReleaseSemaphore(_capSignal, 1, NULL);
+		return;
+	}
 
-	glBegin(GL_QUADS);
-	glTexCoord2i(0, 0); glVertex2i(x, y);
-	glTexCoord2i(0, 1); glVertex2i(x, y + h);
-	glTexCoord2i(1, 1); glVertex2i(x + w, y + h);
-	glTexCoord2i(1, 0); glVertex2i(x + w, y);
-	glEnd();
+	if (_capFormat == VG_CAPTURE_Y4M)
+	{
+		/* full resolution chroma, BT.601 studio range */
+		unsigned char* py = _capOut;
+		unsigned char* pu = py + plane;
+		unsigned char* pv = pu + plane;
+		for (int y = h - 1; y >= 0; y--)
+		{
+			const unsigned char* src = pixels + (size_t)y * w * 4;
+			for (int x = 0; x < w; x++, src += 4)
+			{
+				int r = src[0], g = src[1], b = src[2];
+				*py++ = (unsigned char)
+					(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+				*pu++ = (unsigned char)
+					(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+				*pv++ = (unsigned char)
+					(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+			}
+		}
 
-	glDisable(GL_TEXTURE_2D);
-}
+		fputs("FRAME\n", _capFile);
+		fwrite(_capOut, 1, plane * 3, _capFile);
+		return;
+	}
 
-VAPI void vgRectTextureOffset(int x, int y, int w, int h, float s, float t)
-{
-	RENDERSKIP(_useRenderSkip); psetup();
+	/* pixel buffers are bottom-up RGBA, streams are top-down RGB */
+	unsigned char* dst = _capOut;
+	for (int y = h - 1; y >= 0; y--)
+	{
+		const unsigned char* src = pixels + (size_t)y * w * 4;
+		for (int x = 0; x < w; x++, src += 4, dst += 3)
+		{
+			dst[0] = src[0];
+			dst[1] = src[1];
+			dst[2] = src[2];
+		}
+	}
 
-	glBindTexture(GL_TEXTURE_2D, _texBuffer[_useTex]);
-	glColor4ub(_tcolR, _tcolG, _tcolB, _tcolA);
+	if (_capFormat == VG_CAPTURE_RAW)
+	{
+		fwrite(_capOut, 1, plane * 3, _capFile);
+		return;
+	}
 
-	/* apply texture coordinate offsets */
-	glMatrixMode(GL_TEXTURE);
-	glLoadIdentity();
-	glTranslatef(s, t, 0);
+	/* only tiles that differ from the previous frame are written */
+	int tile = VG_CAPTURE_TILE;
+	int tilesX = (w + tile - 1) / tile;
+	int tilesY = (h + tile - 1) / tile;
+	size_t pitch = (size_t)w * 3;
+	unsigned int changed = 0;
+	for (int ty = 0; ty < tilesY; ty++)
+	{
+		for (int tx = 0; tx < tilesX; tx++)
+		{
+			int tw = min(tile, w - tx * tile);
+			int th = min(tile, h - ty * tile);
+			size_t offset = (size_t)ty * tile * pitch + (size_t)tx * tile * 3;
 
-	glMatrixMode(GL_MODELVIEW);
+			int diff = FALSE;
+			for (int r = 0; r < th && !diff; r++)
+				diff = memcmp(_capOut + offset + r * pitch,
+					_capPrev + offset + r * pitch, tw * 3) != 0;
 
-	glEnable(GL_TEXTURE_2D);
+			_capChanged[ty * tilesX + tx] = diff;
+			changed += diff;
+		}
+	}
 
-	glBegin(GL_QUADS);
-	glTexCoord2f(0, 0); glVertex2i(x, y);
-	glTexCoord2f(0, 1); glVertex2i(x, y + h);
-	glTexCoord2f(1, 1); glVertex2i(x + w, y + h);
-	glTexCoord2f(1, 0); glVertex2i(x + w, y);
-	glEnd();
+	fwrite(&changed, sizeof(changed), 1, _capFile);
+	for (int ty = 0; ty < tilesY; ty++)
+	{
+		for (int tx = 0; tx < tilesX; tx++)
+		{
+			if (!_capChanged[ty * tilesX + tx]) continue;
+
+			int tw = min(tile, w - tx * tile);
+			int th = min(tile, h - ty * tile);
+			size_t offset = (size_t)ty * tile * pitch + (size_t)tx * tile * 3;
+			unsigned short pos[2] = { (unsigned short)tx, (unsigned short)ty };
+			fwrite(pos, sizeof(pos), 1, _capFile);
+			for (int r = 0; r < th; r++)
+				fwrite(_capOut + offset + r * pitch, 1, tw * 3, _capFile);
+		}
+	}
 
-	glDisable(GL_TEXTURE_2D);
+	/* this frame is what the next one is compared against */
+	unsigned char* swap = _capPrev;
+	_capPrev = _capOut;
+	_capOut = swap;
 }
 
-VAPI vgShape vgCompileShape(float* f2d_data, int size)
+static DWORD WINAPI captureThread(LPVOID param)
 {
-	vgShape handle = findFreeShape();
+	/* drain the queue fully even when asked to stop */
+	for (;;)
+	{
+		EnterCriticalSection(&_capLock);
+		int slot = -1;
+		if (_capQueueCount > 0)
+		{
+			slot = _capQueue[_capQueueHead];
+			_capQueueHead = (_capQueueHead + 1) % VG_CAPTURE_RING;
+			_capQueueCount--;
+		}
+		LeaveCriticalSection(&_capLock);
 
-	_shapeBuffer[handle] =  glGenLists(1);
+		if (slot >= 0)
+		{
+			PROFILE_BEGIN("capture write");
+			captureWrite(_capPixels[slot]);
+			PROFILE_END();
+			InterlockedIncrement(&_capWritten);
+			InterlockedExchange(&_capState[slot], CAPTURE_WRITTEN);
+			continue;
+		}
 
-	glNewList(_shapeBuffer[handle], GL_COMPILE);
-	glBegin(GL_POLYGON);
-	for (int i = 0; i < size * 2; i += 2)
-	{
-		glVertex2f(f2d_data[i], f2d_data[i + 1]);
+		if (!_capRunning) break;
+		WaitForSingleObject(_capWake, INFINITE);
 	}
-	glEnd();
-	glEndList();
 
-	return handle;
+	return 0;
 }
 
-VAPI vgShape vgCompileShapeTextured(float* f2d_data, float* t2d_data,
-	int size)
+static void captureRelease(void)
 {
-	vgShape handle = findFreeShape();
-
-	_shapeBuffer[handle] = glGenLists(1);
+	glDeleteBuffers(VG_CAPTURE_RING, _capBuffer);
+	for (int i = 0; i < VG_CAPTURE_RING; i++)
+	{
+		if (_capFence[i]) glDeleteSync(_capFence[i]);
+		_capBuffer[i] = 0;
+		_capFence[i] = NULL;
+		_capPixels[i] = NULL;
+		_capState[i] = CAPTURE_FREE;
+	}
 
-	glNewList(_shapeBuffer[handle], GL_COMPILE);
-	glBegin(GL_POLYGON);
-	for (int i = 0; i < size * 2; i += 2)
+	/* consumers holding the mapping see the stream end */
+	if (_capShared)
 	{
-		glTexCoord2f(t2d_data[i], t2d_data[i + 1]);
-		glVertex2f(f2d_data[i], f2d_data[i + 1]);
+		InterlockedExchange(&_capShared->closed, TRUE);
+		ReleaseSemaphore(_capSignal, 1, NULL);
+		UnmapViewOfFile(_capShared);
 	}
-	glEnd();
-	glEndList();
+	if (_capSignal) CloseHandle(_capSignal);
+	if (_capMapping) CloseHandle(_capMapping);
+	_capShared = NULL;
+	_capSignal = NULL;
+	_capMapping = NULL;
+
+	if (_capFile) fclose(_capFile);
+	free(_capOut);
+	free(_capPrev);
+	free(_capChanged);
+	_capFile = NULL;
+	_capOut = NULL;
+	_capPrev = NULL;
+	_capChanged = NULL;
+}
 
-	return handle;
+static int captureShare(const char* name)
+{
+	/* slots start on page boundaries so consumers can upload in place */
+	unsigned int stride = _capW * 4;
+	unsigned int slotSize = (stride * _capH + 0xFFF) & ~0xFFF;
+	unsigned int offset = (sizeof(vgSharedFrames) + 0xFFF) & ~0xFFF;
+	unsigned long long size = offset +
+		(unsigned long long)slotSize * VG_SHARED_SLOTS;
+
+	_capMapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL,
+		PAGE_READWRITE, (DWORD)(size >> 32), (DWORD)size, name);
+	if (_capMapping == NULL) return FALSE;
+
+	/* a stale mapping that is too small fails here */
+	_capShared = MapViewOfFile(_capMapping, FILE_MAP_ALL_ACCESS, 0, 0,
+		(SIZE_T)size);
+	if (_capShared == NULL) return FALSE;
+
+	char signal[MAX_PATH];
+	snprintf(signal, sizeof(signal), "%s.frame", name);
+	_capSignal = CreateSemaphoreA(NULL, 0, VG_SHARED_SLOTS, signal);
+	if (_capSignal == NULL) return FALSE;
+
+	_capShared->version = 1;
+	_capShared->width = _capW;
+	_capShared->height = _capH;
+	_capShared->stride = stride;
+	_capShared->slots = VG_SHARED_SLOTS;
+	_capShared->slotSize = slotSize;
+	_capShared->dataOffset = offset;
+	_capShared->closed = FALSE;
+	_capShared->latest = 0;
+	for (int i = 0; i < VG_SHARED_SLOTS; i++)
+		_capShared->sequence[i] = 0;
+
+	/* the magic goes last, readers that see it see the rest */
+	MemoryBarrier();
+	memcpy(_capShared->magic, "VGSF", 4);
+	return TRUE;
 }
 
-VAPI void vgDrawShape(vgShape shape, float x, float y, float r, float s)
+VAPI int vgStartCapture(const char* file, int format, int every, int fps)
 {
-	RENDERSKIP(_useRenderSkip); psetup();
+	if (_capRunning || format < VG_CAPTURE_RAW || format > VG_CAPTURE_SHARED)
+		return VG_FALSE;
+
+	_capW = _resW;
+	_capH = _resH;
+	_capFormat = format;
+	_capEvery = max(every, 1);
+	size_t plane = (size_t)_capW * _capH;
+	int tiles = ((_capW + VG_CAPTURE_TILE - 1) / VG_CAPTURE_TILE) *
+		((_capH + VG_CAPTURE_TILE - 1) / VG_CAPTURE_TILE);
+
+	/* shared export writes straight into the mapping */
+	if (format == VG_CAPTURE_SHARED)
+	{
+		if (!captureShare(file))
+		{
+			captureRelease();
+			return VG_FALSE;
+		}
+	}
+	else
+	{
+		_capFile = fopen(file, "wb");
+		if (_capFile == NULL) return VG_FALSE;
+		setvbuf(_capFile, NULL, _IOFBF, 1 << 20);
 
-	glTranslatef(x, y, 0); /* lastly, transalate */
-	glRotatef(r, 0, 0, 1); /* second, rotate */
-	glScalef(s, s, 1); /* first, scale */
+		/* delta streams compare against a black first frame */
+		_capOut = malloc(plane * 3);
+		if (format == VG_CAPTURE_DELTA)
+		{
+			_capPrev = calloc(plane, 3);
+			_capChanged = malloc(tiles);
+		}
+		if (_capOut == NULL || (format == VG_CAPTURE_DELTA &&
+			(_capPrev == NULL || _capChanged == NULL)))
+		{
+			captureRelease();
+			return VG_FALSE;
+		}
+	}
 
-	glCallList(_shapeBuffer[shape]);
-}
+	if (format == VG_CAPTURE_Y4M)
+		fprintf(_capFile, "YUV4MPEG2 W%d H%d F%d:%d Ip A1:1 C444\n",
+			_capW, _capH, fps > 0 ? fps : 60, _capEvery);
+	if (format == VG_CAPTURE_DELTA)
+	{
+		unsigned int header[5] = { 0, 1, _capW, _capH, VG_CAPTURE_TILE };
+		memcpy(header, "VGCD", 4);
+		fwrite(header, sizeof(header), 1, _capFile);
+	}
 
-VAPI void vgDrawShapeTextured(vgShape shape, float x, float y, float r,
-	float s)
-{
-	RENDERSKIP(_useRenderSkip); psetup();
+	glGenBuffers(VG_CAPTURE_RING, _capBuffer);
+	for (int i = 0; i < VG_CAPTURE_RING; i++)
+	{
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, _capBuffer[i]);
+		glBufferData(GL_PIXEL_PACK_BUFFER, plane * 4, NULL, GL_STREAM_READ);
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
 
-	glTranslatef(x, y, 0); /* lastly, transalate */
-	glRotatef(r, 0, 0, 1); /* second, rotate */
-	glScalef(s, s, 1); /* first, scale */
+	if (!_capLockInit)
+	{
+		InitializeCriticalSection(&_capLock);
+		_capLockInit = TRUE;
+	}
 
-	glBindTexture(GL_TEXTURE_2D, _texBuffer[_useTex]);
-	glColor4ub(_tcolR, _tcolG, _tcolB, _tcolA);
+	_capSwaps = 0;
+	_capIssued = 0;
+	_capMapped = 0;
+	_capWritten = 0;
+	_capDropped = 0;
+	_capQueueHead = 0;
+	_capQueueCount = 0;
+
+	_capWake = CreateEventA(NULL, FALSE, FALSE, NULL);
+	_capRunning = TRUE;
+	_capThread = CreateThread(NULL, 0, captureThread, NULL, 0, NULL);
+	if (_capThread == NULL)
+	{
+		_capRunning = FALSE;
+		CloseHandle(_capWake);
+		_capWake = NULL;
+		captureRelease();
+		return VG_FALSE;
+	}
 
-	glEnable(GL_TEXTURE_2D);
-	glCallList(_shapeBuffer[shape]);
-	glDisable(GL_TEXTURE_2D);
+	return VG_TRUE;
 }
 
-VAPI void vgRenderScale(float scale)
+VAPI void vgStopCapture(void)
 {
-	_rScale = scale;
+	if (!_capRunning) return;
+
+	/* frames already read back still make it into the file */
+	captureCollect(TRUE);
+
+	InterlockedExchange(&_capRunning, FALSE);
+	SetEvent(_capWake);
+	WaitForSingleObject(_capThread, INFINITE);
+	CloseHandle(_capThread);
+	CloseHandle(_capWake);
+	_capThread = NULL;
+	_capWake = NULL;
+
+	/* unmap what the writer handed back, then free everything */
+	captureCollect(FALSE);
+	captureRelease();
 }
 
-VAPI void vgUseRenderScaling(int value) 
+VAPI int vgCaptureFrames(void)
 {
-	_useRScale = value;
+	return _capWritten;
 }
 
-VAPI void vgRenderOffset(float x, float y)
+VAPI int vgCaptureDropped(void)
 {
-	_rOffsetX = x;
-	_rOffsetY = y;
+	return _capDropped;
 }
 
-VAPI void vgUseRenderOffset(int value)
+/* SCREENSHOT FUNCTIONS */
+
+#define ZHASH_BITS 15
+#define ZWINDOW    0x8000
+#define ZCHAIN_MAX 0x20
+
+/* deflate output, bits are packed least significant first */
+typedef struct zWriter
 {
-	_useROffset = value;
+	unsigned char* data;
+	size_t size;
+	size_t cap;
+	unsigned int bits;
+	int count;
+	int failed;
+} zWriter;
+
+static void zPut(zWriter* z, unsigned int value, int count)
+{
+	z->bits |= value << z->count;
+	z->count += count;
+	while (z->count >= 8)
+	{
+		if (z->size == z->cap)
+		{
+			size_t cap = z->cap * 2 + 0x1000;
+			unsigned char* data = realloc(z->data, cap);
+			if (data == NULL) z->failed = TRUE;
+			else
+			{
+				z->data = data;
+				z->cap = cap;
+			}
+		}
+		if (!z->failed) z->data[z->size++] = (unsigned char)z->bits;
+		z->bits >>= 8;
+		z->count -= 8;
+	}
 }
 
-VAPI void vgRenderLayer(float layer)
+static inline void zLiteral(zWriter* z, int v)
 {
-	_layer = min(0, -layer);
+	/* fixed huffman codes, huffman codes go most significant first */
+	if (v < 144) zPut(z, bitReverse(0x30 + v, 8), 8);
+	else if (v < 256) zPut(z, bitReverse(0x190 + v - 144, 9), 9);
+	else if (v < 280) zPut(z, bitReverse(v - 256, 7), 7);
+	else zPut(z, bitReverse(0xC0 + v - 280, 8), 8);
 }
 
-VAPI int vgCheckIfViewable(float x, float y, float extra)
+static inline void zMatch(zWriter* z, int len, int dist)
 {
-	/* undo scale and transform */
-	if (_useROffset)
+	int l = 0;
+	while (l < 28 && _zLenBase[l + 1] <= len) l++;
+	zLiteral(z, 257 + l);
+	zPut(z, len - _zLenBase[l], _zLenExtra[l]);
+
+	int d = 0;
+	while (d < 29 && _zDistBase[d + 1] <= dist) d++;
+	zPut(z, bitReverse(d, 5), 5);
+	zPut(z, dist - _zDistBase[d], _zDistExtra[d]);
+}
+
+static inline unsigned int zHash(const unsigned char* p)
+{
+	unsigned int v = p[0] | (p[1] << 8) | (p[2] << 16);
+	return (v * 2654435761u) >> (32 - ZHASH_BITS);
+}
+
+static int zDeflate(zWriter* z, const unsigned char* src, int size)
+{
+	int* head = malloc(sizeof(int) << ZHASH_BITS);
+	int* prev = malloc(sizeof(int) * ZWINDOW);
+	if (head == NULL || prev == NULL)
 	{
-		x -= _rOffsetX;
-		y -= _rOffsetY;
+		free(head);
+		free(prev);
+		return FALSE;
 	}
-	if (_useRScale)
+	memset(head, 0xFF, sizeof(int) << ZHASH_BITS);
+
+	/* zlib header, then one final block using the fixed codes */
+	zPut(z, 0x78, 8);
+	zPut(z, 0x01, 8);
+	zPut(z, 1, 1);
+	zPut(z, 1, 2);
+
+	/* greedy matching over hash chains of 3 byte prefixes */
+	int i = 0;
+	while (i < size)
 	{
-		x /= _rScale;
-		y /= _rScale;
+		int best = 0, dist = 0;
+		if (i + 3 <= size)
+		{
+			int limit = min(258, size - i);
+			int chain = ZCHAIN_MAX;
+			for (int j = head[zHash(src + i)]; j >= 0 && i - j <= ZWINDOW &&
+				chain-- > 0; j = prev[j & (ZWINDOW - 1)])
+			{
+				if (src[j + best] != src[i + best]) continue;
+				int len = 0;
+				while (len < limit && src[j + len] == src[i + len]) len++;
+				if (len > best)
+				{
+					best = len;
+					dist = i - j;
+					if (len == limit) break;
+				}
+			}
+		}
+
+		int advance = 1;
+		if (best >= 3)
+		{
+			zMatch(z, best, dist);
+			advance = best;
+		}
+		else zLiteral(z, src[i]);
+
+		/* every position covered goes into the chains */
+		for (int k = 0; k < advance; k++, i++)
+		{
+			if (i + 3 > size) continue;
+			unsigned int h = zHash(src + i);
+			prev[i & (ZWINDOW - 1)] = head[h];
+			head[h] = i;
+		}
 	}
 
-	/* object is now in "normalized screenspace" */
-	/* compare if object is seeable */
-	if (fabsf(x) > (1.0f + extra)) return 0;
-	if (fabsf(y) > (1.0f + extra)) return 0;
+	zLiteral(z, 256);
+	if (z->count) zPut(z, 0, 8 - z->count);
 
-	return 1;
+	/* adler32 of the uncompressed data, big endian */
+	unsigned int a = 1, b = 0;
+	for (int k = 0; k < size; )
+	{
+		int end = min(size, k + 5552);
+		for (; k < end; k++)
+		{
+			a += src[k];
+			b += a;
+		}
+		a %= 65521;
+		b %= 65521;
+	}
+	unsigned int adler = (b << 16) | a;
+	for (int k = 24; k >= 0; k -= 8) zPut(z, (adler >> k) & 0xFF, 8);
+
+	free(head);
+	free(prev);
+	return !z->failed;
 }
 
-/* ITEX FUNCTIONS */
+static unsigned char* pngFilter(const unsigned char* rgba, int w, int h)
+{
+	/* rgba is bottom-up, png rows are top-down RGB with a filter byte */
+	int pitch = w * 3;
+	unsigned char* out = malloc((size_t)(pitch + 1) * h);
+	unsigned char* rows = calloc(pitch, 2);
+	unsigned char* trial = malloc((size_t)pitch * 5);
+	if (out == NULL || rows == NULL || trial == NULL)
+	{
+		free(out);
+		free(rows);
+		free(trial);
+		return NULL;
+	}
 
-VAPI void vgITexDataClear(void)
+	for (int y = 0; y < h; y++)
+	{
+		unsigned char* cur = rows + (y & 1) * pitch;
+		const unsigned char* prior = rows + ((y + 1) & 1) * pitch;
+		const unsigned char* src = rgba + (size_t)(h - 1 - y) * w * 4;
+		for (int x = 0; x < w; x++)
+		{
+			cur[x * 3 + 0] = src[x * 4 + 0];
+			cur[x * 3 + 1] = src[x * 4 + 1];
+			cur[x * 3 + 2] = src[x * 4 + 2];
+		}
+
+		/* try every filter, keep the smallest sum of signed residuals */
+		int cost[5] = { 0 };
+		for (int x = 0; x < pitch; x++)
+		{
+			int a = x >= 3 ? cur[x - 3] : 0;
+			int b = prior[x];
+			int c = x >= 3 ? prior[x - 3] : 0;
+			int v = cur[x];
+			trial[x] = v;
+			trial[pitch + x] = v - a;
+			trial[pitch * 2 + x] = v - b;
+			trial[pitch * 3 + x] = v - ((a + b) >> 1);
+			trial[pitch * 4 + x] = v - pngPaeth(a, b, c);
+			for (int f = 0; f < 5; f++)
+				cost[f] += abs((signed char)trial[pitch * f + x]);
+		}
+
+		int best = 0;
+		for (int f = 1; f < 5; f++)
+			if (cost[f] < cost[best]) best = f;
+
+		unsigned char* row = out + (size_t)(pitch + 1) * y;
+		row[0] = best;
+		memcpy(row + 1, trial + pitch * best, pitch);
+	}
+
+	free(rows);
+	free(trial);
+	return out;
+}
+
+static void pngChunk(FILE* out, const unsigned int* table, const char* type,
+	const unsigned char* data, unsigned int size)
 {
-	for (int i = 0; i < VG_ITEX_COLORS_MAX; i++)
+	unsigned char be[4] = { size >> 24, size >> 16, size >> 8, size };
+	fwrite(be, 1, 4, out);
+	fwrite(type, 1, 4, out);
+	if (size) fwrite(data, 1, size, out);
+
+	/* crc covers the type and the data */
+	unsigned int crc = 0xFFFFFFFF;
+	for (int i = 0; i < 4; i++)
+		crc = table[(crc ^ (unsigned char)type[i]) & 0xFF] ^ (crc >> 8);
+	for (unsigned int i = 0; i < size; i++)
+		crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+	crc ^= 0xFFFFFFFF;
+
+	unsigned char tail[4] = { crc >> 24, crc >> 16, crc >> 8, crc };
+	fwrite(tail, 1, 4, out);
+}
+
+static int savePNG(const char* file, const unsigned char* rgba, int w, int h)
+{
+	static const unsigned char sig[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
+
+	unsigned char* filtered = pngFilter(rgba, w, h);
+	if (filtered == NULL) return FALSE;
+
+	zWriter z = { 0 };
+	int ok = zDeflate(&z, filtered, (w * 3 + 1) * h);
+	free(filtered);
+
+	FILE* out = ok ? fopen(file, "wb") : NULL;
+	if (out)
 	{
-		_icolorR[i] = NULL;
-		_icolorG[i] = NULL;
-		_icolorB[i] = NULL;
-		_icolorA[i] = NULL;
+		unsigned int table[256];
+		for (unsigned int n = 0; n < 256; n++)
+		{
+			unsigned int c = n;
+			for (int k = 0; k < 8; k++)
+				c = (c & 1) ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+			table[n] = c;
+		}
+
+		/* 8 bit truecolor, no interlace */
+		unsigned char header[13] = { w >> 24, w >> 16, w >> 8, w,
+			h >> 24, h >> 16, h >> 8, h, 8, 2, 0, 0, 0 };
+		fwrite(sig, 1, 8, out);
+		pngChunk(out, table, "IHDR", header, 13);
+		pngChunk(out, table, "IDAT", z.data, (unsigned int)z.size);
+		pngChunk(out, table, "IEND", NULL, 0);
+		ok = !ferror(out);
+		fclose(out);
 	}
+	else ok = FALSE;
+
+	free(z.data);
+	return ok;
+}
+
+static DWORD WINAPI screenshotThread(LPVOID param)
+{
+	int slot = (int)(INT_PTR)param;
+
+	/* the GL thread hands over the pixels once the read has landed */
+	WaitForSingleObject(_shotGo[slot], INFINITE);
+	PROFILE_BEGIN("screenshot encode");
+	_shotResult[slot] = _shotPixels[slot] != NULL &&
+		savePNG(_shotFile[slot], _shotPixels[slot], _shotW[slot],
+			_shotH[slot]);
+	PROFILE_END();
+	free(_shotPixels[slot]);
+	_shotPixels[slot] = NULL;
+
+	InterlockedExchange(&_shotState[slot], SHOT_DONE);
+	return 0;
+}
 
-	for (int i = 0; i < VG_ITEX_SIZE_MAX; i++)
+VAPI int vgScreenshot(const char* file, vgScreenshotCallback callback,
+	void* user)
+{
+	int slot = -1;
+	for (int i = 0; i < VG_SCREENSHOTS_MAX && slot < 0; i++)
+		if (_shotState[i] == SHOT_FREE) slot = i;
+	if (slot < 0) return VG_FALSE;
+
+	_shotFile[slot] = malloc(strlen(file) + 1);
+	if (_shotFile[slot]) strcpy(_shotFile[slot], file);
+	_shotGo[slot] = CreateEventA(NULL, FALSE, FALSE, NULL);
+	_shotThread[slot] = _shotFile[slot] && _shotGo[slot] ? CreateThread(NULL,
+		0, screenshotThread, (LPVOID)(INT_PTR)slot, 0, NULL) : NULL;
+	if (_shotThread[slot] == NULL)
 	{
-		for (int j = 0; j < VG_ITEX_SIZE_MAX; j++)
-		{
-			_indexes[i][j] = NULL;
-		}
+		if (_shotGo[slot]) CloseHandle(_shotGo[slot]);
+		free(_shotFile[slot]);
+		_shotGo[slot] = NULL;
+		_shotFile[slot] = NULL;
+		return VG_FALSE;
 	}
+
+	/* read into a pixel buffer, it is mapped once the GPU is done */
+	_shotW[slot] = _resW;
+	_shotH[slot] = _resH;
+	glGenBuffers(1, &_shotBuffer[slot]);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, _shotBuffer[slot]);
+	glBufferData(GL_PIXEL_PACK_BUFFER, (size_t)_resW * _resH * 4, NULL,
+		GL_STREAM_READ);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, _framebuffer);
+	glReadPixels(0, 0, _resW, _resH, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	_shotFence[slot] = GLEW_ARB_sync ?
+		glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0) : NULL;
+	glFlush();
+
+	_shotCallback[slot] = callback;
+	_shotUser[slot] = user;
+	_shotFrame[slot] = _frames;
+	_shotState[slot] = SHOT_READING;
+	return VG_TRUE;
 }
 
-VAPI void vgITexDataColor(unsigned short index, int r, int g, int b, int a)
+VAPI int vgScreenshotsPending(void)
 {
-	_icolorR[index] = r;
-	_icolorG[index] = g;
-	_icolorB[index] = b;
-	_icolorA[index] = a;
+	int pending = 0;
+	for (int i = 0; i < VG_SCREENSHOTS_MAX; i++)
+		pending += _shotState[i] != SHOT_FREE;
+	return pending;
 }
 
-VAPI void vgITexDataIndex(unsigned short index, int x, int y)
+VAPI void vgFinishScreenshots(void)
 {
-	_indexes[x][y] = index;
+	/* callbacks may queue more, keep going until all are reported */
+	while (vgScreenshotsPending() > 0)
+		screenshotCollect(TRUE);
 }
 
-VAPI void vgITexDataIndexArray(unsigned short index, int* vx, int* vy,
-	int size)
+/* TRACE FUNCTIONS */
+
+VAPI int vgStartTrace(const char* file)
 {
-	for (int i = 0; i < size; i++)
+	if (_traceFile != NULL) return VG_FALSE;
+
+	FILE* out = fopen(file, "wb");
+	if (out == NULL) return VG_FALSE;
+	setvbuf(out, NULL, _IOFBF, 1 << 20);
+
+	if (!_traceLockInit)
 	{
-		_indexes[vx[i]][vy[i]] = index;
+		InitializeCriticalSection(&_traceLock);
+		_traceLockInit = TRUE;
 	}
-}
 
-VAPI vgTexture vgITexDataCompile(int width, int height, int repeat,
-	int linear)
-{
-	/* create 2D compacted array buffer for color data to be stored */
-	unsigned char* colorBuffer;
-	colorBuffer = malloc(sizeof(unsigned char) * width * height * 4);
-	if (colorBuffer == NULL) return 0;
+	vgTraceHeader header = { { 'V', 'G', 'T', 'R' }, VG_TRACE_VERSION,
+		_windowWidth, _windowHeight, _resW, _resH, _renderFormat,
+		_renderLinear };
+	fwrite(&header, sizeof(header), 1, out);
 
-	int writeIndex = 0;
+	_traceCalls = 0;
+	_traceSwap.QuadPart = 0;
+	EnterCriticalSection(&_traceLock);
+	_traceFile = out;
+	LeaveCriticalSection(&_traceLock);
 
-	for (int i = 0; i < width; i++)
+	/* recreate existing textures from their texels so draws have them, */
+	/* compressed, array and still uploading ones only get their storage */
+	_traceMute++;
+	for (int i = 0; i < VG_TEXTURES_MAX; i++)
 	{
-		for (int j = 0; j < height; j++)
+		if (_texBuffer[i] == 0 && !_texPending[i]) continue;
+
+		int w = _texWidth[i], h = _texHeight[i];
+		if (_texLayers[i])
 		{
-			int colorIndex = _indexes[i][j];
-			colorBuffer[writeIndex + 0] = (unsigned char)_icolorR[colorIndex];
-			colorBuffer[writeIndex + 1] = (unsigned char)_icolorG[colorIndex];
-			colorBuffer[writeIndex + 2] = (unsigned char)_icolorB[colorIndex];
-			colorBuffer[writeIndex + 3] = (unsigned char)_icolorA[colorIndex];
-			writeIndex += 4;
+			traceCall(VG_TRACE_CREATE_TEXTURE_ARRAY, NULL, 0, "iiiiii", w, h,
+				_texLayers[i], VG_NEAREST, VG_FALSE, i);
+			continue;
 		}
-	}
 
-	vgTexture handle = vgCreateTexture(width, height, linear, repeat,
-		colorBuffer);
+		unsigned char* texels = NULL;
+		if (_texBuffer[i] && !fmtCompressed(_texFormat[i]))
+			texels = malloc(w * h * 4);
+		if (texels != NULL &&
+			!vgReadPixels(i, 0, 0, w, h, VG_FORMAT_RGBA8, texels, 0))
+		{
+			free(texels);
+			texels = NULL;
+		}
 
-	free(colorBuffer);
+		traceCall(VG_TRACE_CREATE_TEXTURE, texels, texels ? w * h * 4 : 0,
+			"iiiiii", w, h, _texLevels[i] > 1 ? VG_LINEAR_MIPMAP : VG_NEAREST,
+			VG_FALSE, _texFormat[i], i);
+		free(texels);
 
-	return handle;
-}
+		GLfloat bias = 0;
+		if (_texBuffer[i])
+		{
+			texBind(GL_TEXTURE_2D, _texBuffer[i]);
+			glGetTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_LOD_BIAS, &bias);
+		}
+		if (bias != 0)
+			traceCall(VG_TRACE_TEXTURE_LOD_BIAS, NULL, 0, "if", i, bias);
+	}
 
-/* TEXTURE EDITING FUNCTIONS */
+	/* shapes from the vertices kept when they were compiled */
+	for (int i = 0; i < VG_SHAPES_MAX; i++)
+	{
+		if (_shapeBuffer[i] == 0) continue;
 
-VAPI void vgEditTexture(vgTexture target, int w, int h)
-{
-	/* bind editing framebuffer to target texture */
-	glBindFramebuffer(GL_FRAMEBUFFER, _eFrameBuffer);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
-		_texBuffer[target], NULL);
-	glDrawBuffer(GL_COLOR_ATTACHMENT0);
+		int size = _shapeSize[i] * 2 * sizeof(float);
+		if (_shapeTextured[i]) size *= 2;
+		traceCall(_shapeTextured[i] ? VG_TRACE_COMPILE_SHAPE_TEXTURED :
+			VG_TRACE_COMPILE_SHAPE, _shapeData[i], _shapeData[i] ? size : 0,
+			"ii", _shapeSize[i], i);
+	}
 
-	/* setup other data */
-	_eWidth = w;
-	_eHeight = h;
+	/* then the render state, so the first recorded draw looks the same */
+	traceCall(VG_TRACE_SET_SWAP_TIME, NULL, 0, "i", _swapTime);
+	traceCall(VG_TRACE_USE_RENDER_SKIP, NULL, 0, "i", _useRenderSkip);
+	traceCall(VG_TRACE_USE_TEXTURE_POOL, NULL, 0, "i", _usePool);
+	traceCall(VG_TRACE_USE_CPU_MIPMAPS, NULL, 0, "i", _cpuMipmaps);
+	traceCall(VG_TRACE_COLOR4, NULL, 0, "iiii", _colR, _colG, _colB, _colA);
+	traceCall(VG_TRACE_LINE_SIZE, NULL, 0, "f", _lineW);
+	traceCall(VG_TRACE_POINT_SIZE, NULL, 0, "f", _pointW);
+	traceCall(VG_TRACE_VIEWPORT, NULL, 0, "iiii", _vpx, _vpy, _vpw, _vph);
+	traceCall(VG_TRACE_RENDER_SCALE, NULL, 0, "f", _rScale);
+	traceCall(VG_TRACE_USE_RENDER_SCALING, NULL, 0, "i", _useRScale);
+	traceCall(VG_TRACE_RENDER_OFFSET, NULL, 0, "ff", _rOffsetX, _rOffsetY);
+	traceCall(VG_TRACE_USE_RENDER_OFFSET, NULL, 0, "i", _useROffset);
+	traceCall(VG_TRACE_RENDER_LAYER, NULL, 0, "f", -_layer);
+	traceCall(VG_TRACE_TEXTURE_FILTER, NULL, 0, "iiii", _tcolR, _tcolG,
+		_tcolB, _tcolA);
+	if (_useTex < VG_TEXTURES_MAX &&
+		(_texBuffer[_useTex] || _texPending[_useTex]))
+		traceCall(VG_TRACE_USE_TEXTURE, NULL, 0, "i", _useTex);
+	traceCall(VG_TRACE_USE_TEXTURE_LAYER, NULL, 0, "i", _useLayer);
+	_traceMute--;
+
+	return VG_TRUE;
 }
 
-VAPI void vgEditColor(int r, int g, int b, int a)
+VAPI void vgStopTrace(void)
 {
-	_ecolR = r;
-	_ecolG = g;
-	_ecolB = b;
-	_ecolA = a;
+	if (_traceFile == NULL) return;
+
+	EnterCriticalSection(&_traceLock);
+	fclose(_traceFile);
+	_traceFile = NULL;
+	LeaveCriticalSection(&_traceLock);
 }
 
-VAPI void vgEditPoint(int x, int y)
+VAPI int vgTraceCalls(void)
 {
-	esetup();
+	return _traceCalls;
+}
 
-	glPointSize(1);
+/* PROFILE FUNCTIONS */
 
-	glBegin(GL_POINTS);
-	glVertex2i(x, y);
-	glEnd();
+static void profileName(FILE* out, const char* name)
+{
+	/* zone names are JSON strings */
+	fputc('"', out);
+	for (; name != NULL && *name; name++)
+	{
+		unsigned char c = *name;
+		if (c == '"' || c == '\\') fprintf(out, "\\%c", c);
+		else if (c < 0x20) fprintf(out, "\\u%04x", c);
+		else fputc(c, out);
+	}
+	fputc('"', out);
 }
 
-VAPI void vgEditLine(int x1, int y1, int x2, int y2)
+VAPI void vgUseProfiling(int state)
 {
-	esetup();
-
-	glLineWidth(1);
+	if (state && _profStart == 0)
+	{
+		LARGE_INTEGER now;
+		QueryPerformanceCounter(&now);
+		_profStart = now.QuadPart;
+	}
 
-	glBegin(GL_LINES);
-	glVertex2i(x1, y1);
-	glVertex2i(x2, y2);
-	glEnd();
+	InterlockedExchange(&_profRunning, state ? TRUE : FALSE);
 }
 
-VAPI void vgEditRect(int x, int y, int w, int h)
+VAPI void vgProfileBegin(const char* name)
 {
-	esetup();
+	if (_profRunning) profileEvent(name, 'B', TRUE);
+}
 
-	glBegin(GL_QUADS);
-	glVertex2i(x, y);
-	glVertex2i(x, y + h);
-	glVertex2i(x + w, y + h);
-	glVertex2i(x + w, y);
-	glEnd();
+VAPI void vgProfileEnd(void)
+{
+	if (_profRunning) profileEvent(NULL, 'E', TRUE);
 }
 
-VAPI void vgEditShape(vgShape shape, float x, float y, float r, float s)
+VAPI int vgSaveProfile(const char* file)
 {
-	esetup();
+	FILE* out = fopen(file, "w");
+	if (out == NULL) return VG_FALSE;
 
-	glTranslatef(x, y, 0); /* third, transalate */
-	glScalef(s, s, 1); /* second, scale */
-	glRotatef(r, 0, 0, 1); /* first, rotate */
+	profileEntry* copy = malloc(sizeof(profileEntry) * VG_PROFILE_EVENTS);
+	if (copy == NULL)
+	{
+		fclose(out);
+		return VG_FALSE;
+	}
 
-	glCallList(_shapeBuffer[shape]);
-}
+	LARGE_INTEGER freq;
+	QueryPerformanceFrequency(&freq);
+	double toMicro = 1000000.0 / freq.QuadPart;
+	DWORD pid = GetCurrentProcessId();
 
-VAPI void vgEditUseTexture(vgTexture tex)
-{
-	_euTex = tex;
+	fprintf(out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	fprintf(out, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%lu,"
+		"\"args\":{\"name\":\"VGraphics\"}}", pid);
+
+	int rings = min(_profRings, VG_PROFILE_THREADS_MAX);
+	for (int r = 0; r < rings; r++)
+	{
+		profileRing* ring = _profRing[r];
+		if (ring == NULL) continue;
+		DWORD tid = ring->thread;
+
+		/* copy, then skip anything the owner overwrote meanwhile */
+		/* heads are read with an exchange so 32-bit builds get all of it */
+		LONG64 end = InterlockedCompareExchange64(&ring->head, 0, -1);
+		LONG64 first = max(0, end - VG_PROFILE_EVENTS);
+		for (LONG64 i = first; i < end; i++)
+			copy[i - first] = ring->entries[i & (VG_PROFILE_EVENTS - 1)];
+		LONG64 now = InterlockedCompareExchange64(&ring->head, 0, -1);
+		if (now < end) continue;
+		LONG64 begin = max(first, now - VG_PROFILE_EVENTS + 1);
+
+		if (tid == _glThread)
+			fprintf(out, ",\n{\"name\":\"thread_name\",\"ph\":\"M\","
+				"\"pid\":%lu,\"tid\":%lu,\"args\":{\"name\":\"GL thread\"}}",
+				pid, tid);
+
+		for (LONG64 i = begin; i < end; i++)
+		{
+			profileEntry* e = &copy[i - first];
+			double ts = (e->time - _profStart) * toMicro;
+			if (e->phase == 'E')
+			{
+				fprintf(out, ",\n{\"ph\":\"E\",\"pid\":%lu,\"tid\":%lu,"
+					"\"ts\":%.3f}", pid, tid, ts);
+				continue;
+			}
+
+			fprintf(out, ",\n{\"name\":");
+			profileName(out, e->name);
+			fprintf(out, ",\"cat\":\"%s\",\"ph\":\"B\",\"pid\":%lu,"
+				"\"tid\":%lu,\"ts\":%.3f}", e->user ? "user" : "vg", pid, tid,
+				ts);
+		}
+	}
+
+	fprintf(out, "\n]}\n");
+	free(copy);
+	return fclose(out) == 0 ? VG_TRUE : VG_FALSE;
 }
 
-VAPI void vgEditShapeTextured(vgShape shape, float x, float y, float r,
-	float s)
+/* FRAME STATISTICS FUNCTIONS */
+
+/* call names by trace op, 0 being the end of a frame */
+static const char* _callNames[VG_TRACE_OPS] = {
+	"frame end", "vgUpdate", "vgSetWindowSize", "vgSetSwapTime",
+	"vgUseRenderSkip", "vgClear", "vgFill", "vgFillRegion", "vgSwap",
+	"vgColor3", "vgColor4", "vgRect", "vgLineSize", "vgLine", "vgPointSize",
+	"vgPoint", "vgViewport", "vgViewportReset", "vgRectf", "vgLinef",
+	"vgPointf", "vgCreateTextureFormat", "vgDestroyTexture", "vgUseTexturePool",
+	"vgTexturePoolClear", "vgUseCPUMipmaps", "vgTextureLODBias",
+	"vgRegenerateMipmaps", "vgUseTexture", "vgTextureFilter",
+	"vgTextureFilterReset", "vgRectTexture", "vgRectTextureOffset",
+	"vgCreateTextureArray", "vgEditTextureLayer", "vgUseTextureLayer",
+	"vgRectTextureLayer", "vgCompileShape", "vgCompileShapeTextured",
+	"vgDestroyShape", "vgDrawShape", "vgDrawShapeTextured", "vgRenderScale",
+	"vgUseRenderScaling", "vgRenderOffset", "vgUseRenderOffset",
+	"vgRenderLayer", "vgEditTexture", "vgEditColor", "vgEditPoint",
+	"vgEditLine", "vgEditRect", "vgEditShape", "vgEditUseTexture",
+	"vgEditShapeTextured", "vgEditSetData", "vgEditClear", "vgReadPixels",
+	"vgCopyTexture", "vgBlitTexture", "vgDuplicateTexture",
+	"vgCreateTextureCompressed" };
+
+VAPI float vgFrameTimePercentile(float percentile)
 {
-	esetup();
+	if (_ftCount == 0) return 0;
 
-	glTranslatef(x, y, 0); /* third, transalate */
-	glScalef(s, s, 1); /* second, scale */
-	glRotatef(r, 0, 0, 1); /* first, rotate */
+	unsigned long long rank = (unsigned long long)
+		ceil(percentile / 100.0 * _ftCount);
+	rank = max(1, min(rank, _ftCount));
 
-	glBindTexture(GL_TEXTURE_2D, _texBuffer[_euTex]);
+	unsigned long long seen = 0;
+	for (int i = 0; i < VG_FRAME_BUCKETS; i++)
+	{
+		seen += _ftBucket[i];
+		if (seen < rank) continue;
 
-	glColor4ub(_tcolR, _tcolG, _tcolB, _tcolA);
+		/* middle of the bucket, never past the longest frame seen */
+		unsigned int low = i, width = 1;
+		if (i >= 128)
+		{
+			int shift = i / 64 - 1;
+			low = (unsigned int)(i - 64 * shift) << shift;
+			width = 1u << shift;
+		}
+		return min(low + width / 2, _ftMax) / 1000.0f;
+	}
 
-	glEnable(GL_TEXTURE_2D);
-	glCallList(_shapeBuffer[shape]);
-	glDisable(GL_TEXTURE_2D);
+	return _ftMax / 1000.0f;
 }
 
-VAPI void vgEditSetData(int width, int height, void* data)
+VAPI float vgFrameTimeMax(void)
 {
-	esetup();
-
-	glDrawPixels(width, height, GL_RGBA, GL_UNSIGNED_BYTE, data);
+	return _ftMax / 1000.0f;
 }
 
-VAPI void vgEditClear(void)
+VAPI unsigned long long vgFrameTimeCount(void)
 {
-	esetup();
-	
-	glClearColor(0, 0, 0, 0);
-	glClear(GL_COLOR_BUFFER_BIT);
+	return _ftCount;
 }
 
-VAPI void* vgGetTextureData(vgTexture tex, int w, int h)
+VAPI void vgResetFrameTimes(void)
 {
-	/* bind FB and texture */
-	glBindFramebuffer(GL_FRAMEBUFFER, _rFrameBuffer);
-	glBindTexture(GL_TEXTURE_2D, _texBuffer[tex]);
-
-	/* connect the two */
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
-		_texBuffer[tex], NULL);
-	glDrawBuffer(GL_COLOR_ATTACHMENT0);
-	
-	int size = (w * h * 4);
-
-	void* data = calloc(1, sizeof(unsigned char) * size);
+	memset(_ftBucket, 0, sizeof(_ftBucket));
+	_ftCount = 0;
+	_ftMax = 0;
+}
 
-	if (data == NULL) return NULL;
+VAPI void vgHitchThreshold(float ms)
+{
+	if (ms <= 0)
+	{
+		InterlockedExchange(&_hitchOn, FALSE);
+		return;
+	}
 
-	glPixelStorei(GL_PACK_ALIGNMENT, 1);
-	glReadPixels(0, 0, w, h, GL_RGBA, GL_UNSIGNED_BYTE, data);
+	_hitchThreshold = (unsigned int)(ms * 1000.0f);
+	if (_hitchOn) return;
 
-	return data;
+	/* windows never reach back before the recorder was started */
+	for (int i = 0; i < HITCH_FRAME_RING; i++)
+		_hcFrameStart[i] = _hcHead;
+	_hcPendingLeft = 0;
+	InterlockedExchange(&_hitchOn, TRUE);
 }
 
-/* CURSOR RELATED FUNCTIONS */
+VAPI int vgHitchCount(void)
+{
+	return _hitchCount;
+}
 
-VAPI void vgGetCursorPos(int* x, int* y)
+VAPI int vgSaveHitches(const char* file)
 {
-	POINT p; /* cursor point */
+	FILE* out = fopen(file, "w");
+	if (out == NULL) return VG_FALSE;
+
+	LARGE_INTEGER freq;
+	QueryPerformanceFrequency(&freq);
+	double toMs = 1000.0 / freq.QuadPart;
+
+	int kept = min(_hitchSaved, VG_HITCHES_MAX);
+	fprintf(out, "%d hitches over %.3f ms, the last %d kept\n", _hitchCount,
+		_hitchThreshold / 1000.0, kept);
+	fprintf(out, "%llu frames, p50 %.3f p95 %.3f p99 %.3f max %.3f ms\n",
+		_ftCount, vgFrameTimePercentile(50), vgFrameTimePercentile(95),
+		vgFrameTimePercentile(99), vgFrameTimeMax());
+
+	/* each call with how long it was until the next one started */
+	for (int h = _hitchSaved - kept; h < _hitchSaved; h++)
+	{
+		hitchRecord* record = &_hitch[h % VG_HITCHES_MAX];
+		fprintf(out, "\nframe %llu took %.3f ms\n%10s %10s  %s\n",
+			record->frame, record->frameTime / 1000.0, "start ms", "to next",
+			"call");
 
-	/* get cursor position and convert to window pos */
-	GetCursorPos(&p);
-	ScreenToClient(_window, &p);
-	
-	/* set params*/
-	*x = p.x; *y = p.y;
+		for (int i = 0; i < record->count; i++)
+		{
+			hitchCall* call = &record->calls[i];
+			double start = (call->time - record->calls[0].time) * toMs;
+			if (call->op == 0)
+			{
+				fprintf(out, "%10.3f %10s  -- frame end, %.3f ms\n", start, "",
+					call->frameTime / 1000.0);
+				continue;
+			}
+
+			const char* name = call->op < VG_TRACE_OPS ?
+				_callNames[call->op] : "?";
+			if (i + 1 < record->count)
+				fprintf(out, "%10.3f %10.3f  %s\n", start,
+					(record->calls[i + 1].time - call->time) * toMs, name);
+			else fprintf(out, "%10.3f %10s  %s\n", start, "", name);
+		}
+	}
+
+	return fclose(out) == 0 ? VG_TRUE : VG_FALSE;
 }
 
-VAPI void vgGetCursorPosScaled(float* x, float* y)
-{
-	/* get mouse coordinates */
-	int   mx, my;
-	float fx, fy;
-	vgGetCursorPos(&mx, &my);
-	fx = (float)mx;
-	fy = (float)my;
+/* OVERDRAW FUNCTIONS */
 
-	/* first, offset to center so that (W/2, H/2) maps to (0, 0)*/
-	fx -= ((float)_windowWidth  / 2.0f);
-	fy -= ((float)_windowHeight / 2.0f);
+VAPI void vgUseOverdraw(int mode)
+{
+	int known = mode == VG_OVERDRAW_OFF || mode == VG_OVERDRAW_COUNT ||
+		mode == VG_OVERDRAW_HEATMAP;
+	VALIDATE(known, VG_VALIDATE_BOUNDS, "overdraw mode %d", mode);
 
-	/* normalize position so that (W,H) maps to (1, 1) */
-	fx /= (float)((float)_windowWidth / 2.0f);
-	fy /= (float)((float)_windowHeight / 2.0f);
-	fy *= -1; /* flip y coord */
+	/* an unknown mode would leave the counters half set up */
+	if (!known || mode == _odMode) return;
 
-	/* scale and transform */
-	if (_useRScale)
+	if (mode == VG_OVERDRAW_OFF)
 	{
-		fx *= _rScale;
-		fy *= _rScale;
+		glDisable(GL_STENCIL_TEST);
+		texDelete(1, &_odTexture);
+		free(_odCounts);
+		free(_odHeat);
+		_odTexture = 0;
+		_odCounts = NULL;
+		_odHeat = NULL;
+		_odMode = VG_OVERDRAW_OFF;
+		return;
 	}
-	if (_useROffset)
+
+	if (_odMode == VG_OVERDRAW_OFF)
 	{
-		fx += _rOffsetX;
-		fy += _rOffsetY;
+		_odCounts = malloc(_resW * _resH);
+		_odHeat = malloc(_resW * _resH * 4);
+		if (_odCounts == NULL || _odHeat == NULL)
+		{
+			free(_odCounts);
+			free(_odHeat);
+			_odCounts = NULL;
+			_odHeat = NULL;
+			return;
+		}
+
+		/* heatmap is presented the same way as the render target */
+		GLint filter = _renderLinear == 1 ? GL_LINEAR : GL_NEAREST;
+		glGenTextures(1, &_odTexture);
+		texBind(GL_TEXTURE_2D, _odTexture);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, _resW, _resH, 0, GL_RGBA,
+			GL_UNSIGNED_BYTE, NULL);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+
+		/* every fragment that passes depth adds one, saturating at 255 */
+		glBindFramebuffer(GL_FRAMEBUFFER, _framebuffer);
+		glClearStencil(0);
+		glClear(GL_STENCIL_BUFFER_BIT);
+		glStencilMask(0xFF);
+		glStencilFunc(GL_ALWAYS, 0, 0xFF);
+		glStencilOp(GL_KEEP, GL_KEEP, GL_INCR);
 	}
 
-	/* convert back to int and return */
-	*x = fx; *y = fy;
+	_odMode = mode;
 }
 
-VAPI int vgOnLeftClick(void)
+VAPI unsigned long long vgOverdrawWrites(void)
 {
-	return GetKeyState(VK_LBUTTON) < 0;
+	return _odWrites;
 }
 
-VAPI int vgOnRightClick(void)
+VAPI int vgOverdrawMax(void)
 {
-	return GetKeyState(VK_RBUTTON) < 0;
+	return _odMax;
 }
 
-VAPI int vgCursorOverlap(float x, float y, float w, float h)
+VAPI int vgOverdrawPixels(int count)
 {
-	float mx, my;
-	vgGetCursorPosScaled(&mx, &my);
-	return (mx > x && mx < x + w) && (my > y && my < y + h);
+	if (count < 0 || count >= VG_OVERDRAW_LEVELS) return 0;
+	return _odPixels[count];
 }
 
-/* TEXTURE LOADING AND SAVING FUNCTIONS */
+/* HUD FUNCTIONS */
 
-VAPI void vgSaveTexture(vgTexture texture, const char* file, int w, int h)
+VAPI void vgUseHud(int corner)
 {
-	/* create file and open */
-	FILE* output;
-	output = fopen(file, "w");
-	
-	/* get texture data */
-	unsigned char* tData = vgGetTextureData(texture, w, h);
-
-	/* write to file */
-	fwrite(tData, sizeof(unsigned char), w * h * 4, output);
-
-	/* free memory and close file */
-	free(tData);
-	fflush(output); fclose(output);
+	_hudCorner = corner;
 }
 
-VAPI vgTexture vgLoadTexture(const char* file, int w, int h, int linear,
-	int repeat)
+VAPI int vgDrawCallCount(void)
 {
-	/* allocate data buffer */
-	unsigned char* buffer = calloc(1, w * h * 4);
-	if (buffer == 0) return NULL;
-
-	/* open file and read */
-	FILE* rFile = fopen(file, "r");
-
-	fread(buffer, sizeof(unsigned char), w * h * 4, rFile);
-
-	/* create texture, free and close */
-	vgTexture rTex = vgCreateTexture(w, h, linear, repeat, buffer);
+	return _hudLastDraws;
+}
 
-	free(buffer);
-	fflush(rFile);
-	fclose(rFile);
+VAPI int vgTextureBindCount(void)
+{
+	return _hudLastBinds;
+}
 
-	return rTex;
+VAPI int vgCulledCount(void)
+{
+	return _hudLastCulled;
 }
 
-VAPI void* vgLoadTextureData(const char* file, int w, int h)
+VAPI unsigned long long vgTextureMemory(void)
 {
-	/* allocate data buffer */
-	unsigned char* buffer = calloc(1, w * h * 4);
-	if (buffer == 0) return NULL;
+	return hudTextureMemory();
+}
 
-	/* open file and read */
-	FILE* rFile = fopen(file, "r");
+/* VALIDATION FUNCTIONS */
 
-	fread(buffer, sizeof(unsigned char), w * h * 4, rFile);
+VAPI void vgValidationCallback(vgValidateCallback callback, void* user)
+{
+#ifdef VG_VALIDATE
+	_valCallback = callback;
+	_valUser = user;
+#else
+	(void)callback;
+	(void)user;
+#endif
+}
 
-	return buffer;
+VAPI int vgValidationEnabled(void)
+{
+#ifdef VG_VALIDATE
+	return VG_TRUE;
+#else
+	return VG_FALSE;
+#endif
 }
 
 /* DEBUG FUNCTIONS */
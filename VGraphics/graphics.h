@@ -20,8 +20,22 @@
 *		- Advanced draw functions
 *		- ITex functions
 *		- Texture editing functions
+*		- Texture compression functions
+*		- Large image functions
 *		- Input related functions
 *		- Texture loading and saving functions
+*		- Image import functions
+*		- Hot reload functions
+*		- Archive functions
+*		- Upload thread functions
+*		- Capture functions
+*		- Screenshot functions
+*		- Trace functions
+*		- Profile functions
+*		- Frame statistics functions
+*		- Overdraw functions
+*		- HUD functions
+*		- Validation functions
 *		- Debug functions
 * 
 ******************************************************************************/
@@ -46,12 +60,211 @@
 #define VG_ITEX_SIZE_MAX   0x40
 #define VG_FLUSH_THRESHOLD 0x800
 #define VG_SWAP_TIME_MIN   0x01
+#define VG_TEXPOOL_MAX     0x40
+#define VG_DEFER_MAX       0x400
+#define VG_DEFER_FRAMES    0x03
+#define VG_FENCE_RING      0x08
+#define VG_INVALID         0xFFFF
+#define VG_RENDER_TARGET   0xFFFE
+
+/* LARGE IMAGE DEFINITIONS */
+#define VG_LARGE_IMAGES_MAX  0x10
+#define VG_LARGE_TILE_SIZE   0x100
+#define VG_LARGE_CACHE_SIZE  0x800
+#define VG_LARGE_UPLOADS_MAX 0x08
+
+/* HOT RELOAD DEFINITIONS */
+#define VG_HOTRELOAD_DEBOUNCE 0x32
+
+/* ARCHIVE DEFINITIONS */
+#define VG_ARCHIVES_MAX    0x10
+#define VG_ARCHIVE_TEXTURE 1
+#define VG_ARCHIVE_SHAPE   2
+#define VG_ARCHIVE_REGION  3
+
+/* CAPTURE DEFINITIONS */
+#define VG_CAPTURE_RAW    0
+#define VG_CAPTURE_Y4M    1
+#define VG_CAPTURE_DELTA  2
+#define VG_CAPTURE_SHARED 3
+#define VG_CAPTURE_RING   0x06
+#define VG_CAPTURE_TILE   0x20
+#define VG_SHARED_SLOTS   0x04
+
+/* SCREENSHOT DEFINITIONS */
+#define VG_SCREENSHOTS_MAX 0x08
+
+/* TRACE DEFINITIONS */
+/* a trace is a vgTraceHeader followed by one record per call, each a */
+/* vgTraceRecord, argCount 4 byte int or float arguments and dataSize */
+/* bytes of texel or vertex data. Calls that create a texture or shape */
+/* pass the handle they returned as their last argument */
+#define VG_TRACE_VERSION  1
+#define VG_TRACE_ARGS_MAX 0x0C
+#define VG_TRACE_UPDATE                    1
+#define VG_TRACE_SET_WINDOW_SIZE           2
+#define VG_TRACE_SET_SWAP_TIME             3
+#define VG_TRACE_USE_RENDER_SKIP           4
+#define VG_TRACE_CLEAR                     5
+#define VG_TRACE_FILL                      6
+#define VG_TRACE_FILL_REGION               7
+#define VG_TRACE_SWAP                      8
+#define VG_TRACE_COLOR3                    9
+#define VG_TRACE_COLOR4                    10
+#define VG_TRACE_RECT                      11
+#define VG_TRACE_LINE_SIZE                 12
+#define VG_TRACE_LINE                      13
+#define VG_TRACE_POINT_SIZE                14
+#define VG_TRACE_POINT                     15
+#define VG_TRACE_VIEWPORT                  16
+#define VG_TRACE_VIEWPORT_RESET            17
+#define VG_TRACE_RECTF                     18
+#define VG_TRACE_LINEF                     19
+#define VG_TRACE_POINTF                    20
+#define VG_TRACE_CREATE_TEXTURE            21
+#define VG_TRACE_DESTROY_TEXTURE           22
+#define VG_TRACE_USE_TEXTURE_POOL          23
+#define VG_TRACE_TEXTURE_POOL_CLEAR        24
+#define VG_TRACE_USE_CPU_MIPMAPS           25
+#define VG_TRACE_TEXTURE_LOD_BIAS          26
+#define VG_TRACE_REGENERATE_MIPMAPS        27
+#define VG_TRACE_USE_TEXTURE               28
+#define VG_TRACE_TEXTURE_FILTER            29
+#define VG_TRACE_TEXTURE_FILTER_RESET      30
+#define VG_TRACE_RECT_TEXTURE              31
+#define VG_TRACE_RECT_TEXTURE_OFFSET       32
+#define VG_TRACE_CREATE_TEXTURE_ARRAY      33
+#define VG_TRACE_EDIT_TEXTURE_LAYER        34
+#define VG_TRACE_USE_TEXTURE_LAYER         35
+#define VG_TRACE_RECT_TEXTURE_LAYER        36
+#define VG_TRACE_COMPILE_SHAPE             37
+#define VG_TRACE_COMPILE_SHAPE_TEXTURED    38
+#define VG_TRACE_DESTROY_SHAPE             39
+#define VG_TRACE_DRAW_SHAPE                40
+#define VG_TRACE_DRAW_SHAPE_TEXTURED       41
+#define VG_TRACE_RENDER_SCALE              42
+#define VG_TRACE_USE_RENDER_SCALING        43
+#define VG_TRACE_RENDER_OFFSET             44
+#define VG_TRACE_USE_RENDER_OFFSET         45
+#define VG_TRACE_RENDER_LAYER              46
+#define VG_TRACE_EDIT_TEXTURE              47
+#define VG_TRACE_EDIT_COLOR                48
+#define VG_TRACE_EDIT_POINT                49
+#define VG_TRACE_EDIT_LINE                 50
+#define VG_TRACE_EDIT_RECT                 51
+#define VG_TRACE_EDIT_SHAPE                52
+#define VG_TRACE_EDIT_USE_TEXTURE          53
+#define VG_TRACE_EDIT_SHAPE_TEXTURED       54
+#define VG_TRACE_EDIT_SET_DATA             55
+#define VG_TRACE_EDIT_CLEAR                56
+#define VG_TRACE_READ_PIXELS               57
+#define VG_TRACE_COPY_TEXTURE              58
+#define VG_TRACE_BLIT_TEXTURE              59
+#define VG_TRACE_DUPLICATE_TEXTURE         60
+#define VG_TRACE_CREATE_TEXTURE_COMPRESSED 61
+#define VG_TRACE_OPS                       62
+
+/* PROFILE DEFINITIONS */
+#define VG_PROFILE_EVENTS      0x4000
+#define VG_PROFILE_THREADS_MAX 0x20
+
+/* FRAME STATISTICS DEFINITIONS */
+#define VG_FRAME_BUCKETS       0x6C0
+#define VG_HITCH_CALLS         0x4000
+#define VG_HITCH_FRAMES_BEFORE 0x03
+#define VG_HITCH_FRAMES_AFTER  0x01
+#define VG_HITCHES_MAX         0x08
+
+/* OVERDRAW DEFINITIONS */
+#define VG_OVERDRAW_OFF     0
+#define VG_OVERDRAW_COUNT   1
+#define VG_OVERDRAW_HEATMAP 2
+#define VG_OVERDRAW_LEVELS  0x100
+
+/* HUD DEFINITIONS */
+#define VG_HUD_OFF          0
+#define VG_HUD_TOP_LEFT     1
+#define VG_HUD_TOP_RIGHT    2
+#define VG_HUD_BOTTOM_LEFT  3
+#define VG_HUD_BOTTOM_RIGHT 4
+
+/* VALIDATION DEFINITIONS */
+#define VG_VALIDATE_HANDLE 1
+#define VG_VALIDATE_BOUNDS 2
+#define VG_VALIDATE_GL     3
+#define VG_VALIDATE_STATE  4
+
+/* TEXTURE FILTERS */
+#define VG_NEAREST        0
+#define VG_LINEAR         1
+#define VG_LINEAR_MIPMAP  2
+#define VG_NEAREST_MIPMAP 3
+
+/* TEXTURE FORMATS */
+#define VG_FORMAT_RGBA8    0
+#define VG_FORMAT_A8       1
+#define VG_FORMAT_RG8      2
+#define VG_FORMAT_RGB565   3
+#define VG_FORMAT_RGBA4444 4
+#define VG_FORMAT_RGB5A1   5
+#define VG_FORMAT_RGB8     6
+#define VG_FORMAT_BC1      7
+#define VG_FORMAT_BC3      8
 
 /* TYPEDEFS */
 typedef unsigned short vgTexture;
 typedef unsigned short vgShape;
+typedef unsigned short vgLargeImage;
+typedef unsigned short vgArchive;
+typedef void (*vgScreenshotCallback)(const char* file, int success,
+	void* user);
+typedef void (*vgValidateCallback)(int kind, const char* function,
+	const char* message, void* user);
+
+/* header of a shared frame export, frames follow at dataOffset */
+typedef struct vgSharedFrames
+{
+	char magic[4];
+	unsigned int version;
+	unsigned int width;
+	unsigned int height;
+	unsigned int stride;
+	unsigned int slots;
+	unsigned int slotSize;
+	unsigned int dataOffset;
+	volatile long closed;
+	volatile long long latest;
+	volatile long long sequence[VG_SHARED_SLOTS];
+} vgSharedFrames;
+
+/* start of a trace file, the rest is a stream of records */
+typedef struct vgTraceHeader
+{
+	char magic[4];
+	unsigned int version;
+	int windowW;
+	int windowH;
+	int resolutionW;
+	int resolutionH;
+	int renderFormat;
+	int linear;
+} vgTraceHeader;
+
+typedef struct vgTraceRecord
+{
+	unsigned short op;
+	unsigned short argCount;
+	unsigned int dataSize;
+} vgTraceRecord;
+
+typedef union vgTraceArg
+{
+	int i;
+	float f;
+} vgTraceArg;
 
 /* INIT AND TERMINATE FUNCTIONS */
+VAPI void vgInitRenderFormat(int format);
 VAPI void vgInit(int window_w, int window_h, int resolution_w,
 	int resolution_h, int linear);
 VAPI void vgTerminate(void);
@@ -73,6 +286,7 @@ VAPI int  vgGetRenderSkipState(void);
 /* CLEAR AND SWAP FUNCTIONS */
 VAPI void vgClear(void);
 VAPI void vgFill(int r, int g, int b);
+VAPI void vgFillRegion(int x, int y, int w, int h, int r, int g, int b);
 VAPI void vgSwap(void);
 
 /* BASIC DRAW FUNCTIONS */
@@ -94,15 +308,32 @@ VAPI void vgPointf(float x, float y);
 /* ADVANCED DRAW FUNCTIONS */
 VAPI vgTexture vgCreateTexture(int w, int h, int linear, int repeat,
 	void* data);
+VAPI vgTexture vgCreateTextureFormat(int w, int h, int linear, int repeat,
+	int format, void* data);
 VAPI void vgDestroyTexture(vgTexture tex);
+VAPI void vgUseTexturePool(int state);
+VAPI void vgTexturePoolClear(void);
+VAPI void vgUseCPUMipmaps(int state);
+VAPI void vgTextureLODBias(vgTexture tex, float bias);
+VAPI void vgRegenerateMipmaps(vgTexture tex);
+VAPI void vgBuildMipmapData(int w, int h, const void* src, void* dst);
+VAPI int  vgFormatSize(int format, int w, int h);
+VAPI void vgConvertTextureData(int w, int h, int format, const void* src,
+	void* dst);
 VAPI void vgUseTexture(vgTexture target);
 VAPI void vgTextureFilter(int r, int g, int b, int a);
 VAPI void vgTextureFilterReset(void);
 VAPI void vgRectTexture(int x, int y, int w, int h);
 VAPI void vgRectTextureOffset(int x, int y, int w, int h, float s, float t);
+VAPI vgTexture vgCreateTextureArray(int w, int h, int layers, int linear,
+	int repeat, void** data);
+VAPI void vgEditTextureLayer(vgTexture tex, int layer, void* data);
+VAPI void vgUseTextureLayer(int layer);
+VAPI void vgRectTextureLayer(int x, int y, int w, int h, int layer);
 VAPI vgShape vgCompileShape(float* f2d_data, int size);
 VAPI vgShape vgCompileShapeTextured(float* f2d_data, float* t2d_data,
 	int size);
+VAPI void vgDestroyShape(vgShape shape);
 VAPI void vgDrawShape(vgShape shape, float x, float y, float r, float s);
 VAPI void vgDrawShapeTextured(vgShape shape, float x, float y, float r,
 	float s);
@@ -135,6 +366,34 @@ VAPI void vgEditShapeTextured(vgShape shape, float x, float y, float r,
 VAPI void vgEditSetData(int width, int height, void* data);
 VAPI void vgEditClear(void);
 VAPI void* vgGetTextureData(vgTexture tex, int w, int h);
+VAPI int   vgReadPixels(vgTexture tex, int x, int y, int w, int h,
+	int format, void* dst, int stride);
+VAPI int   vgCopyTexture(vgTexture src, int sx, int sy, int w, int h,
+	vgTexture dst, int dx, int dy);
+VAPI int   vgBlitTexture(vgTexture src, int sx, int sy, int sw, int sh,
+	vgTexture dst, int dx, int dy, int dw, int dh, int linear);
+VAPI vgTexture vgDuplicateTexture(vgTexture tex);
+
+/* TEXTURE COMPRESSION FUNCTIONS */
+VAPI int  vgCompressionSupported(void);
+VAPI vgTexture vgCreateTextureCompressed(int w, int h, int linear,
+	int repeat, int format, void* blocks);
+VAPI void vgDecompressTextureData(int w, int h, int format, const void* src,
+	void* dst);
+
+/* LARGE IMAGE FUNCTIONS */
+/* file is raw RGBA8 texels. Coarser levels are box filtered into */
+/* file.pyr the first time it is opened and reused while file is unchanged, */
+/* the temp directory is used when file.pyr can't be written. The build */
+/* runs in the background, coarse levels are point sampled until it is */
+/* done. vgOpenLargeImagePyramid takes the sidecar path, NULL for none */
+VAPI vgLargeImage vgOpenLargeImage(const char* file, int w, int h,
+	int linear);
+VAPI vgLargeImage vgOpenLargeImagePyramid(const char* file, int w, int h,
+	int linear, const char* pyramid);
+VAPI void vgCloseLargeImage(vgLargeImage image);
+VAPI void vgDrawLargeImage(vgLargeImage image, float x, float y, float w,
+	float h);
 
 /* CURSOR RELATED FUNCTIONS */
 VAPI void vgGetCursorPos(int* x, int* y);
@@ -149,6 +408,129 @@ VAPI vgTexture vgLoadTexture(const char* file, int w, int h, int linear,
 	int repeat);
 VAPI void* vgLoadTextureData(const char* file, int w, int h);
 
+/* IMAGE IMPORT FUNCTIONS */
+VAPI vgTexture vgLoadImage(const char* file, int linear, int repeat);
+VAPI void* vgLoadImageData(const char* file, int* w, int* h);
+VAPI int   vgLoadImageBatch(const char** files, int count,
+	vgTexture* textures, int linear, int repeat);
+VAPI int   vgLoadImageDataBatch(const char** files, int count, void** data,
+	int* w, int* h);
+
+/* HOT RELOAD FUNCTIONS */
+VAPI void vgUseHotReload(int state);
+VAPI int  vgHotReloadCount(void);
+
+/* ARCHIVE FUNCTIONS */
+VAPI vgArchive vgOpenArchive(const char* file);
+VAPI void vgCloseArchive(vgArchive archive);
+VAPI int  vgArchiveContains(vgArchive archive, const char* name);
+VAPI vgTexture vgArchiveLoadTexture(vgArchive archive, const char* name,
+	int linear, int repeat);
+VAPI vgShape vgArchiveLoadShape(vgArchive archive, const char* name);
+VAPI const void* vgArchiveGetData(vgArchive archive, const char* name,
+	int* type, int* size);
+VAPI const char* vgArchiveGetRegion(vgArchive archive, const char* name,
+	int* x, int* y, int* w, int* h);
+VAPI int  vgArchiveBegin(const char* file);
+VAPI void vgArchiveAddTexture(const char* name, int w, int h, int format,
+	int levels, const void* data);
+VAPI void vgArchiveAddShape(const char* name, float* f2d_data,
+	float* t2d_data, int size);
+VAPI void vgArchiveAddRegion(const char* name, const char* atlas, int x,
+	int y, int w, int h);
+VAPI int  vgArchiveEnd(void);
+
+/* UPLOAD THREAD FUNCTIONS */
+/* while running, texture creation from threads other than the one that */
+/* called vgInit is queued, the handle is usable once vgTextureReady */
+VAPI void vgUseUploadThread(int state);
+VAPI int  vgTextureReady(vgTexture tex);
+VAPI int  vgUploadsPending(void);
+VAPI void vgFinishUploads(void);
+
+/* CAPTURE FUNCTIONS */
+/* RAW streams are headerless top-down RGB24. DELTA streams start with */
+/* "VGCD", version, width, height and tile size as 32 bit values, then */
+/* per frame a tile count and that many (16 bit x, 16 bit y, RGB24 rows) */
+/* tiles that changed since the previous frame, starting from black. */
+/* SHARED creates a named mapping laid out as vgSharedFrames and a */
+/* semaphore named "<file>.frame" released per frame. Frame n is RGBA8 */
+/* top-down in slot n % slots, valid while sequence[slot] stays n */
+VAPI int  vgStartCapture(const char* file, int format, int every, int fps);
+VAPI void vgStopCapture(void);
+VAPI int  vgCaptureFrames(void);
+VAPI int  vgCaptureDropped(void);
+
+/* SCREENSHOT FUNCTIONS */
+/* the render target is saved as a PNG in the background, the callback */
+/* runs from vgUpdate or vgSwap once the file is written or has failed */
+VAPI int  vgScreenshot(const char* file, vgScreenshotCallback callback,
+	void* user);
+VAPI int  vgScreenshotsPending(void);
+VAPI void vgFinishScreenshots(void);
+
+/* TRACE FUNCTIONS */
+/* every drawing, texture and shape call is appended to file until */
+/* vgStopTrace. Textures and shapes alive at the start are written out */
+/* first, followed by the current render state. */
+/* Loaders and archives show up as the textures they create, large */
+/* images and hot reloads are not traced. VGReplay plays a trace back */
+/* and times it */
+VAPI int  vgStartTrace(const char* file);
+VAPI void vgStopTrace(void);
+VAPI int  vgTraceCalls(void);
+
+/* PROFILE FUNCTIONS */
+/* zones nest per thread and are saved as Chrome trace event JSON along */
+/* with the library's own stages. Names are kept by pointer, so they have */
+/* to stay valid until vgSaveProfile. Each thread keeps its last */
+/* VG_PROFILE_EVENTS begins and ends */
+VAPI void vgUseProfiling(int state);
+VAPI void vgProfileBegin(const char* name);
+VAPI void vgProfileEnd(void);
+VAPI int  vgSaveProfile(const char* file);
+
+/* FRAME STATISTICS FUNCTIONS */
+/* every vgSwap that presents adds its frame time to a histogram, times */
+/* are in milliseconds and within 2% of the real value. With a hitch */
+/* threshold set, frames longer than it keep the calls made in the */
+/* frames around them, vgSaveHitches writes those out as text */
+VAPI float vgFrameTimePercentile(float percentile);
+VAPI float vgFrameTimeMax(void);
+VAPI unsigned long long vgFrameTimeCount(void);
+VAPI void  vgResetFrameTimes(void);
+VAPI void  vgHitchThreshold(float ms);
+VAPI int   vgHitchCount(void);
+VAPI int   vgSaveHitches(const char* file);
+
+/* OVERDRAW FUNCTIONS */
+/* counts how often each render target pixel is drawn to, clears and */
+/* blits are not counted. Totals are for the last presented frame, */
+/* VG_OVERDRAW_HEATMAP also presents the counts in place of the frame, */
+/* black for none through blue, green, yellow and red to white for 8+ */
+VAPI void vgUseOverdraw(int mode);
+VAPI unsigned long long vgOverdrawWrites(void);
+VAPI int  vgOverdrawMax(void);
+VAPI int  vgOverdrawPixels(int count);
+
+/* HUD FUNCTIONS */
+/* the HUD is drawn by vgSwap over the presented frame, it is not part */
+/* of captures or screenshots. Counts are for the last presented frame, */
+/* culled counts vgCheckIfViewable misses and large images out of view */
+VAPI void vgUseHud(int corner);
+VAPI int  vgDrawCallCount(void);
+VAPI int  vgTextureBindCount(void);
+VAPI int  vgCulledCount(void);
+VAPI unsigned long long vgTextureMemory(void);
+
+/* VALIDATION FUNCTIONS */
+/* builds with VG_VALIDATE defined check handles, bounds and misuse on */
+/* entry and GL errors between calls, a failed check skips the call. */
+/* Reports go to the callback, or the debugger output without one. */
+/* Without VG_VALIDATE the checks are not compiled in at all */
+VAPI void vgValidationCallback(vgValidateCallback callback, void* user);
+VAPI int  vgValidationEnabled(void);
+
 /* DEBUG FUNCTIONS */
 VAPI unsigned int _vgDebugGetTextureName(vgTexture texture);
 VAPI unsigned int _vgDebugGetShapeName(vgShape shape);